@@ -0,0 +1,126 @@
+/**
+ * This example measures the accept path under a connection storm.
+ *
+ * A TCP server runs at one thread, while the main thread connects
+ * in waves (as clients reconnecting after a failover), each client
+ * sending one byte. Prints the connections accepted per second.
+ *
+ * Options:
+ * * -d: TCP_DEFER_ACCEPT (only connections with data wake the server)
+ * * -b <backlog>: listen backlog (default SOCA_TCP_SERVER_BACKLOG)
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "error.hpp"
+#include "posix/endpoint_ipv4.hpp"
+#include "posix/tcp_server.hpp"
+#include "posix/tcp_client.hpp"
+
+using namespace Soca;
+
+using endpoint = POSIX::endpoint_ipv4;
+using tcp_server = POSIX::tcp_server<endpoint>;
+using tcp_client = POSIX::tcp_client<endpoint>;
+
+#define SERVER_ADDR		"127.0.0.1"
+#define SERVER_PORT		8081
+
+#define CONNECTIONS		10000
+#define WAVE			1000
+
+/**
+ * Auxiliary call
+ */
+static void exit_error(Error& ec, const char* what = "")
+{
+	std::printf("ERROR! [%d] %s [%s]\n", ec.value(), ec.message(), what);
+	std::exit(EXIT_FAILURE);
+}
+
+static std::atomic<unsigned> accepted{0};
+static std::atomic<bool> running{true};
+
+int main(int argc, char** argv)
+{
+	std::printf("Accept storm example init...\n");
+
+	int backlog = SOCA_TCP_SERVER_BACKLOG;
+	POSIX::socket_options options;
+	for(int i = 1; i < argc; i++)
+	{
+		if(std::strcmp(argv[i], "-d") == 0) options.defer_accept = 1;
+		else if(std::strcmp(argv[i], "-b") == 0 && i + 1 < argc) backlog = std::atoi(argv[++i]);
+	}
+
+	Error ec;
+	endpoint ep{SERVER_ADDR, SERVER_PORT, ec};
+	if(ec) exit_error(ec, "address");
+
+	tcp_server server;
+	server.options(options);
+	server.open(ep, backlog, ec);
+	if(ec) exit_error(ec, "open");
+
+	/**
+	 * Server loop: counts the connections, and closes them when the
+	 * client closes
+	 */
+	std::thread loop([&server]{
+		Error ecl;
+		auto read_cb = [&server](tcp_server::handler socket){
+			char buffer[64];
+			Error ecr;
+			server.receive(socket, buffer, sizeof(buffer), ecr);
+			return !ecr;
+		};
+		auto open_cb = [](tcp_server::handler){ accepted++; };
+		while(running && server.run<10>(ecl, read_cb, open_cb)){}
+		if(ecl) exit_error(ecl, "run");
+	});
+
+	std::vector<tcp_client> clients(WAVE);
+	unsigned connected = 0;
+	auto start = std::chrono::steady_clock::now();
+	while(connected < CONNECTIONS)
+	{
+		for(tcp_client& client : clients)
+		{
+			client.open(ep, ec);
+			if(ec) exit_error(ec, "connect");
+			client.send("x", 1, ec);
+			if(ec) exit_error(ec, "send");
+		}
+		connected += WAVE;
+
+		/**
+		 * Waits the wave to be accepted
+		 */
+		auto limit = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while(accepted < connected && std::chrono::steady_clock::now() < limit)
+			std::this_thread::yield();
+		if(accepted < connected)
+		{
+			std::printf("Connections not accepted: %u\n", connected - accepted);
+			break;
+		}
+
+		for(tcp_client& client : clients)
+			client.close();
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	running = false;
+	loop.join();
+
+	std::printf("Accepted: %u, %.0f connections/s%s\n",
+			accepted.load(), accepted / elapsed,
+			options.defer_accept > 0 ? " (TCP_DEFER_ACCEPT)" : "");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+/**
+ * This example compares the address parsing/formatting of posix/address.hpp
+ * with the libc calls (inet_pton/inet_ntop).
+ *
+ * It also shows a endpoint built from a address parsed at compile time.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+
+#include "posix/endpoint_ipv4.hpp"
+#include "posix/endpoint_ipv6.hpp"
+#include "posix/address.hpp"
+
+using namespace Soca;
+
+#define ITERATIONS		2000000
+
+/**
+ * Parsed at compile time
+ */
+static constexpr POSIX::ipv6_address server_addr = POSIX::parse_ipv6("2001:db8::1");
+static_assert(server_addr.valid, "invalid address");
+
+static const char* const addresses4[] = {
+	"127.0.0.1", "192.168.0.254", "10.1.20.3", "255.255.255.255", "8.8.4.4"
+};
+
+static const char* const addresses6[] = {
+	"::1", "2001:db8::ff00:42:8329", "fe80::1ff:fe23:4567:890a",
+	"2001:db8:85a3:0:0:8a2e:370:7334", "::ffff:192.168.0.1"
+};
+
+static constexpr const int count = 5;
+
+/**
+ * Runs func ITERATIONS times, returning ns per call
+ */
+template<typename Func>
+static double measure(Func&& func)
+{
+	auto start = std::chrono::steady_clock::now();
+	for(int i = 0; i < ITERATIONS; i++) func(i % count);
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / ITERATIONS;
+}
+
+/**
+ * Avoids the compiler to optimize out the results
+ */
+static volatile std::uint8_t sink;
+
+int main()
+{
+	char buffer[INET6_ADDRSTRLEN];
+
+	POSIX::endpoint_ipv6 ep{server_addr, 5683};
+	std::printf("compile time endpoint: [%s]:%u\n\n", ep.address(buffer), ep.port());
+
+	std::printf("%-22s %10s %10s\n", "", "libc (ns)", "soca (ns)");
+
+	double libc = measure([](int i){
+		std::uint8_t addr[4];
+		inet_pton(AF_INET, addresses4[i], addr);
+		sink = addr[3];
+	});
+	double soca = measure([](int i){
+		POSIX::ipv4_address addr = POSIX::parse_ipv4(addresses4[i]);
+		sink = addr.bytes[3];
+	});
+	std::printf("%-22s %10.1f %10.1f\n", "parse IPv4", libc, soca);
+
+	libc = measure([](int i){
+		std::uint8_t addr[16];
+		inet_pton(AF_INET6, addresses6[i], addr);
+		sink = addr[15];
+	});
+	soca = measure([](int i){
+		POSIX::ipv6_address addr = POSIX::parse_ipv6(addresses6[i]);
+		sink = addr.bytes[15];
+	});
+	std::printf("%-22s %10.1f %10.1f\n", "parse IPv6", libc, soca);
+
+	POSIX::ipv4_address parsed4[count];
+	POSIX::ipv6_address parsed6[count];
+	for(int i = 0; i < count; i++)
+	{
+		parsed4[i] = POSIX::parse_ipv4(addresses4[i]);
+		parsed6[i] = POSIX::parse_ipv6(addresses6[i]);
+	}
+
+	libc = measure([&](int i){
+		char str[INET_ADDRSTRLEN];
+		inet_ntop(AF_INET, parsed4[i].bytes, str, sizeof(str));
+		sink = str[0];
+	});
+	soca = measure([&](int i){
+		char str[INET_ADDRSTRLEN];
+		POSIX::format_ipv4(parsed4[i], str, sizeof(str));
+		sink = str[0];
+	});
+	std::printf("%-22s %10.1f %10.1f\n", "format IPv4", libc, soca);
+
+	libc = measure([&](int i){
+		char str[INET6_ADDRSTRLEN];
+		inet_ntop(AF_INET6, parsed6[i].bytes, str, sizeof(str));
+		sink = str[0];
+	});
+	soca = measure([&](int i){
+		char str[INET6_ADDRSTRLEN];
+		POSIX::format_ipv6(parsed6[i], str, sizeof(str));
+		sink = str[0];
+	});
+	std::printf("%-22s %10.1f %10.1f\n", "format IPv6", libc, soca);
+
+	/**
+	 * Checking the results are the same
+	 */
+	for(int i = 0; i < count; i++)
+	{
+		char l[INET6_ADDRSTRLEN], s[INET6_ADDRSTRLEN];
+		inet_ntop(AF_INET6, parsed6[i].bytes, l, sizeof(l));
+		POSIX::format_ipv6(parsed6[i], s, sizeof(s));
+		if(std::strcmp(l, s) != 0)
+			std::printf("Different: %s %s\n", l, s);
+	}
+
+	return EXIT_SUCCESS;
+}
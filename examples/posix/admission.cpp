@@ -0,0 +1,93 @@
+/**
+ * This example shows the admission control of a TCP server.
+ *
+ * Echo TCP server limited to 100 connections (at most 8 of the same IP),
+ * accepting up to 50 connections/s and reading up to 64KB/s of each
+ * connection. Prints each second the connections, the paused and
+ * the queueing delay (what a load balancer would be told).
+ *
+ * \note After running this example, run tcp_client to make the requests
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+
+#include "error.hpp"
+#include "posix/endpoint_ipv6.hpp"
+#include "posix/tcp_server.hpp"
+#include "posix/admission.hpp"
+
+using namespace Soca;
+
+using endpoint = POSIX::endpoint_ipv6;
+using tcp_server = POSIX::tcp_server<endpoint>;
+using admission = POSIX::admission_control<tcp_server>;
+
+#define BUFFER_LEN		1000
+
+/**
+ * Auxiliary call
+ */
+static void exit_error(Error& ec, const char* what = "")
+{
+	std::printf("ERROR! [%d] %s [%s]\n", ec.value(), ec.message(), what);
+	std::exit(EXIT_FAILURE);
+}
+
+int main()
+{
+	std::printf("Admission control example init...\n");
+
+	Error ec;
+	tcp_server conn;
+	tcp_server::endpoint ep{IN6ADDR_ANY_INIT, 8080};
+	conn.open(ep, ec);
+	if(ec) exit_error(ec, "open");
+
+	admission::config cfg;
+	cfg.max_connections = 100;
+	cfg.max_per_source = 8;
+	cfg.accept_rate = 50;
+	cfg.accept_burst = 10;
+	cfg.read_rate = 64 * 1024;
+	admission control{conn, cfg};
+
+	auto read_cb = [&](tcp_server::handler socket){
+		char buffer[BUFFER_LEN];
+		Error ecr;
+		std::size_t size = control.receive(socket, buffer, BUFFER_LEN, ecr);
+		if(ecr) return false;
+		if(size) conn.send(socket, buffer, size, ecr);
+		return true;
+	};
+	auto open_cb = [&](tcp_server::handler socket){
+		if(!control.admit(socket))
+			std::printf("[%d] refused\n", socket);
+	};
+	auto close_cb = [&](tcp_server::handler socket){ control.release(socket); };
+
+	auto report = std::chrono::steady_clock::now();
+	/**
+	 * Short block time: process() resumes the paused connections.
+	 * When the application falls behind (e.g. a worker queue too long),
+	 * control.overload(true) stops reading until it catches up.
+	 */
+	while(conn.run<10>(ec, read_cb, open_cb, close_cb))
+	{
+		control.process();
+
+		auto now = std::chrono::steady_clock::now();
+		if(now - report < std::chrono::seconds(1)) continue;
+		report = now;
+		std::printf("connections: %zu paused: %zu refused: %llu backlog: %zu delay: %lluus\n",
+				control.connections(), control.paused(),
+				static_cast<unsigned long long>(control.rejected()),
+				control.accept_queue(),
+				static_cast<unsigned long long>(control.queue_delay_ns() / 1000));
+	}
+
+	if(ec) exit_error(ec, "run");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,114 @@
+/**
+ * This examples shows the use of the TCP server with C++20 coroutines.
+ *
+ * We are going to implement a simple server that will wait request from clients
+ * and echo the payload received back, as the tcp_server example, but written
+ * as straight-line code.
+ *
+ * \note Must be compiled with SOCA_USE_COROUTINE=1 (C++20)
+ * \note After running this example, run tcp_client to make the requests
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+
+#include "error.hpp"
+#include "posix/tcp_server.hpp"
+#include "posix/endpoint_ipv6.hpp"
+
+using namespace Soca;
+
+using endpoint = POSIX::endpoint_ipv6;
+using tcp_server = POSIX::tcp_server<endpoint>;
+
+/**
+ * Auxiliary call
+ */
+static void exit_error(Error& ec, const char* what = "")
+{
+	printf("ERROR! [%d] %s [%s]\n", ec.value(), ec.message(), what);
+	exit(EXIT_FAILURE);
+}
+
+#define BUFFER_LEN		1000
+
+/**
+ * Connection coroutine. Each connection runs its own.
+ */
+POSIX::task echo(POSIX::executor& exec, tcp_server& server, tcp_server::handler socket) noexcept
+{
+	char buffer[BUFFER_LEN];
+	while(true)
+	{
+		Error ec;
+		/**
+		 * Suspends until data arrives
+		 */
+		std::size_t size = co_await server.async_receive(exec, socket, buffer, BUFFER_LEN, ec);
+		if(ec) break;
+
+		printf(">[%d][%zu]: %.*s\n", socket, size, static_cast<int>(size), buffer);
+
+		/**
+		 * Echoing data received back. Suspends until all data is sent
+		 */
+		co_await server.async_send(exec, socket, buffer, size, ec);
+		if(ec) break;
+	}
+	printf("Closed socket [%d]\n", socket);
+	exec.remove(socket);
+	server.close_client(socket);
+}
+
+/**
+ * Accept coroutine
+ */
+POSIX::task listen(POSIX::executor& exec, tcp_server& server) noexcept
+{
+	while(true)
+	{
+		Error ec;
+		tcp_server::handler socket = co_await server.async_accept(exec, ec);
+		if(ec) exit_error(ec, "accept");
+
+		printf("Opened socket [%d]\n", socket);
+		echo(exec, server, socket);
+	}
+}
+
+int main()
+{
+	std::printf("Coroutine echo TCP server init...\n");
+
+	POSIX::init();
+
+	Error ec;
+
+	/**
+	 * The executor resumes the coroutines when the sockets are ready
+	 */
+	POSIX::executor exec;
+	exec.open(ec);
+	if(ec) exit_error(ec, "executor");
+
+	tcp_server server;
+	tcp_server::endpoint ep{IN6ADDR_ANY_INIT, 8080};
+	server.open(ep, ec);
+	if(ec) exit_error(ec, "open");
+
+	char addr_str[46];
+	std::printf("Listening: [%s]:%u\n", ep.address(addr_str), ep.port());
+
+	listen(exec, server);
+
+	while(exec.run<-1>(ec))
+	{
+		/**
+		 * Your code
+		 */
+	}
+
+	if(ec) exit_error(ec, "run");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+/**
+ * This example shows the graceful drain and hot restart of a TCP server.
+ *
+ * Echo TCP server that listens for its successor at a Unix socket. Run
+ * it, and run it again: the new process connects to the old one, that
+ * passes its listening socket and idle connections (SCM_RIGHTS). The old
+ * process then drains the connections left (up to 5 seconds) and exits,
+ * while the new one keeps serving: no connection is refused or lost.
+ *
+ * \note Run tcp_client to make the requests
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include <chrono>
+
+#include "error.hpp"
+#include "posix/endpoint_ipv6.hpp"
+#include "posix/endpoint_unix.hpp"
+#include "posix/tcp_server.hpp"
+#include "posix/tcp_client.hpp"
+#include "posix/handoff.hpp"
+#include "posix/drain.hpp"
+
+using namespace Soca;
+
+using endpoint = POSIX::endpoint_ipv6;
+using tcp_server = POSIX::tcp_server<endpoint>;
+/* blocking: the handoff is sent at once */
+using control_server = POSIX::tcp_server<POSIX::endpoint_unix, 0>;
+using control_client = POSIX::tcp_client<POSIX::endpoint_unix, 0>;
+
+#define CONTROL_PATH	"/tmp/soca_hot_restart.sock"
+#define BUFFER_LEN		1000
+#define DRAIN_MS		5000
+
+/**
+ * Auxiliary call
+ */
+static void exit_error(Error& ec, const char* what = "")
+{
+	std::printf("ERROR! [%d] %s [%s]\n", ec.value(), ec.message(), what);
+	std::exit(EXIT_FAILURE);
+}
+
+/**
+ * Receives the sockets of the running process, if any. Returns false
+ * if there is no process running.
+ */
+static bool take_over(tcp_server& conn, POSIX::connection_drain<tcp_server>& drain)
+{
+	Error ec;
+	POSIX::endpoint_unix ctl_ep{CONTROL_PATH, ec};
+	control_client ctl;
+	ctl.open(ctl_ep, ec);
+	if(ec) return false;
+
+	POSIX::handoff_kind kind;
+	unsigned connections = 0;
+	int fd;
+	while((fd = POSIX::handoff_receive(ctl.native(), kind, ec)) != -1)
+	{
+		if(kind == POSIX::handoff_kind::listener)
+		{
+			conn.assign(fd, ec);
+			if(ec) exit_error(ec, "assign");
+			continue;
+		}
+		/* listener comes first */
+		conn.adopt(fd, ec);
+		if(ec) exit_error(ec, "adopt");
+		drain.add(fd, ec);
+		if(ec) exit_error(ec, "drain add");
+		connections++;
+	}
+	if(ec) exit_error(ec, "handoff");
+	if(!conn.is_open())
+	{
+		std::printf("No listener received\n");
+		std::exit(EXIT_FAILURE);
+	}
+	std::printf("Took over the listener and %u connections\n", connections);
+	return true;
+}
+
+int main()
+{
+	std::printf("Hot restart example init...\n");
+
+	Error ec;
+	tcp_server conn;
+	POSIX::connection_drain<tcp_server> drain{conn};
+	if(!take_over(conn, drain))
+	{
+		tcp_server::endpoint ep{IN6ADDR_ANY_INIT, 8080};
+		conn.open(ep, ec);
+		if(ec) exit_error(ec, "open");
+	}
+
+	auto read_cb = [&conn](tcp_server::handler socket){
+		char buffer[BUFFER_LEN];
+		Error ecr;
+		std::size_t size = conn.receive(socket, buffer, BUFFER_LEN, ecr);
+		if(ecr) return false;
+		if(size) conn.send(socket, buffer, size, ecr);
+		return true;
+	};
+	/* not tracked: it could not be drained */
+	auto open_cb = [&conn, &drain](tcp_server::handler socket){
+		Error eca;
+		if(!drain.add(socket, eca)) conn.close_client(socket);
+	};
+	auto close_cb = [&drain](tcp_server::handler socket){ drain.remove(socket); };
+
+	/**
+	 * Control socket: a successor connecting takes over
+	 */
+	control_server ctl;
+	bool successor = false;
+	auto ctl_open_cb = [&](control_server::handler socket){
+		Error ech;
+		if(!POSIX::handoff_send(socket, POSIX::handoff_kind::listener, conn.native()))
+		{
+			std::printf("Handoff failed\n");
+			ctl.close_client(socket);
+			return;
+		}
+		std::size_t passed = drain.hand_off(socket, ech);
+		POSIX::handoff_end(socket);
+		ctl.close_client(socket);
+		std::printf("Passed the listener and %zu connections, draining %zu...\n",
+				passed, drain.size());
+		successor = true;
+	};
+	auto ctl_read_cb = [](control_server::handler){ return false; };
+
+	while(!successor)
+	{
+		/* the previous process may still be releasing the path */
+		if(!ctl.is_open())
+		{
+			POSIX::endpoint_unix ctl_ep{CONTROL_PATH, ec};
+			ctl_ep.unlink();
+			Error eco;
+			ctl.open(ctl_ep, eco);
+			if(eco) ctl.close();
+		}
+
+		if(!conn.run<10>(ec, read_cb, open_cb, close_cb)) exit_error(ec, "run");
+		if(ctl.is_open() && !ctl.run<0>(ec, ctl_read_cb, ctl_open_cb))
+			exit_error(ec, "control");
+	}
+
+	/**
+	 * Drain: stops accepting (the successor accepts), and closes
+	 * the connections left
+	 */
+	ctl.close();
+	drain.start(DRAIN_MS, ec);
+	if(ec) exit_error(ec, "drain");
+	while(!drain.process(close_cb))
+	{
+		if(!conn.run<10>(ec, read_cb, open_cb, close_cb)) exit_error(ec, "run");
+	}
+	conn.close();
+
+	std::printf("Drained\n");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+/**
+ * This example shows the pipelined TCP client.
+ *
+ * Keeps up to 64 requests in flight over one connection, instead of
+ * waiting each response (one request per round trip). The server echoes
+ * the requests, so each response has the same framing (and id) of its
+ * request.
+ *
+ * \note Before running this example, run tcp_server to open a server TCP socket
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+
+#include <poll.h>
+
+#include "error.hpp"
+#include "posix/endpoint_ipv6.hpp"
+#include "posix/pipelined_client.hpp"
+
+using namespace Soca;
+
+#define LOCALHOST_ADDR		"::1"
+#define CONN_PORT			8080
+
+#define REQUESTS			10000
+
+/**
+ * Auxiliary call
+ */
+static void exit_error(Error& ec, const char* what = "")
+{
+	std::printf("ERROR! [%d] %s [%s]\n", ec.value(), ec.message(), what);
+	std::exit(EXIT_FAILURE);
+}
+
+using client = POSIX::pipelined_client<POSIX::endpoint_ipv6>;
+
+static unsigned responses = 0;
+
+static void on_response(std::uint32_t id, const void* data, std::size_t size,
+		Error const& ec, void*)
+{
+	if(ec)
+	{
+		std::printf("Request %u failed: %s\n", id, ec.message());
+		return;
+	}
+	responses++;
+}
+
+int main()
+{
+	std::printf("Pipelined TCP client example init...\n");
+
+	Error ec;
+	POSIX::endpoint_ipv6 to{LOCALHOST_ADDR, CONN_PORT, ec};
+	if(ec) exit_error(ec, "address");
+
+	client conn;
+	conn.open(to, ec);
+	if(ec) exit_error(ec, "open");
+
+	const char payload[] = "teste";
+	unsigned sent = 0;
+	auto start = std::chrono::steady_clock::now();
+	while(responses < REQUESTS)
+	{
+		/**
+		 * Fills the in-flight table; all written with few send calls
+		 */
+		while(sent < REQUESTS && conn.in_flight() < client::capacity())
+		{
+			if(conn.request(payload, std::strlen(payload), on_response, nullptr, ec)
+				== client::invalid_id)
+				exit_error(ec, "request");
+			sent++;
+		}
+		conn.flush(ec);
+		if(ec) exit_error(ec, "flush");
+
+		pollfd pfd{conn.native(), static_cast<short>(POLLIN | (conn.want_write() ? POLLOUT : 0)), 0};
+		if(::poll(&pfd, 1, 1000) <= 0)
+		{
+			std::printf("Timeout waiting responses\n");
+			return EXIT_FAILURE;
+		}
+
+		/**
+		 * Responses complete in any order
+		 */
+		if(pfd.revents & (POLLIN | POLLHUP | POLLERR))
+		{
+			conn.process(ec);
+			if(ec) exit_error(ec, "process");
+		}
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::printf("Responses: %u, %.0f requests/s\n", responses, responses / elapsed);
+	conn.close();
+
+	return EXIT_SUCCESS;
+}
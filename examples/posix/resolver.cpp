@@ -0,0 +1,140 @@
+/**
+ * This example shows the non-blocking DNS resolver.
+ *
+ * Resolves the names of the command line (IPv6 and IPv4), waiting the
+ * answers at a poll loop. Each name is resolved a second time, answered
+ * from the cache (or the hosts file).
+ *
+ * Usage: resolver [-s <server address>] [-p <server port>] name...
+ *
+ * The server defaults to the /etc/resolv.conf nameserver. Any DNS server
+ * can be used, e.g. a local stand-in: -s 127.0.0.1 -p 5353
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#include <poll.h>
+
+#include "error.hpp"
+#include "posix/resolver.hpp"
+
+using namespace Soca;
+
+/**
+ * Port of the addresses resolved
+ */
+#define CONN_PORT		8080
+
+/**
+ * Auxiliary call
+ */
+static void exit_error(Error& ec, const char* what = "")
+{
+	std::printf("ERROR! [%d] %s [%s]\n", ec.value(), ec.message(), what);
+	std::exit(EXIT_FAILURE);
+}
+
+static void print_result(const char* name, POSIX::resolve_result const& result,
+		Error const& ec, void* user)
+{
+	const char* what = static_cast<const char*>(user);
+	if(ec)
+	{
+		std::printf("[%s] %s: error %s\n", what, name, ec.message());
+		return;
+	}
+
+	std::printf("[%s] %s:", what, name);
+	char addr[INET6_ADDRSTRLEN];
+	for(std::size_t i = 0; i < result.count; i++)
+		std::printf(" %s", result.addresses[i].address(addr));
+	std::printf("\n");
+}
+
+/**
+ * Loop: process the answers and check the timeouts
+ */
+static void wait_answers(POSIX::resolver& resolver)
+{
+	Error ec;
+	while(resolver.pending())
+	{
+		pollfd pfd{resolver.native(), POLLIN, 0};
+		if(::poll(&pfd, 1, resolver.next_timeout()) > 0)
+		{
+			resolver.process(ec);
+			if(ec) exit_error(ec, "process");
+		}
+		resolver.check();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const char* server_addr = nullptr;
+	std::uint16_t server_port = 53;
+	int first = 1;
+	for(; first < argc - 1; first += 2)
+	{
+		if(std::strcmp(argv[first], "-s") == 0) server_addr = argv[first + 1];
+		else if(std::strcmp(argv[first], "-p") == 0)
+			server_port = static_cast<std::uint16_t>(std::atoi(argv[first + 1]));
+		else break;
+	}
+	if(first >= argc)
+	{
+		std::printf("Usage: %s [-s <server address>] [-p <server port>] name...\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	Error ec;
+	POSIX::resolver resolver;
+
+	if(server_addr)
+	{
+		POSIX::endpoint_ip server{server_addr, server_port, ec};
+		if(ec) exit_error(ec, "server address");
+		resolver.open(server, ec);
+	}
+	else resolver.open(ec);
+	if(ec) exit_error(ec, "open");
+
+	/**
+	 * Names at /etc/hosts are answered without query
+	 */
+	resolver.load_hosts();
+
+	char addr[INET6_ADDRSTRLEN];
+	std::printf("Resolving using %s:%u\n",
+			resolver.server().address(addr), resolver.server().port());
+
+	/**
+	 * Requests of the same name in flight share the query
+	 */
+	for(int i = first; i < argc; i++)
+	{
+		if(resolver.resolve(argv[i], CONN_PORT, AF_UNSPEC,
+				print_result, const_cast<char*>("query"), ec))
+			continue;
+		if(ec) exit_error(ec, "resolve");
+	}
+
+	wait_answers(resolver);
+
+	/**
+	 * Again: answered from the cache, at the call (if the TTL did not expire)
+	 */
+	for(int i = first; i < argc; i++)
+	{
+		if(resolver.resolve(argv[i], CONN_PORT, AF_UNSPEC,
+				print_result, const_cast<char*>("cache"), ec))
+			continue;
+		if(ec) exit_error(ec, "resolve");
+	}
+	wait_answers(resolver);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+/**
+ * This example shows the TCP client connection pool.
+ *
+ * Makes a series of requests to the server, each one leasing a connection
+ * from the pool: only the first request (and the pre-warmed connections)
+ * pays the connect.
+ *
+ * \note Before running this example, run tcp_server to open a server TCP socket
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#include "error.hpp"
+#include "posix/endpoint_ipv6.hpp"
+#include "posix/tcp_client_pool.hpp"
+
+using namespace Soca;
+
+#define LOCALHOST_ADDR		"::1"
+#define CONN_PORT			8080
+
+#define REQUESTS			100
+#define BUFFER_LEN			1000
+
+/**
+ * Auxiliary call
+ */
+static void exit_error(Error& ec, const char* what = "")
+{
+	std::printf("ERROR! [%d] %s [%s]\n", ec.value(), ec.message(), what);
+	std::exit(EXIT_FAILURE);
+}
+
+using pool_type = POSIX::tcp_client_pool<POSIX::endpoint_ipv6>;
+
+int main()
+{
+	std::printf("TCP client pool example init...\n");
+
+	Error ec;
+	POSIX::endpoint_ipv6 to{LOCALHOST_ADDR, CONN_PORT, ec};
+	if(ec) exit_error(ec, "address");
+
+	/**
+	 * Pool limits
+	 */
+	pool_type::config config;
+	config.max_per_destination = 4;
+	config.max_idle = 2;
+	config.idle_timeout_ms = 30000;
+
+	pool_type pool{config};
+	pool.open(ec);
+	if(ec) exit_error(ec, "open");
+
+	/**
+	 * Connects before the first request
+	 */
+	std::size_t warm = pool.prewarm(to, 2, ec);
+	if(ec) exit_error(ec, "prewarm");
+	std::printf("Pre-warmed connections: %zu\n", warm);
+
+	unsigned reused = 0;
+	std::uint8_t buffer[BUFFER_LEN];
+	for(int i = 0; i < REQUESTS; i++)
+	{
+		/**
+		 * The lease returns the connection to the pool when destroyed
+		 */
+		pool_type::lease conn = pool.checkout(to, ec);
+		if(ec) exit_error(ec, "checkout");
+		if(conn.reused()) reused++;
+
+		conn->send("teste", std::strlen("teste"), ec);
+		if(ec)
+		{
+			/**
+			 * Closed by the server: not returned to the pool
+			 */
+			conn.discard();
+			exit_error(ec, "send");
+		}
+
+		std::size_t size = conn->receive<-1>(buffer, BUFFER_LEN, ec);
+		if(ec || size == 0)
+		{
+			conn.discard();
+			exit_error(ec, "receive");
+		}
+
+		/**
+		 * Closes the idle connections dead or expired
+		 */
+		pool.reap();
+	}
+
+	std::printf("Requests: %d, connections reused: %u, open: %zu\n",
+			REQUESTS, reused, pool.size());
+
+	return EXIT_SUCCESS;
+}
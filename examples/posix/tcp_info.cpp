@@ -0,0 +1,84 @@
+/**
+ * This example shows the TCP_INFO sampler.
+ *
+ * Echo TCP server that samples its connections (RTT, retransmits, cwnd,
+ * delivery rate and send queue) while serving them, a few each loop
+ * iteration, and prints the samples.
+ *
+ * \note After running this example, run tcp_client to make the requests
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+
+#include "error.hpp"
+#include "posix/endpoint_ipv6.hpp"
+#include "posix/tcp_server.hpp"
+#include "posix/tcp_info_sampler.hpp"
+
+using namespace Soca;
+
+using endpoint = POSIX::endpoint_ipv6;
+using tcp_server = POSIX::tcp_server<endpoint>;
+
+#define BUFFER_LEN		1000
+
+/**
+ * Auxiliary call
+ */
+static void exit_error(Error& ec, const char* what = "")
+{
+	std::printf("ERROR! [%d] %s [%s]\n", ec.value(), ec.message(), what);
+	std::exit(EXIT_FAILURE);
+}
+
+/**
+ * Each connection sampled once a second
+ */
+static POSIX::tcp_info_sampler sampler{1000};
+
+int main()
+{
+	std::printf("TCP_INFO sampler example init...\n");
+
+	Error ec;
+	tcp_server conn;
+	tcp_server::endpoint ep{IN6ADDR_ANY_INIT, 8080};
+	conn.open(ep, ec);
+	if(ec) exit_error(ec, "open");
+
+	auto read_cb = [&conn](tcp_server::handler socket){
+		char buffer[BUFFER_LEN];
+		Error ecr;
+		std::size_t size = conn.receive(socket, buffer, BUFFER_LEN, ecr);
+		if(ecr) return;
+		conn.send(socket, buffer, size, ecr);
+	};
+	auto open_cb = [](tcp_server::handler socket){
+		Error eca;
+		sampler.add(socket, eca);
+	};
+	auto close_cb = [](tcp_server::handler socket){ sampler.remove(socket); };
+
+	while(conn.run<100>(ec, read_cb, open_cb, close_cb))
+	{
+		/**
+		 * At most 8 connections read by iteration
+		 */
+		if(sampler.sample(8) == 0) continue;
+
+		sampler.for_each([](tcp_server::handler socket, POSIX::tcp_stats const& stats){
+			if(!stats.sampled_ns) return;
+			std::printf("[%d] rtt: %uus (var %uus) cwnd: %u retransmits: %u "
+					"delivery: %llu B/s not sent: %uB\n",
+					socket, stats.rtt_us, stats.rtt_var_us, stats.cwnd,
+					stats.retransmits,
+					static_cast<unsigned long long>(stats.delivery_rate),
+					stats.notsent_bytes);
+		});
+	}
+
+	if(ec) exit_error(ec, "run");
+	return EXIT_SUCCESS;
+}
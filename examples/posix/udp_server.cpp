@@ -7,6 +7,9 @@
  *
  * This example is implemented using IPv4 and IPv6.
  *
+ * The socket is bound to all addresses: the replies leave from the local
+ * address the request came (packet info), at hosts with many addresses.
+ *
  * \note After running this example, run udp_client to make the requests
  */
 
@@ -16,6 +19,7 @@
 
 #include "error.hpp"
 #include "posix/udp_socket.hpp"
+#include "posix/address.hpp"
 
 /**
  * Using IPv6. Commenting the following line to use IPv4
@@ -82,20 +86,34 @@ int main()
 	conn.bind(ep, ec);
 	if(ec) exit_error(ec, "bind");
 
+	/**
+	 * Local address and interface of each datagram
+	 */
+	conn.pktinfo(ec);
+	if(ec) exit_error(ec, "pktinfo");
+
 	char addr_str[46];
 	std::printf("Listening: [%s]:%u\n", ep.address(addr_str), ep.port());
 	while(true)
 	{
 		udp_socket::endpoint recv_addr;
-		std::size_t size = conn.receive(buffer, BUFFER_LEN, recv_addr, ec);
+		POSIX::packet_info info;
+		std::size_t size = conn.receive(buffer, BUFFER_LEN, recv_addr, info, ec);
 		if(ec) exit_error(ec, "read");
 		if(size == 0) continue;
 		buffer[size] = '\0';
 
-		char addr_str2[46];
-		std::printf("Received [%s]:%u [%zu]: %s\n", recv_addr.address(addr_str2), recv_addr.port(), size, buffer);
+		char addr_str2[46], local_str[POSIX::ipv6_str_size] = "?";
+		if(info.family == AF_INET)
+			POSIX::format_ipv4(reinterpret_cast<std::uint8_t const*>(&info.address),
+					local_str, sizeof(local_str));
+		else if(info.family == AF_INET6)
+			POSIX::format_ipv6(info.address6.s6_addr, local_str, sizeof(local_str));
+		std::printf("Received [%s]:%u at [%s] (interface %u) [%zu]: %s\n",
+				recv_addr.address(addr_str2), recv_addr.port(),
+				local_str, info.interface, size, buffer);
 		std::printf("Echoing...\n");
-		conn.send(buffer, size, recv_addr, ec);
+		conn.send(buffer, size, recv_addr, info, ec);
 		if(ec) exit_error(ec, "write");
 	}
 
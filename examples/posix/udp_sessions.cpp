@@ -0,0 +1,90 @@
+/**
+ * This example shows the UDP session server.
+ *
+ * Echo UDP server that keeps a state per peer (datagrams received),
+ * prints each session opened and evicted (10 seconds idle), and echoes
+ * the datagrams prefixed by the datagram count of the peer. Peers sending
+ * 1000 datagrams per second or more get a connected socket of its own
+ * (pinned).
+ *
+ * \note After running this example, run udp_client to make the requests
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+
+#include "error.hpp"
+#include "posix/endpoint_ipv4.hpp"
+#include "posix/udp_session_server.hpp"
+
+using namespace Soca;
+
+using endpoint = POSIX::endpoint_ipv4;
+
+/**
+ * State of each peer
+ */
+struct peer_state{
+	unsigned	datagrams = 0;
+};
+
+using server = POSIX::udp_session_server<endpoint, peer_state>;
+
+#define BUFFER_LEN		1000
+
+/**
+ * Auxiliary call
+ */
+static void exit_error(Error& ec, const char* what = "")
+{
+	std::printf("ERROR! [%d] %s [%s]\n", ec.value(), ec.message(), what);
+	std::exit(EXIT_FAILURE);
+}
+
+int main()
+{
+	std::printf("UDP sessions example init...\n");
+
+	server::config cfg;
+	cfg.idle_timeout_ms = 10000;
+	cfg.pin_rate = 1000;
+	server conn{cfg};
+
+	Error ec;
+	endpoint ep{INADDR_ANY, 8080};
+	conn.open(ep, ec);
+	if(ec) exit_error(ec, "open");
+
+	/**
+	 * Called once per session with its datagrams of the batch
+	 */
+	auto data_cb = [&conn](server::session& s, POSIX::datagram const* dgs, std::size_t count){
+		for(std::size_t i = 0; i < count; i++)
+		{
+			char buffer[BUFFER_LEN];
+			int len = std::snprintf(buffer, BUFFER_LEN, "[%u] %.*s",
+					++s.state.datagrams,
+					static_cast<int>(dgs[i].size), static_cast<const char*>(dgs[i].data));
+			if(len > BUFFER_LEN - 1) len = BUFFER_LEN - 1;
+
+			Error ecs;
+			conn.send(s, buffer, static_cast<std::size_t>(len), ecs);
+		}
+	};
+	auto open_cb = [](server::session& s){
+		char addr_str[46];
+		std::printf("Session opened: %s:%u\n", s.peer.address(addr_str), s.peer.port());
+	};
+	auto close_cb = [&conn](server::session& s){
+		char addr_str[46];
+		std::printf("Session evicted: %s:%u (%u datagrams%s)\n",
+				s.peer.address(addr_str), s.peer.port(), s.state.datagrams,
+				conn.pinned(s) ? ", pinned" : "");
+	};
+
+	while(conn.run<100>(ec, data_cb, open_cb, close_cb));
+
+	if(ec) exit_error(ec, "run");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+#include "buffer_pool.hpp"
+
+#include <mutex>
+#include <new>
+
+namespace Soca{
+namespace buffer_pool{
+
+/**
+ * Blocks shared by all threads. Accessed only when a thread cache is
+ * empty (refill) or full (flush), moving half cache at a time.
+ */
+struct central_list{
+	std::mutex		mtx;
+	buffer_block*	head = nullptr;
+};
+
+static central_list central[size_class_count];
+static std::atomic<std::size_t> slab_count{0};
+
+/**
+ * Set when the thread cache is destroyed (thread exit): blocks released
+ * later (e.g. by other thread_local destructors) go to the central list.
+ * Trivially destructible, so still valid then.
+ */
+static thread_local bool cache_destroyed = false;
+
+struct thread_cache{
+	buffer_block*	blocks[size_class_count][SOCA_BUFFER_POOL_CACHE_SIZE];
+	unsigned		count[size_class_count] = {};
+
+	~thread_cache()
+	{
+		for(unsigned c = 0; c < size_class_count; c++)
+			flush(c, count[c]);
+		cache_destroyed = true;
+	}
+
+	void flush(unsigned c, unsigned n) noexcept
+	{
+		if(n == 0) return;
+		std::lock_guard<std::mutex> lock(central[c].mtx);
+		while(n--)
+		{
+			buffer_block* b = blocks[c][--count[c]];
+			b->next = central[c].head;
+			central[c].head = b;
+		}
+	}
+};
+
+static thread_local thread_cache cache;
+
+static std::size_t block_stride(unsigned c) noexcept
+{
+	return sizeof(buffer_block) + size_classes[c];
+}
+
+static unsigned class_of(std::size_t size) noexcept
+{
+	unsigned c = 0;
+	while(size_classes[c] < size) c++;
+	return c;
+}
+
+/**
+ * Carves a new slab at the central list. Must be called with the
+ * central lock held.
+ */
+static bool grow(unsigned c) noexcept
+{
+	std::size_t stride = block_stride(c);
+	std::size_t n = SOCA_BUFFER_POOL_SLAB_SIZE / stride;
+	if(n == 0) n = 1;
+
+	std::uint8_t* slab = static_cast<std::uint8_t*>(
+			::operator new(n * stride, std::align_val_t{alignof(buffer_block)}, std::nothrow));
+	if(!slab) return false;
+	slab_count.fetch_add(1, std::memory_order_relaxed);
+
+	for(std::size_t i = 0; i < n; i++)
+	{
+		buffer_block* b = new (slab + i * stride) buffer_block;
+		b->size_class = static_cast<std::uint8_t>(c);
+		b->next = central[c].head;
+		central[c].head = b;
+	}
+	return true;
+}
+
+static bool refill(unsigned c) noexcept
+{
+	std::lock_guard<std::mutex> lock(central[c].mtx);
+	unsigned n = SOCA_BUFFER_POOL_CACHE_SIZE / 2;
+	if(n == 0) n = 1;
+	while(n--)
+	{
+		if(!central[c].head && !grow(c)) break;
+		buffer_block* b = central[c].head;
+		central[c].head = b->next;
+		cache.blocks[c][cache.count[c]++] = b;
+	}
+	return cache.count[c] != 0;
+}
+
+buffer_block* allocate(std::size_t size) noexcept
+{
+	if(size > max_size) return nullptr;
+
+	unsigned c = class_of(size);
+	buffer_block* b;
+	if(cache_destroyed)
+	{
+		std::lock_guard<std::mutex> lock(central[c].mtx);
+		if(!central[c].head && !grow(c)) return nullptr;
+		b = central[c].head;
+		central[c].head = b->next;
+	}
+	else
+	{
+		if(cache.count[c] == 0 && !refill(c)) return nullptr;
+		b = cache.blocks[c][--cache.count[c]];
+	}
+	b->refs.store(1, std::memory_order_relaxed);
+	b->size = 0;
+	return b;
+}
+
+void release(buffer_block* b) noexcept
+{
+	unsigned c = b->size_class;
+	if(cache_destroyed)
+	{
+		std::lock_guard<std::mutex> lock(central[c].mtx);
+		b->next = central[c].head;
+		central[c].head = b;
+		return;
+	}
+	if(cache.count[c] == SOCA_BUFFER_POOL_CACHE_SIZE)
+		cache.flush(c, SOCA_BUFFER_POOL_CACHE_SIZE / 2 ? SOCA_BUFFER_POOL_CACHE_SIZE / 2 : 1);
+	cache.blocks[c][cache.count[c]++] = b;
+}
+
+std::size_t slabs() noexcept
+{
+	return slab_count.load(std::memory_order_relaxed);
+}
+
+}//buffer_pool
+}//Soca
@@ -0,0 +1,163 @@
+#ifndef SOCA_BUFFER_POOL_HPP__
+#define SOCA_BUFFER_POOL_HPP__
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+
+/**
+ * Number of free blocks, per size class, kept at each thread cache
+ */
+#ifndef SOCA_BUFFER_POOL_CACHE_SIZE
+#define SOCA_BUFFER_POOL_CACHE_SIZE		32
+#endif /* SOCA_BUFFER_POOL_CACHE_SIZE */
+
+/**
+ * Memory requested to the system each time a size class runs out of blocks
+ */
+#ifndef SOCA_BUFFER_POOL_SLAB_SIZE
+#define SOCA_BUFFER_POOL_SLAB_SIZE		(256 * 1024)
+#endif /* SOCA_BUFFER_POOL_SLAB_SIZE */
+
+/**
+ * Capacity of the buffers allocated by the receive functions when a
+ * empty buffer is passed
+ */
+#ifndef SOCA_BUFFER_POOL_DEFAULT_SIZE
+#define SOCA_BUFFER_POOL_DEFAULT_SIZE	2048
+#endif /* SOCA_BUFFER_POOL_DEFAULT_SIZE */
+
+namespace Soca{
+
+/**
+ * \brief Header of every pool block. Data follows the header.
+ */
+struct alignas(16) buffer_block{
+	std::atomic<std::uint32_t>	refs;
+	std::uint32_t				size;
+	std::uint8_t				size_class;
+	buffer_block*				next;
+};
+
+namespace buffer_pool{
+
+/**
+ * Capacity of each size class
+ */
+static constexpr const std::size_t size_classes[] = {256, 2048, 16384, 65536};
+static constexpr const unsigned size_class_count = sizeof(size_classes) / sizeof(size_classes[0]);
+static constexpr const std::size_t max_size = size_classes[size_class_count - 1];
+
+/**
+ * \brief Gets a block that fits \p size bytes. Returns nullptr if
+ * \p size is bigger than max_size, or the system is out of memory.
+ *
+ * At steady state, blocks come from the thread cache, without locks
+ * or calls to malloc.
+ */
+buffer_block* allocate(std::size_t size) noexcept;
+
+/**
+ * \brief Returns a block (with no references) to the pool
+ */
+void release(buffer_block*) noexcept;
+
+/**
+ * \brief Number of slabs requested to the system
+ */
+std::size_t slabs() noexcept;
+
+}//buffer_pool
+
+/**
+ * \brief Owning handle to a pool buffer
+ *
+ * Copies share the same memory (reference counted); the block returns
+ * to the pool when the last handle is destroyed. Handles may be moved
+ * to, and released at, any thread.
+ */
+class buffer{
+	public:
+		buffer() noexcept : block_(nullptr){}
+		explicit buffer(std::size_t capacity) noexcept
+			: block_(buffer_pool::allocate(capacity)){}
+
+		buffer(buffer const& other) noexcept : block_(other.block_)
+		{
+			if(block_) block_->refs.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		buffer(buffer&& other) noexcept : block_(other.block_)
+		{
+			other.block_ = nullptr;
+		}
+
+		~buffer()
+		{
+			reset();
+		}
+
+		buffer& operator=(buffer const& other) noexcept
+		{
+			if(other.block_) other.block_->refs.fetch_add(1, std::memory_order_relaxed);
+			reset();
+			block_ = other.block_;
+			return *this;
+		}
+
+		buffer& operator=(buffer&& other) noexcept
+		{
+			if(this != &other)
+			{
+				reset();
+				block_ = other.block_;
+				other.block_ = nullptr;
+			}
+			return *this;
+		}
+
+		void reset() noexcept
+		{
+			if(block_ && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				buffer_pool::release(block_);
+			block_ = nullptr;
+		}
+
+		std::uint8_t* data() noexcept
+		{
+			return reinterpret_cast<std::uint8_t*>(block_ + 1);
+		}
+
+		std::uint8_t const* data() const noexcept
+		{
+			return reinterpret_cast<std::uint8_t const*>(block_ + 1);
+		}
+
+		std::size_t size() const noexcept{ return block_ ? block_->size : 0; }
+		/**
+		 * \brief Sets the bytes used (up to capacity()). No effect on a empty buffer
+		 */
+		void size(std::size_t len) noexcept
+		{
+			if(block_) block_->size = static_cast<std::uint32_t>(len);
+		}
+
+		std::size_t capacity() const noexcept
+		{
+			return block_ ? buffer_pool::size_classes[block_->size_class] : 0;
+		}
+
+		std::uint32_t use_count() const noexcept
+		{
+			return block_ ? block_->refs.load(std::memory_order_relaxed) : 0;
+		}
+
+		bool unique() const noexcept{ return use_count() == 1; }
+		explicit operator bool() const noexcept{ return block_ != nullptr; }
+	private:
+		buffer_block*	block_;
+};
+
+}//Soca
+
+#endif /* SOCA_BUFFER_POOL_HPP__ */
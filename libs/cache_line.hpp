@@ -0,0 +1,12 @@
+#ifndef SOCA_CACHE_LINE_HPP__
+#define SOCA_CACHE_LINE_HPP__
+
+/**
+ * Alignment used to keep data written by different threads at
+ * different cache lines (avoiding false sharing)
+ */
+#ifndef SOCA_CACHE_LINE_SIZE
+#define SOCA_CACHE_LINE_SIZE		64
+#endif /* SOCA_CACHE_LINE_SIZE */
+
+#endif /* SOCA_CACHE_LINE_HPP__ */
@@ -1,4 +1,10 @@
 #include "dtls_client.hpp"
+#include "metrics.hpp"
+
+#if !defined(_WIN32)
+#include <netinet/in.h>
+#include <unistd.h>
+#endif /* !defined(_WIN32) */
 
 namespace Soca{
 
@@ -27,6 +33,8 @@ int DTLS_Client::init(const unsigned char* pers /* = nullptr */, std::size_t len
 
 int DTLS_Client::open(const char* addr, const char* port) noexcept
 {
+	/* reopen: closes the previous socket */
+	mbedtls_net_free(&server_fd_);
 	int ret = mbedtls_net_connect(&server_fd_, addr, port, MBEDTLS_NET_PROTO_UDP);
 	if(ret != 0)
 	{
@@ -36,6 +44,30 @@ int DTLS_Client::open(const char* addr, const char* port) noexcept
 	return handshake();
 }
 
+int DTLS_Client::open(const struct sockaddr* addr, socklen_t addr_len) noexcept
+{
+	int fd = static_cast<int>(::socket(addr->sa_family, SOCK_DGRAM, IPPROTO_UDP));
+	if(fd < 0)
+	{
+		return MBEDTLS_ERR_NET_SOCKET_FAILED;
+	}
+
+	if(::connect(fd, addr, addr_len) != 0)
+	{
+#if defined(_WIN32)
+		::closesocket(fd);
+#else /* defined(_WIN32) */
+		::close(fd);
+#endif /* defined(_WIN32) */
+		return MBEDTLS_ERR_NET_CONNECT_FAILED;
+	}
+	/* closed by mbedtls_net_free (the previous one too, at reopen) */
+	mbedtls_net_free(&server_fd_);
+	server_fd_.fd = fd;
+
+	return handshake();
+}
+
 int DTLS_Client::pre_shared_secret(const unsigned char* psk,
 		std::size_t psk_len,
 		const unsigned char* psk_id,
@@ -77,11 +109,14 @@ int DTLS_Client::config(std::uint32_t timeout) noexcept
 
 int DTLS_Client::handshake() noexcept
 {
+	SOCA_METRIC_TIMER(timer, handshake);
 	int ret;
 	do ret = mbedtls_ssl_handshake(&ssl_);
 	while(ret == MBEDTLS_ERR_SSL_WANT_READ ||
 		  ret == MBEDTLS_ERR_SSL_WANT_WRITE);
 
+	if(ret == 0) SOCA_METRIC_ADD(handshakes, 1);
+	else SOCA_METRIC_ADD(handshake_errors, 1);
 	return ret;
 }
 
@@ -92,6 +127,12 @@ int DTLS_Client::write(const void* data, std::size_t len) noexcept
 	while( ret == MBEDTLS_ERR_SSL_WANT_READ ||
 			ret == MBEDTLS_ERR_SSL_WANT_WRITE );
 
+	if(ret > 0)
+	{
+		SOCA_METRIC_ADD(packets_sent, 1);
+		SOCA_METRIC_ADD(bytes_sent, ret);
+	}
+	else if(ret < 0) SOCA_METRIC_ADD(errors, 1);
 	return ret;
 }
 
@@ -102,6 +143,12 @@ int DTLS_Client::read(void* buf, std::size_t len) noexcept
 	while(ret == MBEDTLS_ERR_SSL_WANT_READ ||
 			ret == MBEDTLS_ERR_SSL_WANT_WRITE );
 
+	if(ret > 0)
+	{
+		SOCA_METRIC_ADD(packets_received, 1);
+		SOCA_METRIC_ADD(bytes_received, ret);
+	}
+	else if(ret < 0) SOCA_METRIC_ADD(errors, 1);
 	return ret;
 }
 
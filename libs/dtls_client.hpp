@@ -3,6 +3,13 @@
 
 #include <cstdint>
 
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else /* defined(_WIN32) */
+#include <sys/socket.h>
+#endif /* defined(_WIN32) */
+
 #include "mbedtls/net_sockets.h"
 //#include "mbedtls/debug.h"
 #include "mbedtls/ssl.h"
@@ -24,7 +31,15 @@ class DTLS_Client{
 		int hostname(const char* name) noexcept;
 		int config(std::uint32_t timeout) noexcept;
 
+		/**
+		 * \brief Resolves \p addr (blocking getaddrinfo) and connects
+		 */
 		int open(const char* addr, const char* port) noexcept;
+		/**
+		 * \brief Connects to a address already resolved (e.g. by
+		 * POSIX::resolver; endpoint.native() and endpoint.size())
+		 */
+		int open(const struct sockaddr* addr, socklen_t addr_len) noexcept;
 		void close() noexcept;
 
 		int write(const void* data, std::size_t len) noexcept;
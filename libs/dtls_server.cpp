@@ -1,4 +1,6 @@
 #include "dtls_server.hpp"
+#include "metrics.hpp"
+#include "probe.hpp"
 #include <cstdio>
 
 namespace Soca{
@@ -114,11 +116,15 @@ int DTLS_Server::listen(unsigned char* client_ip, std::size_t& client_ip_len) no
 
 int DTLS_Server::handshake() noexcept
 {
+	SOCA_METRIC_TIMER(timer, handshake);
 	int ret;
 	do ret = mbedtls_ssl_handshake(&ssl_);
 	while(ret == MBEDTLS_ERR_SSL_WANT_READ ||
 		  ret == MBEDTLS_ERR_SSL_WANT_WRITE);
 
+	SOCA_PROBE(dtls_server_handshake, client_fd_.fd, 0, ret);
+	if(ret == 0) SOCA_METRIC_ADD(handshakes, 1);
+	else SOCA_METRIC_ADD(handshake_errors, 1);
 	return ret;
 }
 
@@ -128,7 +134,14 @@ int DTLS_Server::read(void* buf, std::size_t len) noexcept
 	do ret = mbedtls_ssl_read(&ssl_, (unsigned char*)buf, len);
 	while( ret == MBEDTLS_ERR_SSL_WANT_READ ||
 		   ret == MBEDTLS_ERR_SSL_WANT_WRITE );
+	SOCA_PROBE(dtls_server_read, client_fd_.fd, ret, ret < 0 ? ret : 0);
 
+	if(ret > 0)
+	{
+		SOCA_METRIC_ADD(packets_received, 1);
+		SOCA_METRIC_ADD(bytes_received, ret);
+	}
+	else if(ret < 0) SOCA_METRIC_ADD(errors, 1);
 	return ret;
 }
 
@@ -138,7 +151,14 @@ int DTLS_Server::write(const void* data, std::size_t size) noexcept
 	do ret = mbedtls_ssl_write(&ssl_, (const unsigned char*)data, size);
 	while( ret == MBEDTLS_ERR_SSL_WANT_READ ||
 		   ret == MBEDTLS_ERR_SSL_WANT_WRITE );
+	SOCA_PROBE(dtls_server_write, client_fd_.fd, ret, ret < 0 ? ret : 0);
 
+	if(ret > 0)
+	{
+		SOCA_METRIC_ADD(packets_sent, 1);
+		SOCA_METRIC_ADD(bytes_sent, ret);
+	}
+	else if(ret < 0) SOCA_METRIC_ADD(errors, 1);
 	return ret;
 }
 
@@ -36,10 +36,19 @@ const char* Error::message(int error)
 		case errc::socket_receive:		return "socket receive";
 		case errc::socket_send:			return "socket bind";
 		case errc::socket_bind:			return "socket bind";
+		case errc::socket_option:		return "socket option";
+		case errc::connect_refused:		return "connection refused";
+		case errc::connect_timeout:		return "connection timeout";
+		case errc::connect_unreachable:	return "network unreachable";
 		case errc::transaction_ocupied:	return "transaction ocupied";
 		case errc::no_free_slots:		return "no transacition free slot";
 		case errc::buffer_empty:		return "buffer empty";
 		case errc::request_not_supported: return "request not supported";
+		case errc::out_of_resources:	return "out of resources";
+		case errc::queue_full:			return "queue full";
+		case errc::name_not_found:		return "name not found";
+		case errc::name_timeout:		return "name resolution timeout";
+		case errc::name_server_error:	return "name server error";
 		default:
 			break;
 	}
@@ -28,11 +28,22 @@ enum class errc : int{
 	socket_receive,
 	socket_send,
 	socket_bind,
+	socket_option,
+	connect_refused,
+	connect_timeout,
+	connect_unreachable,
 	//transmission
 	transaction_ocupied		= 60,
 	no_free_slots,
 	buffer_empty,
-	request_not_supported
+	request_not_supported,
+	//resources
+	out_of_resources		= 70,
+	queue_full,
+	//name resolution
+	name_not_found			= 80,
+	name_timeout,
+	name_server_error
 };
 
 struct Error {
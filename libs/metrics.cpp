@@ -0,0 +1,299 @@
+#include "metrics.hpp"
+
+#if SOCA_USE_METRICS == 1
+
+#include <atomic>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+
+#include "cache_line.hpp"
+
+namespace Soca{
+namespace metrics{
+
+/**
+ * Values of one thread. Only the owner writes (load + store, no lock
+ * prefix); the collector reads with relaxed loads.
+ */
+struct alignas(SOCA_CACHE_LINE_SIZE) thread_block{
+	std::atomic<std::uint64_t>	counters[counter_count];
+	std::atomic<std::int64_t>	gauges[gauge_count];
+	struct{
+		std::atomic<std::uint64_t>	count;
+		std::atomic<std::uint64_t>	sum;
+		std::atomic<std::uint64_t>	buckets[histogram_buckets];
+	} histograms[histogram_count];
+
+	thread_block*	next = nullptr;
+	thread_block*	prev = nullptr;
+
+	thread_block();
+	~thread_block();
+};
+
+/**
+ * Registered blocks, and the values of threads already finished
+ */
+static std::mutex		registry_mtx;
+static thread_block*	registry = nullptr;
+static snapshot			retired = {};
+
+static void fold(snapshot& snap, thread_block const& b) noexcept
+{
+	for(unsigned i = 0; i < counter_count; i++)
+		snap.counters[i] += b.counters[i].load(std::memory_order_relaxed);
+	for(unsigned i = 0; i < gauge_count; i++)
+		snap.gauges[i] += b.gauges[i].load(std::memory_order_relaxed);
+	for(unsigned h = 0; h < histogram_count; h++)
+	{
+		snap.histograms[h].count += b.histograms[h].count.load(std::memory_order_relaxed);
+		snap.histograms[h].sum += b.histograms[h].sum.load(std::memory_order_relaxed);
+		for(unsigned i = 0; i < histogram_buckets; i++)
+			snap.histograms[h].buckets[i] += b.histograms[h].buckets[i].load(std::memory_order_relaxed);
+	}
+}
+
+thread_block::thread_block()
+{
+	for(auto& c : counters) c.store(0, std::memory_order_relaxed);
+	for(auto& g : gauges) g.store(0, std::memory_order_relaxed);
+	for(auto& h : histograms)
+	{
+		h.count.store(0, std::memory_order_relaxed);
+		h.sum.store(0, std::memory_order_relaxed);
+		for(auto& b : h.buckets) b.store(0, std::memory_order_relaxed);
+	}
+
+	std::lock_guard<std::mutex> lock(registry_mtx);
+	next = registry;
+	if(registry) registry->prev = this;
+	registry = this;
+}
+
+/**
+ * Set when the block of the thread is destroyed: the values updated
+ * later (e.g. by other thread_local destructors) go straight to retired.
+ * Trivially destructible, so still valid then.
+ */
+static thread_local bool block_destroyed = false;
+
+thread_block::~thread_block()
+{
+	std::lock_guard<std::mutex> lock(registry_mtx);
+	fold(retired, *this);
+	if(prev) prev->next = next;
+	else registry = next;
+	if(next) next->prev = prev;
+	block_destroyed = true;
+}
+
+static thread_local thread_block block;
+
+template<typename T>
+static inline void increment(std::atomic<T>& value, T delta) noexcept
+{
+	value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+void add(counter c, std::uint64_t value /* = 1 */) noexcept
+{
+	if(block_destroyed)
+	{
+		std::lock_guard<std::mutex> lock(registry_mtx);
+		retired.counters[static_cast<unsigned>(c)] += value;
+		return;
+	}
+	increment(block.counters[static_cast<unsigned>(c)], value);
+}
+
+void add(gauge g, std::int64_t value) noexcept
+{
+	if(block_destroyed)
+	{
+		std::lock_guard<std::mutex> lock(registry_mtx);
+		retired.gauges[static_cast<unsigned>(g)] += value;
+		return;
+	}
+	increment(block.gauges[static_cast<unsigned>(g)], value);
+}
+
+void record(histogram h, std::uint64_t value) noexcept
+{
+	if(block_destroyed)
+	{
+		std::lock_guard<std::mutex> lock(registry_mtx);
+		histogram_snapshot& hist = retired.histograms[static_cast<unsigned>(h)];
+		hist.count++;
+		hist.sum += value;
+		hist.buckets[bucket_index(value)]++;
+		return;
+	}
+	auto& hist = block.histograms[static_cast<unsigned>(h)];
+	increment(hist.count, std::uint64_t(1));
+	increment(hist.sum, value);
+	increment(hist.buckets[bucket_index(value)], std::uint64_t(1));
+}
+
+void collect(snapshot& snap) noexcept
+{
+	std::lock_guard<std::mutex> lock(registry_mtx);
+	snap = retired;
+	for(thread_block* b = registry; b; b = b->next)
+		fold(snap, *b);
+}
+
+std::uint64_t histogram_snapshot::percentile(double q) const noexcept
+{
+	if(count == 0) return 0;
+	std::uint64_t target = static_cast<std::uint64_t>(q * static_cast<double>(count));
+	if(target >= count) target = count - 1;
+
+	std::uint64_t acc = 0;
+	for(unsigned i = 0; i < histogram_buckets; i++)
+	{
+		acc += buckets[i];
+		if(acc > target) return bucket_lower(i);
+	}
+	return bucket_lower(histogram_buckets - 1);
+}
+
+static const char* const counter_names[] = {
+	"bytes_received",
+	"bytes_sent",
+	"packets_received",
+	"packets_sent",
+	"accepts",
+	"closes",
+	"would_block",
+	"errors",
+	"handshakes",
+	"handshake_errors",
+	"dns_queries",
+	"dns_cache_hits",
+	"dns_timeouts",
+	"pool_hits",
+	"pool_misses",
+	"pool_dead",
+	"tcp_retransmits",
+	"admission_rejects",
+	"admission_pauses",
+	"session_drops",
+	"peer_pins",
+	"peer_unpins",
+};
+static_assert(sizeof(counter_names) / sizeof(counter_names[0]) == counter_count,
+		"counter name missing");
+
+static const char* const gauge_names[] = {
+	"connections",
+	"sessions",
+	"pinned_peers",
+};
+static_assert(sizeof(gauge_names) / sizeof(gauge_names[0]) == gauge_count,
+		"gauge name missing");
+
+static const char* const histogram_names[] = {
+	"handshake_ns",
+	"read_callback_ns",
+	"send_ns",
+	"pool_wait_ns",
+	"tcp_rtt_ns",
+	"tcp_cwnd_segments",
+	"tcp_delivery_rate_bytes_per_second",
+	"tcp_notsent_bytes",
+	"admission_wait_ns",
+};
+static_assert(sizeof(histogram_names) / sizeof(histogram_names[0]) == histogram_count,
+		"histogram name missing");
+
+const char* name(counter c) noexcept{ return counter_names[static_cast<unsigned>(c)]; }
+const char* name(gauge g) noexcept{ return gauge_names[static_cast<unsigned>(g)]; }
+const char* name(histogram h) noexcept{ return histogram_names[static_cast<unsigned>(h)]; }
+
+std::size_t export_text(snapshot const& snap, char* buffer, std::size_t len) noexcept
+{
+	std::size_t offset = 0;
+	auto print = [&](const char* fmt, auto... args) -> bool
+	{
+		int n = std::snprintf(buffer + offset, len - offset, fmt, args...);
+		if(n < 0 || static_cast<std::size_t>(n) >= len - offset) return false;
+		offset += n;
+		return true;
+	};
+
+	for(unsigned i = 0; i < counter_count; i++)
+		if(!print("# TYPE soca_%s_total counter\n"
+				"soca_%s_total %llu\n", counter_names[i], counter_names[i],
+				static_cast<unsigned long long>(snap.counters[i]))) return 0;
+	for(unsigned i = 0; i < gauge_count; i++)
+		if(!print("# TYPE soca_%s gauge\n"
+				"soca_%s %lld\n", gauge_names[i], gauge_names[i],
+				static_cast<long long>(snap.gauges[i]))) return 0;
+	for(unsigned h = 0; h < histogram_count; h++)
+	{
+		histogram_snapshot const& hist = snap.histograms[h];
+		if(!print("# TYPE soca_%s histogram\n", histogram_names[h])) return 0;
+		std::uint64_t acc = 0;
+		for(unsigned i = 0; i < histogram_buckets; i++)
+		{
+			if(hist.buckets[i] == 0) continue;
+			acc += hist.buckets[i];
+			/* upper bound of bucket i is the lower bound of i + 1 */
+			if(!print("soca_%s_bucket{le=\"%llu\"} %llu\n", histogram_names[h],
+					static_cast<unsigned long long>(i + 1 < histogram_buckets ?
+								bucket_lower(i + 1) - 1 : UINT64_MAX),
+					static_cast<unsigned long long>(acc))) return 0;
+		}
+		if(!print("soca_%s_bucket{le=\"+Inf\"} %llu\n"
+				"soca_%s_sum %llu\n"
+				"soca_%s_count %llu\n",
+				histogram_names[h], static_cast<unsigned long long>(hist.count),
+				histogram_names[h], static_cast<unsigned long long>(hist.sum),
+				histogram_names[h], static_cast<unsigned long long>(hist.count))) return 0;
+	}
+	return offset;
+}
+
+std::size_t export_binary(snapshot const& snap, void* buffer, std::size_t len) noexcept
+{
+	std::uint8_t* out = static_cast<std::uint8_t*>(buffer);
+	std::size_t offset = 0;
+	auto put = [&](std::uint64_t value, unsigned bytes) -> bool
+	{
+		if(len - offset < bytes) return false;
+		for(unsigned i = 0; i < bytes; i++)
+			out[offset++] = static_cast<std::uint8_t>(value >> (8 * i));
+		return true;
+	};
+
+	if(len < 4) return 0;
+	std::memcpy(out, "SOCM", 4);
+	offset = 4;
+	if(!put(1, 2) || !put(counter_count, 2)
+		|| !put(gauge_count, 2) || !put(histogram_count, 2)) return 0;
+
+	for(unsigned i = 0; i < counter_count; i++)
+		if(!put(snap.counters[i], 8)) return 0;
+	for(unsigned i = 0; i < gauge_count; i++)
+		if(!put(static_cast<std::uint64_t>(snap.gauges[i]), 8)) return 0;
+	for(unsigned h = 0; h < histogram_count; h++)
+	{
+		histogram_snapshot const& hist = snap.histograms[h];
+		unsigned n = 0;
+		for(unsigned i = 0; i < histogram_buckets; i++)
+			if(hist.buckets[i]) n++;
+		if(!put(hist.count, 8) || !put(hist.sum, 8) || !put(n, 2)) return 0;
+		for(unsigned i = 0; i < histogram_buckets; i++)
+		{
+			if(hist.buckets[i] == 0) continue;
+			if(!put(i, 2) || !put(hist.buckets[i], 8)) return 0;
+		}
+	}
+	return offset;
+}
+
+}//metrics
+}//Soca
+
+#endif /* SOCA_USE_METRICS == 1 */
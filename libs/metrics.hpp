@@ -0,0 +1,195 @@
+#ifndef SOCA_METRICS_HPP__
+#define SOCA_METRICS_HPP__
+
+/**
+ * Runtime metrics (counters, gauges and latency histograms)
+ *
+ * Each thread writes its own cache-line aligned block, without atomic
+ * read-modify-write; collect() sums the blocks of all threads.
+ *
+ * Compiled out (macros expand to nothing) if SOCA_USE_METRICS != 1
+ */
+
+#if SOCA_USE_METRICS == 1
+
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+
+namespace Soca{
+namespace metrics{
+
+enum class counter : unsigned{
+	bytes_received = 0,
+	bytes_sent,
+	packets_received,
+	packets_sent,
+	accepts,
+	closes,
+	would_block,
+	errors,
+	handshakes,
+	handshake_errors,
+	dns_queries,
+	dns_cache_hits,
+	dns_timeouts,
+	pool_hits,
+	pool_misses,
+	pool_dead,
+	tcp_retransmits,
+	admission_rejects,
+	admission_pauses,
+	session_drops,
+	peer_pins,
+	peer_unpins,
+	count_
+};
+
+enum class gauge : unsigned{
+	connections = 0,
+	sessions,
+	pinned_peers,
+	count_
+};
+
+/**
+ * Latencies, in nanoseconds; the tcp_ ones are TCP_INFO samples, with
+ * the unit at the name
+ */
+enum class histogram : unsigned{
+	handshake = 0,
+	read_callback,
+	send,
+	pool_wait,
+	tcp_rtt,
+	tcp_cwnd,
+	tcp_delivery_rate,
+	tcp_notsent,
+	admission_wait,
+	count_
+};
+
+static constexpr const unsigned counter_count = static_cast<unsigned>(counter::count_);
+static constexpr const unsigned gauge_count = static_cast<unsigned>(gauge::count_);
+static constexpr const unsigned histogram_count = static_cast<unsigned>(histogram::count_);
+
+/**
+ * Log-linear buckets: values below 4 have its own bucket; above,
+ * each power of 2 is split in 4 (relative error < 25%).
+ */
+static constexpr const unsigned histogram_buckets = 4 + 62 * 4;
+
+constexpr unsigned highest_bit(std::uint64_t value) noexcept
+{
+#if defined(__GNUC__)
+	return 63 - static_cast<unsigned>(__builtin_clzll(value));
+#else /* defined(__GNUC__) */
+	unsigned e = 0;
+	while(value >>= 1) e++;
+	return e;
+#endif /* defined(__GNUC__) */
+}
+
+constexpr unsigned bucket_index(std::uint64_t value) noexcept
+{
+	if(value < 4) return static_cast<unsigned>(value);
+	unsigned e = highest_bit(value);
+	return 4 + (e - 2) * 4 + static_cast<unsigned>((value >> (e - 2)) & 3);
+}
+
+constexpr std::uint64_t bucket_lower(unsigned index) noexcept
+{
+	if(index < 4) return index;
+	unsigned e = (index - 4) / 4 + 2;
+	return (std::uint64_t(4) | ((index - 4) % 4)) << (e - 2);
+}
+
+void add(counter, std::uint64_t value = 1) noexcept;
+void add(gauge, std::int64_t value) noexcept;
+void record(histogram, std::uint64_t value) noexcept;
+
+struct histogram_snapshot{
+	std::uint64_t	count;
+	std::uint64_t	sum;
+	std::uint64_t	buckets[histogram_buckets];
+
+	/**
+	 * \brief Lower bound of the bucket of quantile \p q (0.0 - 1.0)
+	 */
+	std::uint64_t percentile(double q) const noexcept;
+};
+
+struct snapshot{
+	std::uint64_t		counters[counter_count];
+	std::int64_t		gauges[gauge_count];
+	histogram_snapshot	histograms[histogram_count];
+};
+
+/**
+ * \brief Sums the values of all threads
+ */
+void collect(snapshot&) noexcept;
+
+const char* name(counter) noexcept;
+const char* name(gauge) noexcept;
+const char* name(histogram) noexcept;
+
+/**
+ * \brief Text (Prometheus exposition format): soca_<name>, with the
+ * _total suffix at the counters. Returns the bytes written, or 0 if
+ * \p len is not enough.
+ */
+std::size_t export_text(snapshot const&, char* buffer, std::size_t len) noexcept;
+
+/**
+ * \brief Binary, little endian. Returns the bytes written, or 0 if
+ * \p len is not enough.
+ *
+ * "SOCM" | version u16 | counters u16 | gauges u16 | histograms u16 |
+ * counters u64[] | gauges i64[] |
+ * for each histogram: count u64 | sum u64 | n u16 | n * (bucket u16, count u64)
+ * (only non-empty buckets)
+ */
+std::size_t export_binary(snapshot const&, void* buffer, std::size_t len) noexcept;
+
+inline std::uint64_t now() noexcept
+{
+	return static_cast<std::uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/**
+ * \brief Records the time from construction to destruction
+ */
+class scoped_timer{
+	public:
+		explicit scoped_timer(histogram h) noexcept
+			: hist_(h), start_(now()){}
+		~scoped_timer()
+		{
+			record(hist_, now() - start_);
+		}
+	private:
+		histogram		hist_;
+		std::uint64_t	start_;
+};
+
+}//metrics
+}//Soca
+
+#define SOCA_METRIC_ADD(name, value)	::Soca::metrics::add(::Soca::metrics::counter::name, value)
+#define SOCA_METRIC_GAUGE(name, value)	::Soca::metrics::add(::Soca::metrics::gauge::name, value)
+#define SOCA_METRIC_RECORD(name, value)	::Soca::metrics::record(::Soca::metrics::histogram::name, value)
+#define SOCA_METRIC_TIMER(var, name)	::Soca::metrics::scoped_timer var{::Soca::metrics::histogram::name}
+
+#else /* SOCA_USE_METRICS == 1 */
+
+#define SOCA_METRIC_ADD(name, value)		(void)0
+#define SOCA_METRIC_GAUGE(name, value)		(void)0
+#define SOCA_METRIC_RECORD(name, value)		(void)0
+#define SOCA_METRIC_TIMER(var, name)		(void)0
+
+#endif /* SOCA_USE_METRICS == 1 */
+
+#endif /* SOCA_METRICS_HPP__ */
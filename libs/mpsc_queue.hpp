@@ -0,0 +1,104 @@
+#ifndef SOCA_MPSC_QUEUE_HPP__
+#define SOCA_MPSC_QUEUE_HPP__
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <utility>
+
+#include "cache_line.hpp"
+
+namespace Soca{
+
+/**
+ * \brief Bounded lock-free multiple producer, single consumer queue
+ *
+ * Dmitry Vyukov's bounded queue: each cell has a sequence number telling
+ * if it is free to write (== position) or ready to read (== position + 1).
+ * Producers claim positions with a CAS; the single consumer needs none.
+ *
+ * \tparam T default constructible and move assignable
+ * \tparam Capacity power of 2
+ */
+template<typename T,
+		std::size_t Capacity>
+class mpsc_queue{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+			"Capacity must be power of 2");
+	public:
+		mpsc_queue() noexcept
+		{
+			for(std::size_t i = 0; i < Capacity; i++)
+				buffer_[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		mpsc_queue(mpsc_queue const&) = delete;
+		mpsc_queue& operator=(mpsc_queue const&) = delete;
+
+		/**
+		 * Producer side, any thread. Returns false if full.
+		 */
+		bool push(T&& value) noexcept
+		{
+			cell* c;
+			std::size_t pos = tail_.load(std::memory_order_relaxed);
+			while(true)
+			{
+				c = &buffer_[pos & (Capacity - 1)];
+				std::size_t seq = c->sequence.load(std::memory_order_acquire);
+				std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+				if(diff == 0)
+				{
+					if(tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+						break;
+				}
+				else if(diff < 0)
+				{
+					return false;
+				}
+				else
+				{
+					pos = tail_.load(std::memory_order_relaxed);
+				}
+			}
+			c->data = std::move(value);
+			c->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool push(T const& value) noexcept
+		{
+			T v{value};
+			return push(std::move(v));
+		}
+
+		/**
+		 * Consumer side. Returns false if empty (or the next element
+		 * is still being written).
+		 */
+		bool pop(T& value) noexcept
+		{
+			cell& c = buffer_[head_ & (Capacity - 1)];
+			if(c.sequence.load(std::memory_order_acquire) != head_ + 1)
+				return false;
+			value = std::move(c.data);
+			c.sequence.store(head_ + Capacity, std::memory_order_release);
+			head_++;
+			return true;
+		}
+
+		static constexpr std::size_t capacity() noexcept{ return Capacity; }
+	private:
+		struct cell{
+			std::atomic<std::size_t>	sequence;
+			T							data;
+		};
+
+		alignas(SOCA_CACHE_LINE_SIZE) std::atomic<std::size_t>	tail_{0};
+		alignas(SOCA_CACHE_LINE_SIZE) std::size_t				head_ = 0;
+		alignas(SOCA_CACHE_LINE_SIZE) cell						buffer_[Capacity];
+};
+
+}//Soca
+
+#endif /* SOCA_MPSC_QUEUE_HPP__ */
@@ -0,0 +1,292 @@
+#ifndef SOCA_POSIX_ADDRESS_HPP__
+#define SOCA_POSIX_ADDRESS_HPP__
+
+/**
+ * IPv4/IPv6 address parsing and formatting
+ *
+ * Replaces inet_pton/inet_ntop: no locale, no errno, and constexpr, so
+ * literal addresses are parsed at compile time:
+ *
+ * constexpr ipv4_address local = parse_ipv4("127.0.0.1");
+ * static_assert(local.valid);
+ *
+ * Accepts the same syntax as inet_pton (dotted quad with no leading
+ * zeros; IPv6 with "::" and trailing dotted quad). IPv6 is formatted
+ * as RFC 5952 (lowercase, longest zero run compressed, IPv4-mapped as
+ * ::ffff:a.b.c.d).
+ */
+
+#include <cstdlib>
+#include <cstdint>
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * Buffer sizes to format, including the null terminator
+ * (same as INET_ADDRSTRLEN/INET6_ADDRSTRLEN)
+ */
+static constexpr const std::size_t ipv4_str_size = 16;
+static constexpr const std::size_t ipv6_str_size = 46;
+
+/**
+ * \brief Address bytes, in network byte order
+ */
+struct ipv4_address{
+	std::uint8_t	bytes[4] = {};
+	bool			valid = false;
+};
+
+struct ipv6_address{
+	std::uint8_t	bytes[16] = {};
+	bool			valid = false;
+};
+
+namespace detail{
+
+constexpr std::size_t length(const char* str) noexcept
+{
+	std::size_t len = 0;
+	while(str[len] != '\0') len++;
+	return len;
+}
+
+constexpr int hex_value(char c) noexcept
+{
+	return c >= '0' && c <= '9' ? c - '0' :
+			c >= 'a' && c <= 'f' ? c - 'a' + 10 :
+			c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+}
+
+/**
+ * Parses a dotted quad at [str, str + len) to \p out
+ */
+constexpr bool parse_quad(const char* str, std::size_t len, std::uint8_t* out) noexcept
+{
+	unsigned part = 0, digits = 0, value = 0;
+	for(std::size_t i = 0; i < len; i++)
+	{
+		char c = str[i];
+		if(c >= '0' && c <= '9')
+		{
+			/* no leading zeros (inet_pton) */
+			if(digits == 1 && value == 0) return false;
+			value = value * 10 + static_cast<unsigned>(c - '0');
+			if(value > 255) return false;
+			digits++;
+		}
+		else if(c == '.')
+		{
+			if(digits == 0 || part == 3) return false;
+			out[part++] = static_cast<std::uint8_t>(value);
+			digits = 0;
+			value = 0;
+		}
+		else return false;
+	}
+	if(digits == 0 || part != 3) return false;
+	out[3] = static_cast<std::uint8_t>(value);
+	return true;
+}
+
+constexpr std::size_t format_byte(std::uint8_t value, char* out) noexcept
+{
+	std::size_t n = 0;
+	if(value >= 100) out[n++] = static_cast<char>('0' + value / 100);
+	if(value >= 10) out[n++] = static_cast<char>('0' + (value / 10) % 10);
+	out[n++] = static_cast<char>('0' + value % 10);
+	return n;
+}
+
+/**
+ * Formats a dotted quad. \p out must have at least 15 chars.
+ */
+constexpr std::size_t format_quad(std::uint8_t const* bytes, char* out) noexcept
+{
+	std::size_t n = 0;
+	for(int i = 0; i < 4; i++)
+	{
+		if(i) out[n++] = '.';
+		n += format_byte(bytes[i], out + n);
+	}
+	return n;
+}
+
+}//detail
+
+constexpr ipv4_address parse_ipv4(const char* str, std::size_t len) noexcept
+{
+	ipv4_address addr;
+	addr.valid = detail::parse_quad(str, len, addr.bytes);
+	if(!addr.valid)
+		for(auto& b : addr.bytes) b = 0;
+	return addr;
+}
+
+constexpr ipv4_address parse_ipv4(const char* str) noexcept
+{
+	return parse_ipv4(str, detail::length(str));
+}
+
+constexpr ipv6_address parse_ipv6(const char* str, std::size_t len) noexcept
+{
+	std::uint16_t words[8] = {};
+	std::size_t n = 0, i = 0;
+	int gap = -1;					//group index of "::"
+
+	if(len >= 2 && str[0] == ':' && str[1] == ':')
+	{
+		gap = 0;
+		i = 2;
+	}
+
+	/* group by group: 1 to 4 hex digits, then the separator */
+	while(i < len)
+	{
+		std::size_t start = i;
+		unsigned value = 0;
+		int hex = 0;
+		while(i < len && i - start < 4 && (hex = detail::hex_value(str[i])) >= 0)
+		{
+			value = (value << 4) | static_cast<unsigned>(hex);
+			i++;
+		}
+		if(i == start) return ipv6_address{};
+
+		if(i < len && str[i] == '.')
+		{
+			/* trailing dotted quad */
+			std::uint8_t quad[4] = {};
+			if(n > 6 || !detail::parse_quad(str + start, len - start, quad))
+				return ipv6_address{};
+			words[n++] = static_cast<std::uint16_t>(quad[0] << 8 | quad[1]);
+			words[n++] = static_cast<std::uint16_t>(quad[2] << 8 | quad[3]);
+			break;
+		}
+
+		if(n == 8) return ipv6_address{};
+		words[n++] = static_cast<std::uint16_t>(value);
+		if(i == len) break;
+		/* ':' must be followed by a group or a second ':' */
+		if(str[i] != ':' || ++i == len) return ipv6_address{};
+		if(str[i] == ':')
+		{
+			/* "::" (only once) */
+			if(gap >= 0) return ipv6_address{};
+			gap = static_cast<int>(n);
+			i++;
+		}
+	}
+
+	if(gap >= 0)
+	{
+		/* "::" must stand for at least one group */
+		if(n == 8) return ipv6_address{};
+		std::size_t shift = 8 - n;
+		for(std::size_t k = n; k-- > static_cast<std::size_t>(gap);)
+		{
+			words[k + shift] = words[k];
+			words[k] = 0;
+		}
+	}
+	else if(n != 8) return ipv6_address{};
+
+	ipv6_address addr;
+	for(int k = 0; k < 8; k++)
+	{
+		addr.bytes[2 * k] = static_cast<std::uint8_t>(words[k] >> 8);
+		addr.bytes[2 * k + 1] = static_cast<std::uint8_t>(words[k]);
+	}
+	addr.valid = true;
+	return addr;
+}
+
+constexpr ipv6_address parse_ipv6(const char* str) noexcept
+{
+	return parse_ipv6(str, detail::length(str));
+}
+
+/**
+ * \brief Formats to \p out, null terminated. Returns the length (without
+ * the terminator), or 0 if \p len is not enough.
+ */
+constexpr std::size_t format_ipv4(std::uint8_t const* bytes, char* out, std::size_t len) noexcept
+{
+	char tmp[ipv4_str_size] = {};
+	std::size_t n = detail::format_quad(bytes, tmp);
+	if(n >= len) return 0;
+	for(std::size_t i = 0; i < n; i++) out[i] = tmp[i];
+	out[n] = '\0';
+	return n;
+}
+
+constexpr std::size_t format_ipv6(std::uint8_t const* bytes, char* out, std::size_t len) noexcept
+{
+	unsigned words[8] = {};
+	for(int i = 0; i < 8; i++)
+		words[i] = static_cast<unsigned>(bytes[2 * i] << 8) | bytes[2 * i + 1];
+
+	/* longest run of zeros (at least 2 groups; first if tie) */
+	int best = -1, best_len = 0;
+	for(int i = 0; i < 8;)
+	{
+		if(words[i] != 0)
+		{
+			i++;
+			continue;
+		}
+		int j = i;
+		while(j < 8 && words[j] == 0) j++;
+		if(j - i > best_len && j - i >= 2)
+		{
+			best = i;
+			best_len = j - i;
+		}
+		i = j;
+	}
+
+	char tmp[ipv6_str_size] = {};
+	std::size_t n = 0;
+	bool mapped = best == 0 && best_len == 5 && words[5] == 0xffff;
+	int last = mapped ? 6 : 8;
+	for(int i = 0; i < last; i++)
+	{
+		if(i == best)
+		{
+			tmp[n++] = ':';
+			if(i == 0) tmp[n++] = ':';
+			i += best_len - 1;
+			continue;
+		}
+		bool leading = false;
+		for(int shift = 12; shift >= 0; shift -= 4)
+		{
+			unsigned nibble = (words[i] >> shift) & 0xf;
+			if(!nibble && !leading && shift) continue;
+			leading = true;
+			tmp[n++] = "0123456789abcdef"[nibble];
+		}
+		if(i != 7) tmp[n++] = ':';
+	}
+	if(mapped) n += detail::format_quad(bytes + 12, tmp + n);
+
+	if(n >= len) return 0;
+	for(std::size_t i = 0; i < n; i++) out[i] = tmp[i];
+	out[n] = '\0';
+	return n;
+}
+
+constexpr std::size_t format_ipv4(ipv4_address const& addr, char* out, std::size_t len) noexcept
+{
+	return format_ipv4(addr.bytes, out, len);
+}
+
+constexpr std::size_t format_ipv6(ipv6_address const& addr, char* out, std::size_t len) noexcept
+{
+	return format_ipv6(addr.bytes, out, len);
+}
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_POSIX_ADDRESS_HPP__ */
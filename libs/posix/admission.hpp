@@ -0,0 +1,201 @@
+#ifndef SOCA_POSIX_ADMISSION_HPP__
+#define SOCA_POSIX_ADMISSION_HPP__
+
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+#include "../error.hpp"
+#include "../metrics.hpp"
+#include "flow_table.hpp"
+#include "tcp_info_sampler.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Token bucket: \p rate tokens per second, up to \p burst
+ */
+struct token_bucket{
+	double			tokens = 0;
+	std::uint64_t	last_ns = 0;
+
+	void refill(std::uint64_t now_ns, double rate, double burst) noexcept
+	{
+		if(now_ns > last_ns)
+		{
+			tokens += static_cast<double>(now_ns - last_ns) * rate / 1e9;
+			if(tokens > burst) tokens = burst;
+		}
+		last_ns = now_ns;
+	}
+
+	/**
+	 * \brief Nanoseconds until \p amount tokens are available
+	 */
+	std::uint64_t wait_ns(double amount, double rate) const noexcept
+	{
+		return tokens >= amount ? 0 :
+				static_cast<std::uint64_t>((amount - tokens) * 1e9 / rate) + 1;
+	}
+};
+
+/**
+ * \brief Admission control and load shedding of a tcp_server
+ *
+ * Connections are admitted at open_cb (admit()) and released at close_cb
+ * (release()); reads go through receive(). Nothing is queued at user
+ * space: excess is left at the kernel, where TCP pushes back on the peers.
+ *
+ * * Accepts: when the concurrent connections reach max_connections, or
+ * the accept token bucket is empty, the listener is paused (connections
+ * wait at the listen backlog). Connections above max_per_source of
+ * the same source IP are closed at admit.
+ * * Reads: each connection has a token bucket of read_rate bytes/s.
+ * Empty, the connection read events are paused (tcp_server::pause)
+ * until half the bucket is refilled.
+ * * Overload (overload()): new connections wait at the backlog, and each
+ * connection readable is paused instead of read, and resumed, oldest
+ * first, when the overload ends.
+ *
+ * process() must be called at each loop iteration (a short run
+ * BlockTimeMs, or the time it returns) to resume the paused.
+ * queue_delay_ns() tells how long the work is waiting, e.g. to be
+ * reported to a load balancer.
+ *
+ * Not thread safe: call from the thread of the server loop.
+ */
+template<class Server>
+class admission_control{
+	public:
+		using server = Server;
+		using handler = typename Server::handler;
+
+		struct config{
+			std::size_t		max_connections = 0;	//concurrent (0: unlimited)
+			std::size_t		max_per_source = 0;		//concurrent of a source IP (0: unlimited)
+			std::size_t		max_sources = 65536;	//source IPs tracked; admit fails when full
+			double			accept_rate = 0;		//connections/s (0: unlimited)
+			double			accept_burst = 64;
+			double			read_rate = 0;			//bytes/s of each connection (0: unlimited)
+			double			read_burst = 64 * 1024;
+			unsigned		resume_batch = 32;		//paused connections resumed by process()
+		};
+
+		explicit admission_control(Server&, config const& = config{}, std::uint64_t seed = 0);
+
+		admission_control(admission_control const&) = delete;
+		admission_control& operator=(admission_control const&) = delete;
+
+		/**
+		 * \brief Admits the connection accepted (call at open_cb). If
+		 * refused (limits, or out of memory), the connection is closed
+		 * (close_cb is not called).
+		 */
+		bool admit(handler socket) noexcept;
+		/**
+		 * \brief Releases the connection (call at close_cb, or before
+		 * closing it)
+		 */
+		void release(handler socket) noexcept;
+
+		/**
+		 * \brief Receives at most the bytes allowed by the read bucket.
+		 * Returns 0 (\p ec not set) if the connection was paused; if it
+		 * can't be paused, reads anyway.
+		 */
+		std::size_t receive(handler socket, void* buffer, std::size_t, Error&) noexcept;
+		/**
+		 * \brief Charges \p bytes read by other means (e.g. a dispatcher).
+		 * Returns false if the connection was paused.
+		 */
+		bool consume(handler socket, std::size_t bytes) noexcept;
+
+		/**
+		 * \brief Resumes the listener and connections due. Returns the
+		 * milliseconds until the next due, or -1 if nothing is waiting.
+		 */
+		int process() noexcept;
+
+		/**
+		 * \brief Enters/leaves the overload mode
+		 */
+		void overload(bool on) noexcept;
+		bool overloaded() const noexcept{ return overload_; }
+
+		/**
+		 * \brief Queueing delay: average (EWMA) of the time the
+		 * connections were paused, or the age of the oldest waiting
+		 * (connection, or the listener with connections at its backlog)
+		 * if greater
+		 */
+		std::uint64_t queue_delay_ns() const noexcept;
+		/**
+		 * \brief Connections waiting at the listen backlog (TCP_INFO of
+		 * the listener, Linux; 0 elsewhere)
+		 */
+		std::size_t accept_queue() const noexcept;
+
+		std::size_t connections() const noexcept{ return connections_; }
+		std::size_t paused() const noexcept{ return held_.size() + throttled_.size(); }
+		std::uint64_t rejected() const noexcept{ return rejected_; }
+		bool accepting() const noexcept{ return listener_paused_ns_ == 0; }
+	private:
+		struct connection{
+			token_bucket	read;
+			std::uint64_t	paused_ns = 0;		//0: not paused
+			endpoint_key	source;
+			bool			active = false;
+			bool			has_source = false;
+		};
+
+		struct waiting{
+			handler			socket;
+			std::uint64_t	paused_ns;			//identifies the pause (fd reused)
+			std::uint64_t	due_ns;
+		};
+		/* min-heap by due (std::push_heap) */
+		struct later{
+			bool operator()(waiting const& a, waiting const& b) const noexcept
+			{
+				return a.due_ns > b.due_ns;
+			}
+		};
+
+		static std::uint64_t now_ns() noexcept
+		{
+			return static_cast<std::uint64_t>(
+					std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		connection* find(handler socket) noexcept;
+		bool source_of(handler socket, endpoint_key&) const noexcept;
+		bool pause(handler socket, connection&, std::uint64_t now,
+				std::vector<waiting>&, std::uint64_t due) noexcept;
+		bool resume(std::vector<waiting>&, std::uint64_t now) noexcept;
+		void prune(std::vector<waiting>&) noexcept;
+		bool valid(waiting const&) const noexcept;
+		void update_listener(std::uint64_t now) noexcept;
+
+		Server&						server_;
+		config						config_;
+		std::vector<connection>		conns_;				//by fd
+		flow_table<std::uint32_t>	sources_;			//connections by source IP
+		token_bucket				accept_;
+		std::vector<waiting>		held_;				//overload, heap (due: pause time)
+		std::vector<waiting>		throttled_;			//read rate, heap by due time
+		std::size_t					connections_ = 0;
+		std::uint64_t				rejected_ = 0;
+		std::uint64_t				delay_ns_ = 0;		//EWMA
+		std::uint64_t				listener_paused_ns_ = 0;
+		bool						overload_ = false;
+};
+
+}//POSIX
+}//Soca
+
+#include "impl/admission_impl.hpp"
+
+#endif /* SOCA_POSIX_ADMISSION_HPP__ */
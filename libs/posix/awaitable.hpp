@@ -0,0 +1,244 @@
+#ifndef SOCA_POSIX_AWAITABLE_HPP__
+#define SOCA_POSIX_AWAITABLE_HPP__
+
+#if SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1
+
+#include <cstdlib>
+#include <cstdint>
+#include <cerrno>
+#include <utility>
+
+#include "../error.hpp"
+#include "executor.hpp"
+#include "port.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Awaitable of a socket operation
+ *
+ * The operation is tried at co_await; if it would block, the coroutine
+ * is suspended until the executor sees the socket ready. The awaiter
+ * lives at the coroutine frame, so no allocation is made.
+ *
+ * \tparam Operation callable that returns true when done, and provides
+ * result() and fail().
+ */
+template<typename Operation>
+class io_awaiter : private io_operation{
+	public:
+		template<typename ...Args>
+		io_awaiter(executor& exec, int socket, std::uint32_t events, Args&&... args) noexcept
+			: io_operation{&io_awaiter::perform_op, {}, socket, events},
+			  exec_(exec), op_{std::forward<Args>(args)...}{}
+
+		io_awaiter(io_awaiter const&) = delete;
+		io_awaiter& operator=(io_awaiter const&) = delete;
+
+		bool await_ready() noexcept
+		{
+			return op_();
+		}
+
+		bool await_suspend(std::coroutine_handle<> h) noexcept
+		{
+			waiter = h;
+			if(exec_.wait(this)) return true;
+			op_.fail();
+			return false;
+		}
+
+		auto await_resume() noexcept
+		{
+			if(failed) op_.fail();
+			return op_.result();
+		}
+	private:
+		static bool perform_op(io_operation* op) noexcept
+		{
+			return static_cast<io_awaiter*>(op)->op_();
+		}
+
+		executor&	exec_;
+		Operation	op_;
+};
+
+template<typename Socket>
+struct receive_op{
+	Socket&		socket;
+	void*		buffer;
+	std::size_t	buffer_len;
+	Error&		ec;
+	std::size_t	size = 0;
+
+	bool operator()() noexcept
+	{
+		size = socket.receive(buffer, buffer_len, ec);
+		return size != 0 || ec;
+	}
+	std::size_t result() const noexcept{ return size; }
+	void fail() noexcept{ ec = errc::socket_receive; }
+};
+
+/**
+ * Sends all buffer before completing
+ */
+template<typename Socket>
+struct send_op{
+	Socket&		socket;
+	const void*	buffer;
+	std::size_t	buffer_len;
+	Error&		ec;
+	std::size_t	sent = 0;
+
+	bool operator()() noexcept
+	{
+		while(sent < buffer_len)
+		{
+			std::size_t size = socket.send(static_cast<const std::uint8_t*>(buffer) + sent,
+										buffer_len - sent, ec);
+			if(ec) return true;
+			if(size == 0) return false;
+			sent += size;
+		}
+		return true;
+	}
+	std::size_t result() const noexcept{ return sent; }
+	void fail() noexcept{ ec = errc::socket_send; }
+};
+
+template<typename Server>
+struct server_receive_op{
+	Server&						server;
+	typename Server::handler	socket;
+	void*						buffer;
+	std::size_t					buffer_len;
+	Error&						ec;
+	std::size_t					size = 0;
+
+	bool operator()() noexcept
+	{
+		size = server.receive(socket, buffer, buffer_len, ec);
+		return size != 0 || ec;
+	}
+	std::size_t result() const noexcept{ return size; }
+	void fail() noexcept{ ec = errc::socket_receive; }
+};
+
+template<typename Server>
+struct server_send_op{
+	Server&						server;
+	typename Server::handler	socket;
+	const void*					buffer;
+	std::size_t					buffer_len;
+	Error&						ec;
+	std::size_t					sent = 0;
+
+	bool operator()() noexcept
+	{
+		while(sent < buffer_len)
+		{
+			std::size_t size = server.send(socket,
+										static_cast<const std::uint8_t*>(buffer) + sent,
+										buffer_len - sent, ec);
+			if(ec) return true;
+			if(size == 0) return false;
+			sent += size;
+		}
+		return true;
+	}
+	std::size_t result() const noexcept{ return sent; }
+	void fail() noexcept{ ec = errc::socket_send; }
+};
+
+template<typename Server>
+struct accept_op{
+	Server&						server;
+	Error&						ec;
+	typename Server::handler	socket = -1;
+
+	bool operator()() noexcept
+	{
+		/* -1 without error: nothing to accept (yet) */
+		socket = server.accept_socket(ec);
+		return socket != -1 || ec;
+	}
+	typename Server::handler result() const noexcept{ return socket; }
+	void fail() noexcept{ ec = errc::socket_error; }
+};
+
+/**
+ * \p connected is the return of async_open. Called again only when
+ * the socket is writable, i.e., the connection finished.
+ */
+template<typename Client>
+struct connect_op{
+	Client&		client;
+	Error&		ec;
+	bool		connected;
+	bool		waited = false;
+
+	bool operator()() noexcept
+	{
+		if(ec || connected) return true;
+		if(!waited)
+		{
+			waited = true;
+			return false;
+		}
+
+		int err = 0;
+		socklen_t len = sizeof(err);
+		if(::getsockopt(client.native(), SOL_SOCKET, SO_ERROR, &err, &len) == -1 || err != 0)
+			ec = errc::socket_error;
+		else
+			connected = true;
+		return true;
+	}
+	bool result() const noexcept{ return connected; }
+	void fail() noexcept{ ec = errc::socket_error; }
+};
+
+template<typename Socket>
+struct receive_from_op{
+	Socket&						socket;
+	void*						buffer;
+	std::size_t					buffer_len;
+	typename Socket::endpoint&	ep;
+	Error&						ec;
+	std::size_t					size = 0;
+
+	bool operator()() noexcept
+	{
+		size = socket.receive(buffer, buffer_len, ep, ec);
+		return size != 0 || ec;
+	}
+	std::size_t result() const noexcept{ return size; }
+	void fail() noexcept{ ec = errc::socket_receive; }
+};
+
+template<typename Socket>
+struct send_to_op{
+	Socket&						socket;
+	const void*					buffer;
+	std::size_t					buffer_len;
+	typename Socket::endpoint&	ep;
+	Error&						ec;
+	std::size_t					size = 0;
+
+	bool operator()() noexcept
+	{
+		size = socket.send(buffer, buffer_len, ep, ec);
+		return size != 0 || ec;
+	}
+	std::size_t result() const noexcept{ return size; }
+	void fail() noexcept{ ec = errc::socket_send; }
+};
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1 */
+
+#endif /* SOCA_POSIX_AWAITABLE_HPP__ */
@@ -0,0 +1,92 @@
+#ifndef SOCA_POSIX_BUSY_POLL_HPP__
+#define SOCA_POSIX_BUSY_POLL_HPP__
+
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+
+#if defined(__linux__)
+#include <sys/ioctl.h>
+#endif /* defined(__linux__) */
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Time split of the spin-then-sleep waits (tcp_server::run and
+ * udp::receive with SpinUs > 0)
+ */
+struct spin_stats{
+	std::uint64_t	spin_ns = 0;	//polling without blocking
+	std::uint64_t	sleep_ns = 0;	//blocked at the kernel
+	std::uint64_t	spin_hits = 0;	//waits ready while spinning
+	std::uint64_t	sleeps = 0;		//waits that blocked
+};
+
+/**
+ * \brief Calls \p poll (non-blocking; returns true if ready) until ready or
+ * \p SpinUs microseconds elapsed, then \p wait (blocking)
+ */
+template<unsigned SpinUs, typename Poll, typename Wait>
+void spin_wait(spin_stats& stats, Poll&& poll, Wait&& wait) noexcept
+{
+	using clock = std::chrono::steady_clock;
+	auto start = clock::now();
+	auto deadline = start + std::chrono::microseconds(SpinUs);
+	auto now = start;
+	bool ready;
+	do
+	{
+		ready = poll();
+		now = clock::now();
+	}while(!ready && now < deadline);
+
+	stats.spin_ns += static_cast<std::uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count());
+	if(ready)
+	{
+		stats.spin_hits++;
+		return;
+	}
+
+	wait();
+	stats.sleep_ns += static_cast<std::uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - now).count());
+	stats.sleeps++;
+}
+
+#if defined(__linux__)
+/**
+ * Epoll busy poll parameters (linux/eventpoll.h, Linux 6.9)
+ */
+struct epoll_busy_params{
+	std::uint32_t	busy_poll_usecs;
+	std::uint16_t	busy_poll_budget;
+	std::uint8_t	prefer_busy_poll;
+	std::uint8_t	pad;
+};
+
+#ifndef EPIOCSPARAMS
+#define EPIOCSPARAMS	_IOW(0x8A, 0x01, struct Soca::POSIX::epoll_busy_params)
+#endif /* EPIOCSPARAMS */
+
+/**
+ * \brief Makes epoll_wait at \p epoll_fd busy poll the device queues of
+ * its sockets for \p usecs (0 disables). Budget above 64 requires
+ * CAP_NET_ADMIN. Returns false if not supported (Linux < 6.9).
+ */
+inline bool epoll_busy_poll(int epoll_fd, unsigned usecs,
+		unsigned budget = 8, bool prefer = false) noexcept
+{
+	epoll_busy_params params = {};
+	params.busy_poll_usecs = usecs;
+	params.busy_poll_budget = static_cast<std::uint16_t>(budget);
+	params.prefer_busy_poll = prefer ? 1 : 0;
+	return ::ioctl(epoll_fd, EPIOCSPARAMS, &params) == 0;
+}
+#endif /* defined(__linux__) */
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_POSIX_BUSY_POLL_HPP__ */
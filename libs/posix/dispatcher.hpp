@@ -0,0 +1,96 @@
+#ifndef SOCA_POSIX_DISPATCHER_HPP__
+#define SOCA_POSIX_DISPATCHER_HPP__
+
+#include <cstdlib>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+#include "../thread_pool.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+struct dispatch_config{
+	/**
+	 * Events of a socket always go to the same strand (socket % strands),
+	 * so they run in order. 0: no strands, events may run concurrently.
+	 *
+	 * \note Strands are buckets, not per connection: the sockets sharing
+	 * one also run one at a time, so a slow callback delays them. Use
+	 * at least as many strands as the connections expected to be busy
+	 * at once (a multiple of the workers).
+	 */
+	unsigned		strands = 64;
+	/**
+	 * Events a strand runs before giving way to others
+	 */
+	unsigned		strand_batch = 16;
+	/**
+	 * Maximum number of events waiting to run. When full, the I/O
+	 * thread waits for a worker.
+	 */
+	std::size_t		queue_depth = 1024;
+};
+
+/**
+ * \brief Runs tcp_server callbacks at a thread pool
+ *
+ * Used with tcp_server::run_dispatch. The I/O thread only posts
+ * the events; read_cb and close_cb run at the workers. Closing
+ * the client socket is also done at the strand, after close_cb.
+ *
+ * \note SOCA_TCP_SERVER_CLIENT_LIST is not thread safe
+ */
+template<class Server,
+		typename ReadCb,
+		typename CloseCb = void*>
+class dispatcher{
+	public:
+		using handler = typename Server::handler;
+
+		dispatcher(Server&, thread_pool&,
+				ReadCb, CloseCb = nullptr,
+				dispatch_config const& = dispatch_config{});
+
+		dispatcher(dispatcher const&) = delete;
+		dispatcher& operator=(dispatcher const&) = delete;
+
+		void read(handler) noexcept;
+		/**
+		 * \brief Calls close_cb and, if \p owned (not watched), closes
+		 * the socket
+		 */
+		void close(handler, bool owned = true) noexcept;
+	private:
+		struct event : job{
+			dispatcher*		self;
+			handler			socket;
+			bool			close;
+			bool			owned;
+		};
+
+		void post(handler, bool close, bool owned = true) noexcept;
+		void release(event*) noexcept;
+		static void run(job*) noexcept;
+
+		Server&						server_;
+		thread_pool&				pool_;
+		ReadCb						read_cb_;
+		CloseCb						close_cb_;
+		std::deque<strand>			strands_;
+
+		std::unique_ptr<event[]>	events_;
+		std::mutex					mtx_;
+		std::condition_variable		cv_;
+		job*						free_;
+};
+
+}//POSIX
+}//Soca
+
+#include "impl/dispatcher_impl.hpp"
+
+#endif /* SOCA_POSIX_DISPATCHER_HPP__ */
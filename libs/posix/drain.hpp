@@ -0,0 +1,105 @@
+#ifndef SOCA_POSIX_DRAIN_HPP__
+#define SOCA_POSIX_DRAIN_HPP__
+
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+#include "../error.hpp"
+#include "port.hpp"
+#include "handoff.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Graceful drain of the connections of a tcp_server
+ *
+ * Connections are added at open_cb and removed at close_cb. The
+ * application marks them busy() while a request is in progress or it
+ * has writes queued.
+ *
+ * start() stops accepting (the listener is paused: at a hot restart, the
+ * new process accepts). Then, at each process(), idle connections are
+ * shut down for writing: the kernel sends what is queued and a FIN, and
+ * the connection is closed when the peer closes it (close_cb). At the
+ * deadline, the connections left are closed.
+ *
+ * Idle connections can instead be passed to a new process (hand_off).
+ *
+ * Not thread safe: call from the thread of the server loop.
+ */
+template<class Server>
+class connection_drain{
+	public:
+		using server = Server;
+		using handler = typename Server::handler;
+
+		explicit connection_drain(Server&) noexcept;
+
+		/**
+		 * \brief Tracks \p socket. Returns false if out of memory
+		 * (errc::out_of_resources): it would not be drained.
+		 */
+		bool add(handler socket, Error&) noexcept;
+		void remove(handler socket) noexcept;
+		/**
+		 * \brief Busy connections are not shut down (until the
+		 * deadline) nor handed off
+		 */
+		void busy(handler socket, bool on) noexcept;
+
+		/**
+		 * \brief Stops accepting and starts draining, closing the
+		 * connections left after \p deadline_ms
+		 */
+		void start(unsigned deadline_ms, Error&) noexcept;
+		bool draining() const noexcept{ return draining_; }
+
+		/**
+		 * \brief Shuts down the idle connections, and closes all at the
+		 * deadline (calling \p close_cb(handler) before). Call at each
+		 * loop iteration. Returns true when no connection is left.
+		 */
+		template<typename CloseCb = void*>
+		bool process(CloseCb = nullptr) noexcept;
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+		/**
+		 * \brief Passes the idle connections to the peer of \p unix_socket
+		 * (handoff_send), and detaches them from the server. If set,
+		 * \p state_cb(handler, void* state, std::size_t max) returns the
+		 * size of the application state sent with each. Returns the
+		 * number of connections passed.
+		 */
+		template<typename StateCb = void*>
+		std::size_t hand_off(int unix_socket, Error&, StateCb = nullptr) noexcept;
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+
+		std::size_t size() const noexcept{ return entries_.size(); }
+	private:
+		using clock = std::chrono::steady_clock;
+		static constexpr const std::uint32_t none = 0xffffffff;
+
+		struct entry{
+			handler		socket;
+			bool		busy;
+			bool		shut;		//write side shut down
+		};
+
+		void erase(std::uint32_t index) noexcept;
+
+		Server&						server_;
+		std::vector<entry>			entries_;
+		std::vector<std::uint32_t>	index_;		//by fd
+		clock::time_point			deadline_;
+		bool						draining_ = false;
+};
+
+}//POSIX
+}//Soca
+
+#include "impl/drain_impl.hpp"
+
+#endif /* SOCA_POSIX_DRAIN_HPP__ */
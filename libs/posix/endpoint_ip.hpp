@@ -6,6 +6,7 @@
 #include "../error.hpp"
 
 #include "port.hpp"
+#include "address.hpp"
 
 namespace Soca{
 namespace POSIX{
@@ -16,12 +17,13 @@ class endpoint_ip{
 
 		sa_family_t family() const noexcept
 		{
-			return family_;
+			return addr_.ss_family;
 		}
 
 		endpoint_ip()
 		{
 			std::memset(&addr_, 0, sizeof(native_type));
+			addr_.ss_family = AF_INET;
 		}
 
 		endpoint_ip(sa_family_t family, uint16_t port)
@@ -51,8 +53,8 @@ class endpoint_ip{
 		{
 			struct sockaddr_in addr_in;
 
-			family_ = AF_INET;
-			addr_in.sin_family = family_;
+			std::memset(&addr_in, 0, sizeof(struct sockaddr_in));
+			addr_in.sin_family = AF_INET;
 			addr_in.sin_port = htons(port);
 			addr_in.sin_addr.s_addr = addr;
 
@@ -64,7 +66,6 @@ class endpoint_ip{
 			struct sockaddr_in6 addr_in;
 
 			std::memset(&addr_in, 0, sizeof(struct sockaddr_in6));
-			family_ = AF_INET6;
 			addr_in.sin6_family = AF_INET6;
 			addr_in.sin6_port = htons(port);
 			addr_in.sin6_addr = addr;
@@ -75,21 +76,25 @@ class endpoint_ip{
 
 		bool set(const char* addr_str, std::uint16_t port) noexcept
 		{
+			std::size_t len = std::strlen(addr_str);
+
 			//Check IPv4
-			in_addr_t addr;
-			int ret = inet_pton(AF_INET, addr_str, &addr);
-			if(ret > 0)
+			ipv4_address addr = parse_ipv4(addr_str, len);
+			if(addr.valid)
 			{
-				set(addr, port);
+				in_addr_t addr4;
+				std::memcpy(&addr4, addr.bytes, sizeof(addr4));
+				set(addr4, port);
 				return true;
 			}
 
 			//Check IPv6
-			in6_addr addr6;
-			ret = inet_pton(AF_INET6, addr_str, &addr);
-			if(ret > 0)
+			ipv6_address addr6 = parse_ipv6(addr_str, len);
+			if(addr6.valid)
 			{
-				set(addr6, port);
+				in6_addr addr_in6;
+				std::memcpy(&addr_in6, addr6.bytes, sizeof(addr_in6));
+				set(addr_in6, port);
 				return true;
 			}
 
@@ -99,7 +104,7 @@ class endpoint_ip{
 
 		void set(sa_family_t family, uint16_t port) noexcept
 		{
-			family_ = family;
+			std::memset(&addr_, 0, sizeof(native_type));
 			if(family == AF_INET)
 			{
 				struct sockaddr_in* addr = reinterpret_cast<struct sockaddr_in*>(&addr_);
@@ -117,18 +122,31 @@ class endpoint_ip{
 		}
 
 		native_type* native() noexcept{ return &addr_; }
+		native_type const* native() const noexcept{ return &addr_; }
+
+		/**
+		 * \brief Size of the address (native), by family
+		 */
+		socklen_t size() const noexcept
+		{
+			return family() == AF_INET ?
+					sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6);
+		}
+		void size(socklen_t) noexcept{}
 
 		const char* address(char* addr_str, std::size_t len = INET6_ADDRSTRLEN) const noexcept
 		{
-			if(family_ == AF_INET)
+			if(family() == AF_INET)
 			{
 				struct sockaddr_in const* addr = reinterpret_cast<struct sockaddr_in const*>(&addr_);
-				return inet_ntop(family_, &addr->sin_addr, addr_str, len);
+				return format_ipv4(reinterpret_cast<std::uint8_t const*>(&addr->sin_addr), addr_str, len) ?
+						addr_str : nullptr;
 			}
 			else
 			{
 				struct sockaddr_in6 const* addr = reinterpret_cast<struct sockaddr_in6 const*>(&addr_);
-				return inet_ntop(family_, &addr->sin6_addr, addr_str, len);
+				return format_ipv6(reinterpret_cast<std::uint8_t const*>(&addr->sin6_addr), addr_str, len) ?
+						addr_str : nullptr;
 			}
 		}
 
@@ -151,7 +169,7 @@ class endpoint_ip{
 
 		std::uint16_t port() const noexcept
 		{
-			if(family_ == AF_INET)
+			if(family() == AF_INET)
 			{
 				struct sockaddr_in const* addr = reinterpret_cast<struct sockaddr_in const*>(&addr_);
 				return ntohs(addr->sin_port);
@@ -187,38 +205,26 @@ class endpoint_ip{
 
 		endpoint_ip& operator=(endpoint_ip const& ep) noexcept
 		{
-			family_ = ep.family();
-			if(ep.family() == AF_INET)
-			{
-				struct sockaddr_in* addr = reinterpret_cast<struct sockaddr_in*>(&addr_);
-				addr->sin_family = ep.family();
-				addr->sin_port = ep.port();
-				addr->sin_addr.s_addr = ep.address();
-			}
-			else
-			{
-				struct sockaddr_in6* addr = reinterpret_cast<struct sockaddr_in6*>(&addr_);
-				addr->sin6_family = ep.family();
-				addr->sin6_port = ep.port();
-				std::memcpy(&addr->sin6_addr, &ep.address6(), sizeof(in6_addr));
-			}
+			std::memcpy(&addr_, &ep.addr_, ep.size());
 			return *this;
 		}
 
 		bool operator==(endpoint_ip const& ep) const noexcept
 		{
-			if(family_ != ep.family()) return false;
-			if(family_ == AF_INET)
+			if(family() != ep.family()) return false;
+			if(family() == AF_INET)
 			{
-				struct sockaddr_in const* addr = reinterpret_cast<struct sockaddr_in const*>(&addr_);
-				return addr->sin_port == ep.port() &&
-						addr->sin_addr.s_addr == ep.address();
+				struct sockaddr_in const* lhs = reinterpret_cast<struct sockaddr_in const*>(&addr_);
+				struct sockaddr_in const* rhs = reinterpret_cast<struct sockaddr_in const*>(&ep.addr_);
+				return lhs->sin_port == rhs->sin_port &&
+						lhs->sin_addr.s_addr == rhs->sin_addr.s_addr;
 			}
 			else
 			{
-				struct sockaddr_in6 const* addr = reinterpret_cast<struct sockaddr_in6 const*>(&addr_);
-				return addr->sin6_port == ep.port() &&
-						std::memcmp(&addr->sin6_addr, &ep.address6(), sizeof(in6_addr)) == 0;
+				struct sockaddr_in6 const* lhs = reinterpret_cast<struct sockaddr_in6 const*>(&addr_);
+				struct sockaddr_in6 const* rhs = reinterpret_cast<struct sockaddr_in6 const*>(&ep.addr_);
+				return lhs->sin6_port == rhs->sin6_port &&
+						std::memcmp(&lhs->sin6_addr, &rhs->sin6_addr, sizeof(in6_addr)) == 0;
 			}
 		}
 
@@ -228,7 +234,6 @@ class endpoint_ip{
 		}
 	private:
 		native_type		addr_;
-		sa_family_t		family_ = AF_INET;
 };
 
 }//POSIX
@@ -6,6 +6,7 @@
 #include "../error.hpp"
 
 #include "port.hpp"
+#include "address.hpp"
 
 namespace Soca{
 namespace POSIX{
@@ -41,6 +42,14 @@ class endpoint_ipv4{
 				ec = errc::endpoint_error;
 		}
 
+		/**
+		 * \brief From a (compile time) parsed address
+		 */
+		endpoint_ipv4(ipv4_address const& addr, std::uint16_t port)
+		{
+			set(addr, port);
+		}
+
 		endpoint_ipv4(const endpoint_ipv4&) = default;
 
 		void set(in_addr_t addr, std::uint16_t port) noexcept
@@ -52,17 +61,17 @@ class endpoint_ipv4{
 
 		bool set(const char* addr_str, std::uint16_t port) noexcept
 		{
-			in_addr_t addr;
-			int ret = inet_pton(endpoint_ipv4::ep_family, addr_str, &addr);
-			if(ret <= 0)
-			{
-				std::memset(&addr_, 0, sizeof(native_type));
-				return false;
-			}
+			return set(parse_ipv4(addr_str), port);
+		}
+
+		bool set(ipv4_address const& addr, std::uint16_t port) noexcept
+		{
+			std::memset(&addr_, 0, sizeof(native_type));
+			if(!addr.valid) return false;
 
 			addr_.sin_family = endpoint_ipv4::ep_family;
 			addr_.sin_port = htons(port);
-			addr_.sin_addr.s_addr = addr;
+			std::memcpy(&addr_.sin_addr, addr.bytes, sizeof(addr.bytes));
 
 			return true;
 		}
@@ -75,10 +84,18 @@ class endpoint_ipv4{
 		}
 
 		native_type* native() noexcept{ return &addr_; }
+		native_type const* native() const noexcept{ return &addr_; }
+
+		/**
+		 * \brief Size of the address (native). Fixed.
+		 */
+		socklen_t size() const noexcept{ return sizeof(native_type); }
+		void size(socklen_t) noexcept{}
 
 		const char* address(char* addr_str, std::size_t len = INET_ADDRSTRLEN) const noexcept
 		{
-			return inet_ntop(ep_family, &addr_.sin_addr, addr_str, len);
+			return format_ipv4(reinterpret_cast<std::uint8_t const*>(&addr_.sin_addr), addr_str, len) ?
+					addr_str : nullptr;
 		}
 
 		const char* host(char* host_addr, std::size_t len = INET_ADDRSTRLEN) const noexcept
@@ -86,7 +103,7 @@ class endpoint_ipv4{
 			return address(host_addr, len);
 		}
 
-		in_addr_t address() noexcept{ return addr_.sin_addr.s_addr; }
+		in_addr_t address() const noexcept{ return addr_.sin_addr.s_addr; }
 		std::uint16_t port() const noexcept{ return ntohs(addr_.sin_port); }
 
 		template<typename Handler>
@@ -6,6 +6,7 @@
 #include "../error.hpp"
 
 #include "port.hpp"
+#include "address.hpp"
 
 namespace Soca{
 namespace POSIX{
@@ -46,6 +47,14 @@ class endpoint_ipv6{
 				ec = errc::endpoint_error;
 		}
 
+		/**
+		 * \brief From a (compile time) parsed address
+		 */
+		endpoint_ipv6(ipv6_address const& addr, std::uint16_t port)
+		{
+			set(addr, port);
+		}
+
 		endpoint_ipv6(const endpoint_ipv6&) = default;
 
 		void set(in6_addr const& addr, std::uint16_t port) noexcept
@@ -59,18 +68,17 @@ class endpoint_ipv6{
 
 		bool set(const char* addr_str, std::uint16_t port) noexcept
 		{
-			in6_addr addr;
+			return set(parse_ipv6(addr_str), port);
+		}
+
+		bool set(ipv6_address const& addr, std::uint16_t port) noexcept
+		{
 			std::memset(&addr_, 0, sizeof(native_type));
-			
-			int ret = inet_pton(ep_family, addr_str, &addr);
-			if(ret <= 0)
-			{
-				return false;
-			}
+			if(!addr.valid) return false;
 
 			addr_.sin6_family = ep_family;
 			addr_.sin6_port = htons(port);
-			std::memcpy(&addr_.sin6_addr, &addr, sizeof(in6_addr));
+			std::memcpy(&addr_.sin6_addr, addr.bytes, sizeof(addr.bytes));
 
 			return true;
 		}
@@ -83,10 +91,18 @@ class endpoint_ipv6{
 		}
 
 		native_type* native() noexcept{ return &addr_; }
+		native_type const* native() const noexcept{ return &addr_; }
+
+		/**
+		 * \brief Size of the address (native). Fixed.
+		 */
+		socklen_t size() const noexcept{ return sizeof(native_type); }
+		void size(socklen_t) noexcept{}
 
 		const char* address(char* addr_str, std::size_t len = INET6_ADDRSTRLEN) const noexcept
 		{
-			return inet_ntop(ep_family, &addr_.sin6_addr, addr_str, len);
+			return format_ipv6(reinterpret_cast<std::uint8_t const*>(&addr_.sin6_addr), addr_str, len) ?
+					addr_str : nullptr;
 		}
 		
 		const char* host(char* host_addr, std::size_t len = INET6_ADDRSTRLEN) const noexcept
@@ -94,7 +110,7 @@ class endpoint_ipv6{
 			return address(host_addr, len);
 		}
 
-		in6_addr address() noexcept{ return addr_.sin6_addr; }
+		in6_addr const& address() const noexcept{ return addr_.sin6_addr; }
 		std::uint16_t port() const noexcept{ return ntohs(addr_.sin6_port); }
 
 		template<typename Handler>
@@ -0,0 +1,159 @@
+#ifndef SOCA_POSIX_ENDPOINT_KEY_HPP__
+#define SOCA_POSIX_ENDPOINT_KEY_HPP__
+
+#include <cstring>
+#include <cstdint>
+#include <functional>
+
+#include "port.hpp"
+#include "endpoint_ipv4.hpp"
+#include "endpoint_ipv6.hpp"
+#include "endpoint_ip.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Compact (20 bytes) IP endpoint, to key tables
+ *
+ * IPv4 addresses are stored as IPv4-mapped IPv6 (::ffff:a.b.c.d), and
+ * IPv4-mapped addresses as IPv4, so the same peer has the same key
+ * whatever endpoint type it came from (e.g. a dual stack socket).
+ * Address and port are in network byte order. Padding free: compared
+ * and hashed as raw words.
+ */
+struct endpoint_key{
+	std::uint8_t	addr[16];
+	std::uint16_t	port;		//network byte order
+	std::uint16_t	family;
+
+	endpoint_key() noexcept
+	{
+		std::memset(this, 0, sizeof(endpoint_key));
+	}
+
+	endpoint_key(in_addr_t address, std::uint16_t port_net) noexcept
+	{
+		set(address, port_net);
+	}
+
+	endpoint_key(in6_addr const& address, std::uint16_t port_net) noexcept
+	{
+		set(address, port_net);
+	}
+
+	explicit endpoint_key(endpoint_ipv4 const& ep) noexcept
+	{
+		set(ep.address(), htons(ep.port()));
+	}
+
+	explicit endpoint_key(endpoint_ipv6 const& ep) noexcept
+	{
+		set(ep.address(), htons(ep.port()));
+	}
+
+	explicit endpoint_key(endpoint_ip const& ep) noexcept
+	{
+		if(ep.family() == AF_INET)
+			set(ep.address(), htons(ep.port()));
+		else
+			set(ep.address6(), htons(ep.port()));
+	}
+
+	void set(in_addr_t address, std::uint16_t port_net) noexcept
+	{
+		std::memset(addr, 0, 10);
+		addr[10] = 0xff;
+		addr[11] = 0xff;
+		std::memcpy(addr + 12, &address, sizeof(in_addr_t));
+		port = port_net;
+		family = AF_INET;
+	}
+
+	void set(in6_addr const& address, std::uint16_t port_net) noexcept
+	{
+		std::memcpy(addr, &address, sizeof(addr));
+		port = port_net;
+		/* IPv4 peer at a dual stack socket: same key as from AF_INET */
+		family = IN6_IS_ADDR_V4MAPPED(&address) ? AF_INET : AF_INET6;
+	}
+
+	bool is_ipv4() const noexcept{ return family == AF_INET; }
+
+	in_addr_t address() const noexcept
+	{
+		in_addr_t address;
+		std::memcpy(&address, addr + 12, sizeof(in_addr_t));
+		return address;
+	}
+
+	in6_addr address6() const noexcept
+	{
+		in6_addr address;
+		std::memcpy(&address, addr, sizeof(in6_addr));
+		return address;
+	}
+
+	std::uint16_t host_port() const noexcept{ return ntohs(port); }
+
+	/**
+	 * \brief Back to a endpoint (e.g. to send to the peer)
+	 */
+	endpoint_ip endpoint() const noexcept
+	{
+		return is_ipv4() ?
+				endpoint_ip{address(), host_port()} :
+				endpoint_ip{address6(), host_port()};
+	}
+
+	bool operator==(endpoint_key const& rhs) const noexcept
+	{
+		/* constant size: compiled to a few word compares */
+		return std::memcmp(this, &rhs, sizeof(endpoint_key)) == 0;
+	}
+
+	bool operator!=(endpoint_key const& rhs) const noexcept
+	{
+		return !(*this == rhs);
+	}
+
+	/**
+	 * \brief 64 bits hash
+	 *
+	 * Multiply-xorshift over the key words (not a cryptographic hash:
+	 * peers can choose its address/port. Use a \p seed per table).
+	 */
+	std::uint64_t hash(std::uint64_t seed = 0) const noexcept
+	{
+		std::uint64_t w0, w1;
+		std::uint32_t w2;
+		std::memcpy(&w0, addr, 8);
+		std::memcpy(&w1, addr + 8, 8);
+		std::memcpy(&w2, &port, 4);
+
+		std::uint64_t h = seed ^ 0x9E3779B97F4A7C15ull;
+		h = (h ^ w0) * 0xBF58476D1CE4E5B9ull;
+		h = (h ^ (h >> 31) ^ w1) * 0x94D049BB133111EBull;
+		h = (h ^ (h >> 29) ^ w2) * 0xBF58476D1CE4E5B9ull;
+		return h ^ (h >> 32);
+	}
+};
+
+static_assert(sizeof(endpoint_key) == 20, "endpoint_key must be packed");
+
+}//POSIX
+}//Soca
+
+namespace std{
+
+template<>
+struct hash<Soca::POSIX::endpoint_key>{
+	std::size_t operator()(Soca::POSIX::endpoint_key const& key) const noexcept
+	{
+		return static_cast<std::size_t>(key.hash());
+	}
+};
+
+}//std
+
+#endif /* SOCA_POSIX_ENDPOINT_KEY_HPP__ */
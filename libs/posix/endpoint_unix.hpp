@@ -0,0 +1,218 @@
+#ifndef SOCA_PORT_POSIX_ENDPOINT_UNIX_HPP__
+#define SOCA_PORT_POSIX_ENDPOINT_UNIX_HPP__
+
+#include <cstring>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include "../error.hpp"
+
+#include "port.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Unix domain socket endpoint (AF_UNIX)
+ *
+ * \p StreamType is the socket type used by tcp_server/tcp_client
+ * (SOCK_STREAM or SOCK_SEQPACKET). udp always uses SOCK_DGRAM.
+ *
+ * Filesystem paths must be removed (unlink) before binding again.
+ * Linux abstract names (set_abstract) are not bound to the filesystem,
+ * and are released when the socket is closed.
+ */
+template<int StreamType = SOCK_STREAM>
+class basic_endpoint_unix{
+	public:
+		using native_type = sockaddr_un;
+		static constexpr const sa_family_t ep_family = AF_UNIX;
+		static constexpr const int stream_type = StreamType;
+
+		static constexpr const std::size_t path_offset = offsetof(sockaddr_un, sun_path);
+		static constexpr const std::size_t max_path = sizeof(sockaddr_un::sun_path);
+
+		constexpr sa_family_t family() const noexcept
+		{
+			return ep_family;
+		}
+
+		basic_endpoint_unix()
+		{
+			std::memset(&addr_, 0, sizeof(native_type));
+			addr_.sun_family = ep_family;
+			size_ = path_offset;
+		}
+
+		basic_endpoint_unix(const char* path, Error& ec)
+		{
+			if(!set(path))
+				ec = errc::endpoint_error;
+		}
+
+		basic_endpoint_unix(const basic_endpoint_unix&) = default;
+
+		/**
+		 * \brief Filesystem path
+		 */
+		bool set(const char* path) noexcept
+		{
+			std::size_t len = std::strlen(path);
+			std::memset(&addr_, 0, sizeof(native_type));
+			addr_.sun_family = ep_family;
+			if(len == 0 || len >= max_path)
+			{
+				size_ = path_offset;
+				return false;
+			}
+
+			std::memcpy(addr_.sun_path, path, len);
+			size_ = static_cast<socklen_t>(path_offset + len + 1);
+			return true;
+		}
+
+#if defined(__linux__)
+		/**
+		 * \brief Linux abstract namespace. \p name does not need to be
+		 * null terminated (all \p len bytes are the name).
+		 */
+		bool set_abstract(const char* name, std::size_t len) noexcept
+		{
+			std::memset(&addr_, 0, sizeof(native_type));
+			addr_.sun_family = ep_family;
+			if(len == 0 || len >= max_path)
+			{
+				size_ = path_offset;
+				return false;
+			}
+
+			std::memcpy(addr_.sun_path + 1, name, len);
+			size_ = static_cast<socklen_t>(path_offset + 1 + len);
+			return true;
+		}
+#endif /* defined(__linux__) */
+
+		bool is_abstract() const noexcept
+		{
+			return size_ > path_offset && addr_.sun_path[0] == '\0';
+		}
+
+		/**
+		 * \brief Unnamed (e.g. peer of a client not bound)
+		 */
+		bool is_unnamed() const noexcept
+		{
+			return size_ <= path_offset;
+		}
+
+		/**
+		 * \brief Path (or abstract name) and its length
+		 */
+		const char* path() const noexcept
+		{
+			return is_abstract() ? addr_.sun_path + 1 : addr_.sun_path;
+		}
+
+		std::size_t path_size() const noexcept
+		{
+			if(is_unnamed()) return 0;
+			if(is_abstract()) return size_ - path_offset - 1;
+			return ::strnlen(addr_.sun_path, size_ - path_offset);
+		}
+
+		native_type* native() noexcept{ return &addr_; }
+		native_type const* native() const noexcept{ return &addr_; }
+
+		/**
+		 * \brief Size of the address (native) in use
+		 */
+		socklen_t size() const noexcept{ return size_; }
+		void size(socklen_t size) noexcept
+		{
+			size_ = size > sizeof(native_type) ? sizeof(native_type) : size;
+		}
+
+		/**
+		 * \brief Path as string. Abstract names are prefixed with '@'
+		 */
+		const char* address(char* addr_str, std::size_t len = max_path + 1) const noexcept
+		{
+			std::size_t size = path_size(), offset = 0;
+			if(len == 0) return nullptr;
+			if(is_abstract() && len > 1) addr_str[offset++] = '@';
+			if(size > len - offset - 1) size = len - offset - 1;
+			std::memcpy(addr_str + offset, path(), size);
+			addr_str[offset + size] = '\0';
+			return addr_str;
+		}
+
+		const char* host(char* host_addr, std::size_t len = max_path + 1) const noexcept
+		{
+			return address(host_addr, len);
+		}
+
+		/**
+		 * \brief Removes the filesystem path (do nothing to abstract names)
+		 */
+		bool unlink() const noexcept
+		{
+			if(is_unnamed() || is_abstract()) return true;
+			return ::unlink(addr_.sun_path) == 0 || errno == ENOENT;
+		}
+
+		template<typename Handler>
+		bool copy_sock_address(Handler socket) noexcept
+		{
+			socklen_t size = sizeof(native_type);
+			if(::getsockname(socket,
+					reinterpret_cast<sockaddr*>(&addr_),
+					&size) == -1)
+				return false;
+			this->size(size);
+			return true;
+		}
+
+		template<typename Handler>
+		bool copy_peer_address(Handler socket) noexcept
+		{
+			socklen_t size = sizeof(native_type);
+			if(::getpeername(socket,
+					reinterpret_cast<sockaddr*>(&addr_),
+					&size) == -1)
+				return false;
+			this->size(size);
+			return true;
+		}
+
+		basic_endpoint_unix& operator=(basic_endpoint_unix const& ep) noexcept
+		{
+			std::memcpy(&addr_, &ep.addr_, sizeof(native_type));
+			size_ = ep.size_;
+			return *this;
+		}
+
+		bool operator==(basic_endpoint_unix const& ep) const noexcept
+		{
+			/* unnamed: size 0 or just the family (recvfrom of a unbound peer) */
+			if(is_unnamed() || ep.is_unnamed())
+				return is_unnamed() && ep.is_unnamed();
+			return size_ == ep.size_ &&
+					std::memcmp(addr_.sun_path, ep.addr_.sun_path, size_ - path_offset) == 0;
+		}
+
+		bool operator!=(basic_endpoint_unix const& ep) const noexcept
+		{
+			return !(*this == ep);
+		}
+	private:
+		native_type		addr_;
+		socklen_t		size_;
+};
+
+using endpoint_unix = basic_endpoint_unix<SOCK_STREAM>;
+using endpoint_unix_seqpacket = basic_endpoint_unix<SOCK_SEQPACKET>;
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_PORT_POSIX_ENDPOINT_UNIX_HPP__ */
@@ -0,0 +1,65 @@
+#include "executor.hpp"
+
+#if SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1
+
+#include "port.hpp"
+
+#include <cerrno>
+
+namespace Soca{
+namespace POSIX{
+
+executor::executor()
+	: epoll_fd_(0){}
+
+executor::~executor()
+{
+	if(is_open()) close();
+}
+
+void executor::open(Error& ec) noexcept
+{
+	epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+	if(epoll_fd_ == -1)
+	{
+		epoll_fd_ = 0;
+		ec = errc::socket_error;
+	}
+}
+
+bool executor::is_open() const noexcept
+{
+	return epoll_fd_ != 0;
+}
+
+void executor::close() noexcept
+{
+	if(epoll_fd_) ::close(epoll_fd_);
+	epoll_fd_ = 0;
+}
+
+bool executor::wait(io_operation* op) noexcept
+{
+	struct epoll_event ev;
+	ev.events = op->events | EPOLLONESHOT;
+	ev.data.ptr = op;
+	/**
+	 * Sockets stay registered (disabled by EPOLLONESHOT) after the
+	 * operation completes, so next operations just rearm.
+	 */
+	if(::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, op->socket, &ev) == 0)
+		return true;
+	if(errno == ENOENT && ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, op->socket, &ev) == 0)
+		return true;
+	return false;
+}
+
+void executor::remove(int socket) noexcept
+{
+	::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket, NULL);
+}
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1 */
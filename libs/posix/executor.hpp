@@ -0,0 +1,83 @@
+#ifndef SOCA_POSIX_EXECUTOR_HPP__
+#define SOCA_POSIX_EXECUTOR_HPP__
+
+#if SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1
+
+#include <cstdlib>
+#include <cstdint>
+#include <coroutine>
+#include <exception>
+
+#include "../error.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief A operation waiting for a socket to be ready
+ *
+ * \p perform tries to complete the operation, returning true if done
+ * (successfully or not). Lives inside the awaiter, at the coroutine frame.
+ * \p failed is set if the executor couldn't wait for the socket.
+ */
+struct io_operation{
+	bool					(*perform)(io_operation*) noexcept;
+	std::coroutine_handle<>	waiter;
+	int						socket;
+	std::uint32_t			events;
+	bool					failed = false;
+};
+
+/**
+ * \brief Resumes coroutines waiting for sockets (epoll)
+ *
+ * Only one operation may wait for each socket at a time.
+ */
+class executor{
+	public:
+		executor();
+		~executor();
+
+		void open(Error&) noexcept;
+		bool is_open() const noexcept;
+		void close() noexcept;
+
+		/**
+		 * \brief Waits for events and resumes the coroutines of the
+		 * completed operations.
+		 *
+		 * \tparam BlockTimeMs 0 (no block), -1 (blocks indefinitely)
+		 */
+		template<int BlockTimeMs = -1,
+				unsigned MaxEvents = 32>
+		bool run(Error&) noexcept;
+
+		bool wait(io_operation*) noexcept;
+		void remove(int socket) noexcept;
+	private:
+		int epoll_fd_;
+};
+
+/**
+ * \brief Detached coroutine
+ *
+ * Starts running at creation; the frame is destroyed when it finishes.
+ */
+struct task{
+	struct promise_type{
+		task get_return_object() noexcept{ return {}; }
+		std::suspend_never initial_suspend() noexcept{ return {}; }
+		std::suspend_never final_suspend() noexcept{ return {}; }
+		void return_void() noexcept{}
+		void unhandled_exception() noexcept{ std::terminate(); }
+	};
+};
+
+}//POSIX
+}//Soca
+
+#include "impl/executor_impl.hpp"
+
+#endif /* SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1 */
+
+#endif /* SOCA_POSIX_EXECUTOR_HPP__ */
@@ -0,0 +1,96 @@
+#ifndef SOCA_POSIX_FLOW_TABLE_HPP__
+#define SOCA_POSIX_FLOW_TABLE_HPP__
+
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "endpoint_key.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Fixed capacity open addressing table, keyed by endpoint_key
+ *
+ * Linear probing over a separated array of 32 bits tags (part of the
+ * hash), so a lookup touches one or two cache lines of tags before
+ * comparing any key. Erase shifts the following entries back (no
+ * tombstones), so lookups don't degrade with churn.
+ *
+ * Not resized: insert fails (nullptr) when the table is 7/8 full.
+ * \p Value must be default constructible and move assignable.
+ * Pointers returned are valid until the next insert/erase.
+ */
+template<typename Value>
+class flow_table{
+	public:
+		using key_type = endpoint_key;
+		using value_type = Value;
+
+		/**
+		 * \param capacity maximum number of flows
+		 * \param seed hash seed (e.g. random at start)
+		 */
+		explicit flow_table(std::size_t capacity, std::uint64_t seed = 0);
+
+		flow_table(flow_table const&) = delete;
+		flow_table& operator=(flow_table const&) = delete;
+
+		Value* find(endpoint_key const&) noexcept;
+		/**
+		 * \brief Returns the value of \p key, inserting a default one
+		 * if not found. nullptr if the table is full.
+		 */
+		Value* insert(endpoint_key const&, bool& inserted) noexcept;
+		Value* insert(endpoint_key const&) noexcept;
+		bool erase(endpoint_key const&) noexcept;
+		void clear() noexcept;
+
+		/**
+		 * \brief Calls \p func(endpoint_key const&, Value&) for each flow
+		 */
+		template<typename Func>
+		void for_each(Func&& func) noexcept;
+
+		/**
+		 * \brief Erases the flows where \p pred(endpoint_key const&, Value&)
+		 * is true. Returns the number erased.
+		 */
+		template<typename Pred>
+		std::size_t erase_if(Pred&& pred) noexcept;
+
+		std::size_t size() const noexcept{ return size_; }
+		std::size_t capacity() const noexcept{ return max_size_; }
+		bool full() const noexcept{ return size_ >= max_size_; }
+	private:
+		struct entry{
+			endpoint_key	key;
+			Value			value;
+		};
+
+		static constexpr const std::uint32_t used_bit = 0x80000000u;
+
+		std::uint32_t tag(endpoint_key const& key) const noexcept
+		{
+			return static_cast<std::uint32_t>(key.hash(seed_)) | used_bit;
+		}
+
+		std::size_t lookup(endpoint_key const&, std::uint32_t tag) const noexcept;
+		void erase_at(std::size_t index) noexcept;
+
+		std::unique_ptr<std::uint32_t[]>	tags_;
+		std::unique_ptr<entry[]>			entries_;
+		std::size_t		mask_;
+		std::size_t		size_ = 0;
+		std::size_t		max_size_;
+		std::uint64_t	seed_;
+};
+
+}//POSIX
+}//Soca
+
+#include "impl/flow_table_impl.hpp"
+
+#endif /* SOCA_POSIX_FLOW_TABLE_HPP__ */
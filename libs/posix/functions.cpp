@@ -4,6 +4,12 @@
 #include "functions.hpp"
 #include "port.hpp"
 
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#endif /* defined(__linux__) */
+
 namespace Soca{
 namespace POSIX{
 
@@ -21,6 +27,68 @@ bool init() noexcept
 }
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
 
+#if defined(__linux__)
+bool parse_timestamp(struct msghdr const& msg, timestamp& ts) noexcept
+{
+	ts = timestamp{};
+	/* control data truncated: the timestamps may be missing */
+	if(msg.msg_flags & MSG_CTRUNC) return false;
+
+	for(struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+		cm;
+		cm = CMSG_NXTHDR(const_cast<struct msghdr*>(&msg), cm))
+	{
+		if(cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_TIMESTAMPING)
+		{
+			struct scm_timestamping tss;
+			std::memcpy(&tss, CMSG_DATA(cm), sizeof(tss));
+			ts.software = tss.ts[0];
+			ts.hardware = tss.ts[2];
+		}
+		else if((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+				|| (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+		{
+			struct sock_extended_err err;
+			std::memcpy(&err, CMSG_DATA(cm), sizeof(err));
+			if(err.ee_origin == SO_EE_ORIGIN_TIMESTAMPING)
+				ts.id = err.ee_data;
+		}
+	}
+	return true;
+}
+#endif /* defined(__linux__) */
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+void parse_packet_info(struct msghdr const& msg, packet_info& info) noexcept
+{
+	for(struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+		cm;
+		cm = CMSG_NXTHDR(const_cast<struct msghdr*>(&msg), cm))
+	{
+#if defined(IP_PKTINFO)
+		if(cm->cmsg_level == IPPROTO_IP && cm->cmsg_type == IP_PKTINFO)
+		{
+			struct in_pktinfo pi;
+			std::memcpy(&pi, CMSG_DATA(cm), sizeof(pi));
+			info.family = AF_INET;
+			info.interface = static_cast<unsigned>(pi.ipi_ifindex);
+			info.address = pi.ipi_spec_dst;
+		}
+#endif /* defined(IP_PKTINFO) */
+#if defined(IPV6_RECVPKTINFO)
+		if(cm->cmsg_level == IPPROTO_IPV6 && cm->cmsg_type == IPV6_PKTINFO)
+		{
+			struct in6_pktinfo pi;
+			std::memcpy(&pi, CMSG_DATA(cm), sizeof(pi));
+			info.family = AF_INET6;
+			info.interface = pi.ipi6_ifindex;
+			info.address6 = pi.ipi6_addr;
+		}
+#endif /* defined(IPV6_RECVPKTINFO) */
+	}
+}
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+
 }//POSIX
 }//Soca
 
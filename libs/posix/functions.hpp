@@ -1,6 +1,19 @@
 #ifndef SOCA_POSIX_SOCKET_FUNCTIONS_HPP__
 #define SOCA_POSIX_SOCKET_FUNCTIONS_HPP__
 
+#include <cstdlib>
+
+#if defined(__linux__)
+#include <cstdint>
+#include <ctime>
+#endif /* defined(__linux__) */
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+
 namespace Soca{
 namespace POSIX{
 
@@ -12,6 +25,135 @@ inline bool init() noexcept{ return true; }
 
 template<typename Handler>
 bool nonblock_socket(Handler socket);
+template<typename Handler>
+bool block_socket(Handler socket);
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+/**
+ * \brief Passes the descriptor \p fd to the peer of the Unix socket
+ * \p socket (SCM_RIGHTS), with \p data. The descriptor stays open at
+ * this process.
+ *
+ * At least one byte is sent (a zero byte if \p len is 0).
+ */
+template<typename Handler>
+bool send_fd(Handler socket, int fd,
+		const void* data = nullptr, std::size_t len = 0) noexcept;
+
+/**
+ * \brief Receives a descriptor sent with send_fd (close-on-exec set).
+ * Returns -1 if none was received. \p len is updated with the data size.
+ */
+template<typename Handler>
+int receive_fd(Handler socket, void* data, std::size_t& len) noexcept;
+template<typename Handler>
+int receive_fd(Handler socket) noexcept;
+
+/**
+ * \brief Local address and interface of a datagram (IP_PKTINFO,
+ * IPV6_RECVPKTINFO)
+ *
+ * Received, it is where the datagram arrived: the local address (at
+ * broadcast/multicast, the address of the interface) and the interface
+ * index. Sent, the datagram leaves from \p address, and from \p interface
+ * if not 0 (link-local IPv6 needs it). Passing the info received, the
+ * reply leaves from the address the request came, at hosts with many
+ * addresses.
+ *
+ * IPv4 datagrams at a IPv6 socket have IPv4-mapped addresses.
+ */
+struct packet_info{
+	sa_family_t		family = 0;		//AF_INET, AF_INET6; 0: none
+	unsigned		interface = 0;
+	struct in_addr	address = {};
+	struct in6_addr	address6 = {};
+};
+
+/**
+ * \brief Enables the packet info of the datagrams received, as the
+ * socket family. Returns false if not supported.
+ */
+template<typename Handler>
+bool enable_packet_info(Handler socket) noexcept;
+
+/**
+ * \brief recvmsg, getting the packet info
+ *
+ * \p info.family is 0 if not received. Returns recvmsg return
+ */
+template<typename Handler>
+ssize_t receive_packet_info(Handler socket,
+		void* buffer, std::size_t buffer_len,
+		void* addr, socklen_t* addr_len,
+		packet_info& info) noexcept;
+
+/**
+ * \brief sendmsg from the address/interface of \p info (if its family
+ * is set). Returns sendmsg return
+ */
+template<typename Handler>
+ssize_t send_packet_info(Handler socket,
+		const void* buffer, std::size_t buffer_len,
+		const void* addr, socklen_t addr_len,
+		packet_info const& info) noexcept;
+
+void parse_packet_info(struct msghdr const&, packet_info&) noexcept;
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+
+#if defined(__linux__)
+/**
+ * \brief Kernel timestamps (SO_TIMESTAMPING)
+ *
+ * \p software and \p hardware are zero if not reported. \p id identifies
+ * the packet of a TX timestamp (UDP: packet count, TCP: byte offset of
+ * the end of the send timestamped).
+ */
+struct timestamp{
+	struct timespec		software = {0, 0};
+	struct timespec		hardware = {0, 0};
+	std::uint32_t		id = 0;
+};
+
+/**
+ * enable_timestamping flags
+ */
+static constexpr const unsigned timestamp_rx		= 1 << 0;
+static constexpr const unsigned timestamp_tx		= 1 << 1;
+/**
+ * Also requests hardware timestamps. The NIC must support and have
+ * it enabled (SIOCSHWTSTAMP)
+ */
+static constexpr const unsigned timestamp_hardware	= 1 << 2;
+
+template<typename Handler>
+bool enable_timestamping(Handler socket, unsigned flags) noexcept;
+
+/**
+ * \brief recvmsg, getting the RX timestamp
+ *
+ * Returns recvmsg return. \p ts is zero if not reported (or the control
+ * data was truncated).
+ */
+template<typename Handler>
+ssize_t receive_timestamp(Handler socket,
+		void* buffer, std::size_t buffer_len,
+		void* addr, socklen_t* addr_len,
+		timestamp&) noexcept;
+
+/**
+ * \brief Reads a TX timestamp from the socket error queue
+ *
+ * Returns false if there is none, or it was truncated (read, \p ts zero).
+ */
+template<typename Handler>
+bool read_tx_timestamp(Handler socket, timestamp&) noexcept;
+
+/**
+ * \brief Timestamps of the control data of \p msg (\p ts zeroed first).
+ * Returns false if the control data was truncated (MSG_CTRUNC).
+ */
+bool parse_timestamp(struct msghdr const&, timestamp&) noexcept;
+#endif /* defined(__linux__) */
 
 }//POSIX
 }//Soca
@@ -0,0 +1,112 @@
+#include "handoff.hpp"
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "functions.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * Fixed size: at stream sockets each record is read whole, whatever
+ * the state size
+ */
+struct handoff_record{
+	std::uint32_t	kind;
+	std::uint32_t	size;
+	std::uint8_t	state[SOCA_HANDOFF_STATE_MAX];
+};
+
+bool handoff_send(int unix_socket, handoff_kind kind, int fd,
+		const void* state /* = nullptr */, std::size_t len /* = 0 */) noexcept
+{
+	if(len > SOCA_HANDOFF_STATE_MAX) return false;
+
+	handoff_record record = {};
+	record.kind = static_cast<std::uint32_t>(kind);
+	record.size = static_cast<std::uint32_t>(len);
+	if(len) std::memcpy(record.state, state, len);
+	return send_fd(unix_socket, fd, &record, sizeof(record));
+}
+
+bool handoff_end(int unix_socket) noexcept
+{
+	handoff_record record = {};
+	record.kind = static_cast<std::uint32_t>(handoff_kind::end);
+
+	ssize_t size;
+	do size = ::send(unix_socket, &record, sizeof(record), MSG_NOSIGNAL);
+	while(size == -1 && errno == EINTR);
+	return size == static_cast<ssize_t>(sizeof(record));
+}
+
+int handoff_receive(int unix_socket, handoff_kind& kind,
+		void* state, std::size_t& len, Error& ec) noexcept
+{
+	handoff_record record;
+	std::size_t size = sizeof(record);
+	int fd = receive_fd(unix_socket, &record, size);
+	if(size == 0)
+	{
+		ec = errc::socket_receive;
+		return -1;
+	}
+	/* rest of the record (the descriptor comes with the first byte) */
+	while(size < sizeof(record))
+	{
+		ssize_t bytes = ::recv(unix_socket,
+				reinterpret_cast<std::uint8_t*>(&record) + size,
+				sizeof(record) - size, MSG_WAITALL);
+		if(bytes <= 0 && !(bytes == -1 && errno == EINTR))
+		{
+			if(fd != -1) ::close(fd);
+			ec = errc::socket_receive;
+			return -1;
+		}
+		if(bytes > 0) size += static_cast<std::size_t>(bytes);
+	}
+
+	kind = static_cast<handoff_kind>(record.kind);
+	if(kind == handoff_kind::end)
+	{
+		if(fd != -1) ::close(fd);
+		len = 0;
+		return -1;
+	}
+
+	if(fd == -1 || record.size > SOCA_HANDOFF_STATE_MAX
+		|| (kind != handoff_kind::listener && kind != handoff_kind::connection))
+	{
+		if(fd != -1) ::close(fd);
+		ec = errc::invalid_data;
+		return -1;
+	}
+
+	if(record.size > len)
+	{
+		::close(fd);
+		ec = errc::insufficient_buffer;
+		return -1;
+	}
+	len = record.size;
+	if(len) std::memcpy(state, record.state, len);
+	return fd;
+}
+
+int handoff_receive(int unix_socket, handoff_kind& kind, Error& ec) noexcept
+{
+	/* state discarded */
+	std::uint8_t state[SOCA_HANDOFF_STATE_MAX];
+	std::size_t len = sizeof(state);
+	return handoff_receive(unix_socket, kind, state, len, ec);
+}
+
+}//POSIX
+}//Soca
+
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
@@ -0,0 +1,71 @@
+#ifndef SOCA_POSIX_HANDOFF_HPP__
+#define SOCA_POSIX_HANDOFF_HPP__
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+
+#include <cstdlib>
+#include <cstdint>
+#include "../error.hpp"
+
+/**
+ * Maximum application state sent with each descriptor
+ */
+#ifndef SOCA_HANDOFF_STATE_MAX
+#define SOCA_HANDOFF_STATE_MAX		256
+#endif /* SOCA_HANDOFF_STATE_MAX */
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * Hot restart: the old process passes its listening sockets (and,
+ * optionally, idle connections) to the new one over a connected Unix
+ * socket (endpoint_unix), with SCM_RIGHTS. Both share the listening
+ * socket while the old drains: connections at the backlog are accepted
+ * by the new process, none refused.
+ *
+ * Old process:
+ * * handoff_send(unix_socket, handoff_kind::listener, server.native())
+ * * connection_drain::hand_off (idle connections), or handoff_send each
+ * * handoff_end(unix_socket); then server.pause(server.native()) and drain
+ *
+ * New process:
+ * * handoff_receive until handoff_kind::end
+ * * tcp_server::assign(fd) for listeners, tcp_server::adopt(fd, ec) for
+ * connections
+ */
+enum class handoff_kind : std::uint32_t{
+	listener = 1,
+	connection,
+	end
+};
+
+/**
+ * \brief Passes \p fd (kept open at this process) and \p len bytes of
+ * application state (up to SOCA_HANDOFF_STATE_MAX) to the peer
+ */
+bool handoff_send(int unix_socket, handoff_kind, int fd,
+		const void* state = nullptr, std::size_t len = 0) noexcept;
+/**
+ * \brief Tells the peer nothing more will be sent
+ */
+bool handoff_end(int unix_socket) noexcept;
+/**
+ * \brief Receives a descriptor sent with handoff_send. \p len is the
+ * size of \p state as input, the state received as output.
+ *
+ * Returns -1 at the end (\p kind handoff_kind::end) or at error (\p ec set).
+ */
+int handoff_receive(int unix_socket, handoff_kind& kind,
+		void* state, std::size_t& len, Error&) noexcept;
+/**
+ * \brief Same, discarding the state
+ */
+int handoff_receive(int unix_socket, handoff_kind& kind, Error&) noexcept;
+
+}//POSIX
+}//Soca
+
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+
+#endif /* SOCA_POSIX_HANDOFF_HPP__ */
@@ -0,0 +1,360 @@
+#ifndef SOCA_POSIX_ADMISSION_IMPL_HPP__
+#define SOCA_POSIX_ADMISSION_IMPL_HPP__
+
+#include "../admission.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+namespace Soca{
+namespace POSIX{
+
+template<class Server>
+admission_control<Server>::
+admission_control(Server& srv, config const& cfg /* = config{} */, std::uint64_t seed /* = 0 */)
+	: server_(srv), config_(cfg),
+	  sources_(cfg.max_per_source ? cfg.max_sources : 1, seed)
+{
+	accept_.tokens = config_.accept_burst;
+	accept_.last_ns = now_ns();
+}
+
+template<class Server>
+typename admission_control<Server>::connection*
+admission_control<Server>::
+find(handler socket) noexcept
+{
+	std::size_t fd = static_cast<std::size_t>(socket);
+	if(fd >= conns_.size() || !conns_[fd].active) return nullptr;
+	return &conns_[fd];
+}
+
+template<class Server>
+bool
+admission_control<Server>::
+source_of(handler socket, endpoint_key& key) const noexcept
+{
+	sockaddr_storage addr;
+	socklen_t size = sizeof(addr);
+	if(::getpeername(socket, reinterpret_cast<sockaddr*>(&addr), &size) == -1)
+		return false;
+
+	/* port 0: all connections of the address */
+	if(addr.ss_family == AF_INET)
+		key.set(reinterpret_cast<sockaddr_in const*>(&addr)->sin_addr.s_addr, 0);
+	else if(addr.ss_family == AF_INET6)
+		key.set(reinterpret_cast<sockaddr_in6 const*>(&addr)->sin6_addr, 0);
+	else
+		return false;
+	return true;
+}
+
+template<class Server>
+bool
+admission_control<Server>::
+admit(handler socket) noexcept
+{
+	std::uint64_t now = now_ns();
+	bool ok = true;
+	if(config_.max_connections && connections_ >= config_.max_connections)
+		ok = false;
+	else if(config_.accept_rate > 0)
+	{
+		accept_.refill(now, config_.accept_rate, config_.accept_burst);
+		ok = accept_.tokens >= 1;
+	}
+
+	endpoint_key key;
+	bool has_source = false;
+	if(ok && config_.max_per_source && source_of(socket, key))
+	{
+		std::uint32_t* count = sources_.insert(key);
+		if(!count || *count >= config_.max_per_source)
+			ok = false;
+		else
+		{
+			++*count;
+			has_source = true;
+		}
+	}
+
+	/* out of memory: refused */
+	std::size_t fd = static_cast<std::size_t>(socket);
+	if(ok && fd >= conns_.size())
+	{
+		try{
+			conns_.resize(fd + 1);
+		}catch(...){
+			ok = false;
+		}
+	}
+
+	if(!ok)
+	{
+		if(has_source)
+		{
+			std::uint32_t* count = sources_.find(key);
+			if(count && --*count == 0) sources_.erase(key);
+		}
+		rejected_++;
+		SOCA_METRIC_ADD(admission_rejects, 1);
+		server_.close_client(socket);
+		update_listener(now);
+		return false;
+	}
+
+	connection& conn = conns_[fd];
+	conn.read.tokens = config_.read_burst;
+	conn.read.last_ns = now;
+	conn.paused_ns = 0;
+	conn.source = key;
+	conn.has_source = has_source;
+	conn.active = true;
+
+	connections_++;
+	if(config_.accept_rate > 0) accept_.tokens -= 1;
+	update_listener(now);
+	return true;
+}
+
+template<class Server>
+void
+admission_control<Server>::
+release(handler socket) noexcept
+{
+	connection* conn = find(socket);
+	if(!conn) return;
+
+	if(conn->has_source)
+	{
+		std::uint32_t* count = sources_.find(conn->source);
+		if(count && --*count == 0) sources_.erase(conn->source);
+	}
+	/* entries at the queues are invalid now (skipped) */
+	conn->active = false;
+	conn->paused_ns = 0;
+	connections_--;
+	update_listener(now_ns());
+}
+
+template<class Server>
+std::size_t
+admission_control<Server>::
+receive(handler socket, void* buffer, std::size_t len, Error& ec) noexcept
+{
+	connection* conn = find(socket);
+	if(!conn) return server_.receive(socket, buffer, len, ec);
+	/* event queued before the pause */
+	if(conn->paused_ns) return 0;
+
+	/* pause failed: read anyway, or the edge (EPOLLET) is lost */
+	std::uint64_t now = now_ns();
+	if(overload_ && pause(socket, *conn, now, held_, now))
+		return 0;
+
+	if(config_.read_rate > 0)
+	{
+		conn->read.refill(now, config_.read_rate, config_.read_burst);
+		if(conn->read.tokens < 1)
+		{
+			if(pause(socket, *conn, now, throttled_,
+					now + conn->read.wait_ns(config_.read_burst / 2, config_.read_rate)))
+				return 0;
+		}
+		else if(static_cast<double>(len) > conn->read.tokens)
+			len = static_cast<std::size_t>(conn->read.tokens);
+	}
+
+	std::size_t size = server_.receive(socket, buffer, len, ec);
+	if(size && config_.read_rate > 0) consume(socket, size);
+	return size;
+}
+
+template<class Server>
+bool
+admission_control<Server>::
+consume(handler socket, std::size_t bytes) noexcept
+{
+	connection* conn = find(socket);
+	if(!conn || config_.read_rate <= 0) return true;
+	if(conn->paused_ns) return false;
+
+	std::uint64_t now = now_ns();
+	conn->read.refill(now, config_.read_rate, config_.read_burst);
+	conn->read.tokens -= static_cast<double>(bytes);
+	if(conn->read.tokens >= 1) return true;
+
+	return !pause(socket, *conn, now, throttled_,
+			now + conn->read.wait_ns(config_.read_burst / 2, config_.read_rate));
+}
+
+template<class Server>
+bool
+admission_control<Server>::
+pause(handler socket, connection& conn, std::uint64_t now,
+		std::vector<waiting>& queue, std::uint64_t due) noexcept
+{
+	try{
+		queue.reserve(queue.size() + 1);
+	}catch(...){
+		return false;
+	}
+	Error ec;
+	if(!server_.pause(socket, ec)) return false;
+	conn.paused_ns = now;
+	queue.push_back(waiting{socket, now, due});
+	std::push_heap(queue.begin(), queue.end(), later{});
+	SOCA_METRIC_ADD(admission_pauses, 1);
+	return true;
+}
+
+template<class Server>
+bool
+admission_control<Server>::
+valid(waiting const& w) const noexcept
+{
+	std::size_t fd = static_cast<std::size_t>(w.socket);
+	return fd < conns_.size() && conns_[fd].active && conns_[fd].paused_ns == w.paused_ns;
+}
+
+template<class Server>
+void
+admission_control<Server>::
+prune(std::vector<waiting>& queue) noexcept
+{
+	while(!queue.empty() && !valid(queue.front()))
+	{
+		std::pop_heap(queue.begin(), queue.end(), later{});
+		queue.pop_back();
+	}
+}
+
+template<class Server>
+bool
+admission_control<Server>::
+resume(std::vector<waiting>& queue, std::uint64_t now) noexcept
+{
+	std::pop_heap(queue.begin(), queue.end(), later{});
+	waiting w = queue.back();
+	queue.pop_back();
+	if(!valid(w)) return false;
+
+	conns_[static_cast<std::size_t>(w.socket)].paused_ns = 0;
+	Error ec;
+	server_.resume(w.socket, ec);
+
+	std::uint64_t delay = now - w.paused_ns;
+	SOCA_METRIC_RECORD(admission_wait, delay);
+	/* EWMA, 1/8 */
+	delay_ns_ = delay_ns_ - delay_ns_ / 8 + delay / 8;
+	return true;
+}
+
+template<class Server>
+void
+admission_control<Server>::
+update_listener(std::uint64_t now) noexcept
+{
+	bool full = overload_
+			|| (config_.max_connections && connections_ >= config_.max_connections)
+			|| (config_.accept_rate > 0 && accept_.tokens < 1);
+
+	Error ec;
+	if(full && listener_paused_ns_ == 0)
+	{
+		if(server_.pause(server_.native(), ec))
+			listener_paused_ns_ = now;
+	}
+	else if(!full && listener_paused_ns_ != 0)
+	{
+		if(server_.resume(server_.native(), ec))
+			listener_paused_ns_ = 0;
+	}
+}
+
+template<class Server>
+int
+admission_control<Server>::
+process() noexcept
+{
+	std::uint64_t now = now_ns();
+	if(config_.accept_rate > 0)
+		accept_.refill(now, config_.accept_rate, config_.accept_burst);
+	update_listener(now);
+
+	prune(held_);
+	prune(throttled_);
+	if(overload_)
+		return held_.empty() && throttled_.empty() && listener_paused_ns_ == 0 ? -1 : 1;
+
+	unsigned resumed = 0;
+	while(!held_.empty() && resumed < config_.resume_batch)
+		if(resume(held_, now)) resumed++;
+	while(!throttled_.empty() && throttled_.front().due_ns <= now
+			&& resumed < config_.resume_batch)
+		if(resume(throttled_, now)) resumed++;
+	prune(held_);
+	prune(throttled_);
+
+	/* next due */
+	std::uint64_t due = ~std::uint64_t(0);
+	if(!held_.empty()) due = now;
+	if(!throttled_.empty() && throttled_.front().due_ns < due)
+		due = throttled_.front().due_ns;
+	if(listener_paused_ns_ && config_.accept_rate > 0 && accept_.tokens < 1
+		&& !(config_.max_connections && connections_ >= config_.max_connections))
+	{
+		std::uint64_t accept_due = now + accept_.wait_ns(1, config_.accept_rate);
+		if(accept_due < due) due = accept_due;
+	}
+
+	if(due == ~std::uint64_t(0)) return -1;
+	if(due <= now) return 0;
+	return static_cast<int>((due - now + 999999) / 1000000);
+}
+
+template<class Server>
+void
+admission_control<Server>::
+overload(bool on) noexcept
+{
+	overload_ = on;
+	update_listener(now_ns());
+}
+
+template<class Server>
+std::uint64_t
+admission_control<Server>::
+queue_delay_ns() const noexcept
+{
+	std::uint64_t now = now_ns();
+	std::uint64_t delay = delay_ns_;
+	auto oldest = [&](std::uint64_t since){
+		if(since && now > since && now - since > delay) delay = now - since;
+	};
+	/* held: due at the pause; throttled: by due, not by pause */
+	if(!held_.empty()) oldest(held_.front().paused_ns);
+	for(waiting const& w : throttled_)
+		if(valid(w)) oldest(w.paused_ns);
+	if(listener_paused_ns_ && accept_queue()) oldest(listener_paused_ns_);
+	return delay;
+}
+
+template<class Server>
+std::size_t
+admission_control<Server>::
+accept_queue() const noexcept
+{
+#if defined(__linux__)
+	/* listening socket: unacked is the accept queue length */
+	tcp_stats stats;
+	if(read_tcp_stats(server_.native(), stats))
+		return stats.unacked;
+#endif /* defined(__linux__) */
+	return 0;
+}
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_POSIX_ADMISSION_IMPL_HPP__ */
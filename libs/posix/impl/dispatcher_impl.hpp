@@ -0,0 +1,129 @@
+#ifndef SOCA_POSIX_DISPATCHER_IMPL_HPP__
+#define SOCA_POSIX_DISPATCHER_IMPL_HPP__
+
+#include "../dispatcher.hpp"
+
+#include <type_traits>
+#include <thread>
+
+namespace Soca{
+namespace POSIX{
+
+template<class Server,
+		typename ReadCb,
+		typename CloseCb>
+dispatcher<Server, ReadCb, CloseCb>::
+dispatcher(Server& server, thread_pool& pool,
+		ReadCb read_cb, CloseCb close_cb /* = nullptr */,
+		dispatch_config const& config /* = dispatch_config{} */)
+	: server_(server), pool_(pool),
+	  read_cb_(read_cb), close_cb_(close_cb),
+	  events_(new event[config.queue_depth ? config.queue_depth : 1]),
+	  free_(nullptr)
+{
+	for(unsigned i = 0; i < config.strands; i++)
+		strands_.emplace_back(pool, config.strand_batch);
+
+	for(std::size_t i = 0; i < (config.queue_depth ? config.queue_depth : 1); i++)
+	{
+		events_[i].run = &dispatcher::run;
+		events_[i].self = this;
+		events_[i].next = free_;
+		free_ = &events_[i];
+	}
+}
+
+template<class Server,
+		typename ReadCb,
+		typename CloseCb>
+void
+dispatcher<Server, ReadCb, CloseCb>::
+read(handler socket) noexcept
+{
+	post(socket, false);
+}
+
+template<class Server,
+		typename ReadCb,
+		typename CloseCb>
+void
+dispatcher<Server, ReadCb, CloseCb>::
+close(handler socket, bool owned /* = true */) noexcept
+{
+	post(socket, true, owned);
+}
+
+template<class Server,
+		typename ReadCb,
+		typename CloseCb>
+void
+dispatcher<Server, ReadCb, CloseCb>::
+post(handler socket, bool close, bool owned /* = true */) noexcept
+{
+	event* ev;
+	{
+		std::unique_lock<std::mutex> lock(mtx_);
+		cv_.wait(lock, [this]{ return free_ != nullptr; });
+		ev = static_cast<event*>(free_);
+		free_ = free_->next;
+	}
+	ev->socket = socket;
+	ev->close = close;
+	ev->owned = owned;
+
+	if(strands_.empty())
+	{
+		while(!pool_.post(ev)) std::this_thread::yield();
+	}
+	else
+	{
+		strands_[static_cast<std::size_t>(socket) % strands_.size()].post(ev);
+	}
+}
+
+template<class Server,
+		typename ReadCb,
+		typename CloseCb>
+void
+dispatcher<Server, ReadCb, CloseCb>::
+release(event* ev) noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx_);
+		ev->next = free_;
+		free_ = ev;
+	}
+	cv_.notify_one();
+}
+
+template<class Server,
+		typename ReadCb,
+		typename CloseCb>
+void
+dispatcher<Server, ReadCb, CloseCb>::
+run(job* j) noexcept
+{
+	event* ev = static_cast<event*>(j);
+	dispatcher* self = ev->self;
+	handler socket = ev->socket;
+	bool close = ev->close;
+	bool owned = ev->owned;
+	self->release(ev);
+
+	if(!close)
+	{
+		self->read_cb_(socket);
+		return;
+	}
+
+	if constexpr(!std::is_same<void*, CloseCb>::value)
+	{
+		self->close_cb_(socket);
+	}
+	if(owned) self->server_.close_client(socket);
+}
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_POSIX_DISPATCHER_IMPL_HPP__ */
@@ -0,0 +1,151 @@
+#ifndef SOCA_POSIX_DRAIN_IMPL_HPP__
+#define SOCA_POSIX_DRAIN_IMPL_HPP__
+
+#include "../drain.hpp"
+
+#include <type_traits>
+
+namespace Soca{
+namespace POSIX{
+
+template<class Server>
+connection_drain<Server>::
+connection_drain(Server& srv) noexcept
+	: server_(srv){}
+
+template<class Server>
+bool
+connection_drain<Server>::
+add(handler socket, Error& ec) noexcept
+{
+	std::size_t fd = static_cast<std::size_t>(socket);
+	try{
+		if(fd >= index_.size()) index_.resize(fd + 1, none);
+		if(index_[fd] != none) return true;
+		entries_.push_back(entry{socket, false, false});
+	}catch(...){
+		ec = errc::out_of_resources;
+		return false;
+	}
+	index_[fd] = static_cast<std::uint32_t>(entries_.size() - 1);
+	return true;
+}
+
+template<class Server>
+void
+connection_drain<Server>::
+erase(std::uint32_t i) noexcept
+{
+	/* the last entry takes the place of the removed */
+	index_[static_cast<std::size_t>(entries_[i].socket)] = none;
+	if(i != entries_.size() - 1)
+	{
+		entries_[i] = entries_.back();
+		index_[static_cast<std::size_t>(entries_[i].socket)] = i;
+	}
+	entries_.pop_back();
+}
+
+template<class Server>
+void
+connection_drain<Server>::
+remove(handler socket) noexcept
+{
+	std::size_t fd = static_cast<std::size_t>(socket);
+	if(fd >= index_.size() || index_[fd] == none) return;
+	erase(index_[fd]);
+}
+
+template<class Server>
+void
+connection_drain<Server>::
+busy(handler socket, bool on) noexcept
+{
+	std::size_t fd = static_cast<std::size_t>(socket);
+	if(fd >= index_.size() || index_[fd] == none) return;
+	entries_[index_[fd]].busy = on;
+}
+
+template<class Server>
+void
+connection_drain<Server>::
+start(unsigned deadline_ms, Error& ec) noexcept
+{
+	if(!server_.pause(server_.native(), ec)) return;
+	deadline_ = clock::now() + std::chrono::milliseconds(deadline_ms);
+	draining_ = true;
+}
+
+template<class Server>
+template<typename CloseCb /* = void* */>
+bool
+connection_drain<Server>::
+process(CloseCb close_cb /* = nullptr */ [[maybe_unused]]) noexcept
+{
+	if(!draining_) return entries_.empty();
+
+	if(clock::now() >= deadline_)
+	{
+		/* close_cb may call remove() */
+		std::vector<entry> left;
+		left.swap(entries_);
+		for(entry const& e : left)
+		{
+			index_[static_cast<std::size_t>(e.socket)] = none;
+			if constexpr(!std::is_same<void*, CloseCb>::value)
+			{
+				close_cb(e.socket);
+			}
+			server_.close_client(e.socket);
+		}
+		return true;
+	}
+
+	/* FIN after the data queued at the kernel; closed when the peer closes */
+	for(entry& e : entries_)
+	{
+		if(e.busy || e.shut) continue;
+		::shutdown(e.socket, SHUT_WR);
+		e.shut = true;
+	}
+	return entries_.empty();
+}
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+template<class Server>
+template<typename StateCb /* = void* */>
+std::size_t
+connection_drain<Server>::
+hand_off(int unix_socket, Error& ec, StateCb state_cb /* = nullptr */ [[maybe_unused]]) noexcept
+{
+	std::size_t count = 0;
+	for(std::size_t i = entries_.size(); i-- > 0;)
+	{
+		entry const& e = entries_[i];
+		if(e.busy || e.shut) continue;
+
+		std::uint8_t state[SOCA_HANDOFF_STATE_MAX];
+		std::size_t len = 0;
+		if constexpr(!std::is_same<void*, StateCb>::value)
+		{
+			len = state_cb(e.socket, static_cast<void*>(state), sizeof(state));
+		}
+		if(!handoff_send(unix_socket, handoff_kind::connection, e.socket, state, len))
+		{
+			ec = errc::socket_send;
+			break;
+		}
+
+		handler socket = e.socket;
+		erase(static_cast<std::uint32_t>(i));
+		server_.detach_client(socket);
+		count++;
+	}
+	return count;
+}
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_POSIX_DRAIN_IMPL_HPP__ */
@@ -0,0 +1,48 @@
+#ifndef SOCA_POSIX_EXECUTOR_IMPL_HPP__
+#define SOCA_POSIX_EXECUTOR_IMPL_HPP__
+
+#include "../executor.hpp"
+#include "../port.hpp"
+
+#include <cerrno>
+
+namespace Soca{
+namespace POSIX{
+
+template<int BlockTimeMs /* = -1 */,
+		unsigned MaxEvents /* = 32 */>
+bool
+executor::
+run(Error& ec) noexcept
+{
+	struct epoll_event events[MaxEvents];
+
+	int event_num = epoll_wait(epoll_fd_, events, MaxEvents, BlockTimeMs);
+	if(event_num < 0)
+	{
+		if(errno == EINTR) return true;
+		ec = errc::socket_error;
+		return false;
+	}
+
+	for(int i = 0; i < event_num; i++)
+	{
+		io_operation* op = static_cast<io_operation*>(events[i].data.ptr);
+		if(op->perform(op))
+		{
+			op->waiter.resume();
+		}
+		else if(!wait(op))
+		{
+			/* Couldn't rearm: resume, the operation reports the error */
+			op->failed = true;
+			op->waiter.resume();
+		}
+	}
+	return true;
+}
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_POSIX_EXECUTOR_IMPL_HPP__ */
@@ -0,0 +1,180 @@
+#ifndef SOCA_POSIX_FLOW_TABLE_IMPL_HPP__
+#define SOCA_POSIX_FLOW_TABLE_IMPL_HPP__
+
+#include "../flow_table.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+template<typename Value>
+flow_table<Value>::
+flow_table(std::size_t capacity, std::uint64_t seed /* = 0 */)
+	: max_size_(capacity ? capacity : 1), seed_(seed)
+{
+	/* at most 7/8 full; index bits must not reach used_bit */
+	std::size_t slots = 8;
+	while(slots - slots / 8 < max_size_ + 1 && slots < used_bit) slots <<= 1;
+	if(max_size_ > slots - slots / 8 - 1) max_size_ = slots - slots / 8 - 1;
+
+	mask_ = slots - 1;
+	tags_.reset(new std::uint32_t[slots]());
+	entries_.reset(new entry[slots]);
+}
+
+template<typename Value>
+std::size_t
+flow_table<Value>::
+lookup(endpoint_key const& key, std::uint32_t tag) const noexcept
+{
+	std::size_t i = tag & mask_;
+	while(tags_[i] != 0)
+	{
+		if(tags_[i] == tag && entries_[i].key == key) return i;
+		i = (i + 1) & mask_;
+	}
+	return i;
+}
+
+template<typename Value>
+Value*
+flow_table<Value>::
+find(endpoint_key const& key) noexcept
+{
+	std::size_t i = lookup(key, tag(key));
+	return tags_[i] ? &entries_[i].value : nullptr;
+}
+
+template<typename Value>
+Value*
+flow_table<Value>::
+insert(endpoint_key const& key, bool& inserted) noexcept
+{
+	std::uint32_t t = tag(key);
+	std::size_t i = lookup(key, t);
+	if(tags_[i])
+	{
+		inserted = false;
+		return &entries_[i].value;
+	}
+
+	inserted = false;
+	if(size_ >= max_size_) return nullptr;
+
+	tags_[i] = t;
+	entries_[i].key = key;
+	size_++;
+	inserted = true;
+	return &entries_[i].value;
+}
+
+template<typename Value>
+Value*
+flow_table<Value>::
+insert(endpoint_key const& key) noexcept
+{
+	bool inserted;
+	return insert(key, inserted);
+}
+
+template<typename Value>
+bool
+flow_table<Value>::
+erase(endpoint_key const& key) noexcept
+{
+	std::size_t i = lookup(key, tag(key));
+	if(!tags_[i]) return false;
+
+	erase_at(i);
+	return true;
+}
+
+template<typename Value>
+void
+flow_table<Value>::
+erase_at(std::size_t i) noexcept
+{
+	/**
+	 * Backward shift: moves back each following entry that is not
+	 * at its home slot range (home, j]
+	 */
+	std::size_t j = i;
+	while(true)
+	{
+		j = (j + 1) & mask_;
+		if(!tags_[j]) break;
+
+		std::size_t home = tags_[j] & mask_;
+		if(((j - home) & mask_) >= ((j - i) & mask_))
+		{
+			tags_[i] = tags_[j];
+			entries_[i].key = entries_[j].key;
+			entries_[i].value = std::move(entries_[j].value);
+			i = j;
+		}
+	}
+
+	tags_[i] = 0;
+	entries_[i].value = Value{};
+	size_--;
+}
+
+template<typename Value>
+void
+flow_table<Value>::
+clear() noexcept
+{
+	for(std::size_t i = 0; i <= mask_; i++)
+	{
+		if(!tags_[i]) continue;
+		tags_[i] = 0;
+		entries_[i].value = Value{};
+	}
+	size_ = 0;
+}
+
+template<typename Value>
+template<typename Func>
+void
+flow_table<Value>::
+for_each(Func&& func) noexcept
+{
+	for(std::size_t i = 0; i <= mask_; i++)
+	{
+		if(tags_[i]) func(static_cast<endpoint_key const&>(entries_[i].key), entries_[i].value);
+	}
+}
+
+template<typename Value>
+template<typename Pred>
+std::size_t
+flow_table<Value>::
+erase_if(Pred&& pred) noexcept
+{
+	/**
+	 * Starts after an empty slot (there is always one): entries are only
+	 * shifted back inside a run of used slots, so a run never wraps to the
+	 * visited ones
+	 */
+	std::size_t start = 0;
+	while(tags_[start]) start++;
+
+	std::size_t count = 0;
+	for(std::size_t n = 1; n <= mask_;)
+	{
+		std::size_t i = (start + n) & mask_;
+		/* erase_at may shift a not visited entry to i: check i again */
+		if(tags_[i] && pred(static_cast<endpoint_key const&>(entries_[i].key), entries_[i].value))
+		{
+			erase_at(i);
+			count++;
+			continue;
+		}
+		n++;
+	}
+	return count;
+}
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_POSIX_FLOW_TABLE_IMPL_HPP__ */
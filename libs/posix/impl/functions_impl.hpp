@@ -5,6 +5,13 @@
 
 #include "../port.hpp"
 
+#include <cstring>
+#include <cerrno>
+
+#if defined(__linux__)
+#include <linux/net_tstamp.h>
+#endif /* defined(__linux__) */
+
 namespace Soca{
 namespace POSIX{
 
@@ -22,6 +29,265 @@ bool nonblock_socket(Handler socket)
 #endif
 }
 
+template<typename Handler>
+bool block_socket(Handler socket)
+{
+#ifdef _WIN32
+   unsigned long mode = 0;
+   return (ioctlsocket(socket, FIONBIO, &mode) == 0) ? true : false;
+#else
+   int flags = ::fcntl(socket, F_GETFL, 0);
+   if (flags == -1) return false;
+   flags = flags & ~O_NONBLOCK;
+   return (fcntl(socket, F_SETFL, flags) == 0) ? true : false;
+#endif
+}
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+template<typename Handler>
+bool send_fd(Handler socket, int fd,
+		const void* data /* = nullptr */, std::size_t len /* = 0 */) noexcept
+{
+	char dummy = 0;
+	struct iovec iov = len ?
+			iovec{const_cast<void*>(data), len} :
+			iovec{&dummy, 1};
+	alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+
+	struct msghdr msg = {};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+	cm->cmsg_level = SOL_SOCKET;
+	cm->cmsg_type = SCM_RIGHTS;
+	cm->cmsg_len = CMSG_LEN(sizeof(int));
+	std::memcpy(CMSG_DATA(cm), &fd, sizeof(int));
+
+	ssize_t size;
+	do size = ::sendmsg(socket, &msg, MSG_NOSIGNAL);
+	while(size == -1 && errno == EINTR);
+	return size > 0;
+}
+
+template<typename Handler>
+int receive_fd(Handler socket, void* data, std::size_t& len) noexcept
+{
+	char dummy;
+	struct iovec iov = len ? iovec{data, len} : iovec{&dummy, 1};
+	alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+
+	struct msghdr msg = {};
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	ssize_t size;
+#if defined(__linux__)
+	do size = ::recvmsg(socket, &msg, MSG_CMSG_CLOEXEC);
+#else /* defined(__linux__) */
+	do size = ::recvmsg(socket, &msg, 0);
+#endif /* defined(__linux__) */
+	while(size == -1 && errno == EINTR);
+	if(size <= 0)
+	{
+		len = 0;
+		return -1;
+	}
+	if(len) len = static_cast<std::size_t>(size);
+
+	int fd = -1;
+	for(struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm))
+	{
+		if(cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_RIGHTS
+			&& cm->cmsg_len >= CMSG_LEN(sizeof(int)))
+		{
+			std::memcpy(&fd, CMSG_DATA(cm), sizeof(int));
+#if !defined(__linux__)
+			::fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif /* !defined(__linux__) */
+			break;
+		}
+	}
+	return fd;
+}
+
+template<typename Handler>
+int receive_fd(Handler socket) noexcept
+{
+	std::size_t len = 0;
+	return receive_fd(socket, nullptr, len);
+}
+
+template<typename Handler>
+bool enable_packet_info(Handler socket) noexcept
+{
+	struct sockaddr_storage addr;
+	socklen_t len = sizeof(addr);
+	if(::getsockname(socket, reinterpret_cast<struct sockaddr*>(&addr), &len) == -1)
+		return false;
+
+	int opt = 1;
+	if(addr.ss_family == AF_INET)
+	{
+#if defined(IP_RECVPKTINFO)
+		return ::setsockopt(socket, IPPROTO_IP, IP_RECVPKTINFO, &opt, sizeof(opt)) == 0;
+#elif defined(IP_PKTINFO)
+		return ::setsockopt(socket, IPPROTO_IP, IP_PKTINFO, &opt, sizeof(opt)) == 0;
+#endif /* defined(IP_RECVPKTINFO) */
+	}
+#if defined(IPV6_RECVPKTINFO)
+	if(addr.ss_family == AF_INET6)
+		return ::setsockopt(socket, IPPROTO_IPV6, IPV6_RECVPKTINFO, &opt, sizeof(opt)) == 0;
+#endif /* defined(IPV6_RECVPKTINFO) */
+	(void)opt;
+	return false;
+}
+
+template<typename Handler>
+ssize_t receive_packet_info(Handler socket,
+		void* buffer, std::size_t buffer_len,
+		void* addr, socklen_t* addr_len,
+		packet_info& info) noexcept
+{
+	struct iovec iov = {buffer, buffer_len};
+	alignas(struct cmsghdr) char control[128];
+
+	struct msghdr msg = {};
+	msg.msg_name = addr;
+	msg.msg_namelen = addr_len ? *addr_len : 0;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	info.family = 0;
+	ssize_t size = ::recvmsg(socket, &msg, 0);
+	if(size >= 0)
+	{
+		if(addr_len) *addr_len = msg.msg_namelen;
+		parse_packet_info(msg, info);
+	}
+	return size;
+}
+
+template<typename Handler>
+ssize_t send_packet_info(Handler socket,
+		const void* buffer, std::size_t buffer_len,
+		const void* addr, socklen_t addr_len,
+		packet_info const& info) noexcept
+{
+	struct iovec iov = {const_cast<void*>(buffer), buffer_len};
+	alignas(struct cmsghdr) char control[128] = {};
+
+	struct msghdr msg = {};
+	msg.msg_name = const_cast<void*>(addr);
+	msg.msg_namelen = addr_len;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+
+#if defined(IP_PKTINFO)
+	if(info.family == AF_INET)
+	{
+		struct in_pktinfo pi = {};
+		pi.ipi_ifindex = static_cast<int>(info.interface);
+		pi.ipi_spec_dst = info.address;
+
+		msg.msg_control = control;
+		msg.msg_controllen = CMSG_SPACE(sizeof(pi));
+		struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+		cm->cmsg_level = IPPROTO_IP;
+		cm->cmsg_type = IP_PKTINFO;
+		cm->cmsg_len = CMSG_LEN(sizeof(pi));
+		std::memcpy(CMSG_DATA(cm), &pi, sizeof(pi));
+	}
+#endif /* defined(IP_PKTINFO) */
+#if defined(IPV6_RECVPKTINFO)
+	if(info.family == AF_INET6)
+	{
+		struct in6_pktinfo pi = {};
+		pi.ipi6_ifindex = info.interface;
+		pi.ipi6_addr = info.address6;
+
+		msg.msg_control = control;
+		msg.msg_controllen = CMSG_SPACE(sizeof(pi));
+		struct cmsghdr* cm = CMSG_FIRSTHDR(&msg);
+		cm->cmsg_level = IPPROTO_IPV6;
+		cm->cmsg_type = IPV6_PKTINFO;
+		cm->cmsg_len = CMSG_LEN(sizeof(pi));
+		std::memcpy(CMSG_DATA(cm), &pi, sizeof(pi));
+	}
+#endif /* defined(IPV6_RECVPKTINFO) */
+
+	return ::sendmsg(socket, &msg, 0);
+}
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+
+#if defined(__linux__)
+template<typename Handler>
+bool enable_timestamping(Handler socket, unsigned flags) noexcept
+{
+	int opt = SOF_TIMESTAMPING_SOFTWARE;
+	if(flags & timestamp_rx)
+	{
+		opt |= SOF_TIMESTAMPING_RX_SOFTWARE;
+		if(flags & timestamp_hardware) opt |= SOF_TIMESTAMPING_RX_HARDWARE;
+	}
+	if(flags & timestamp_tx)
+	{
+		opt |= SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+		if(flags & timestamp_hardware) opt |= SOF_TIMESTAMPING_TX_HARDWARE;
+	}
+	if(flags & timestamp_hardware) opt |= SOF_TIMESTAMPING_RAW_HARDWARE;
+
+	return ::setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPING, &opt, sizeof(opt)) == 0;
+}
+
+template<typename Handler>
+ssize_t receive_timestamp(Handler socket,
+		void* buffer, std::size_t buffer_len,
+		void* addr, socklen_t* addr_len,
+		timestamp& ts) noexcept
+{
+	struct iovec iov = {buffer, buffer_len};
+	alignas(struct cmsghdr) char control[256];
+
+	struct msghdr msg = {};
+	msg.msg_name = addr;
+	msg.msg_namelen = addr_len ? *addr_len : 0;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	ssize_t size = ::recvmsg(socket, &msg, 0);
+	if(size >= 0)
+	{
+		if(addr_len) *addr_len = msg.msg_namelen;
+		parse_timestamp(msg, ts);
+	}
+	return size;
+}
+
+template<typename Handler>
+bool read_tx_timestamp(Handler socket, timestamp& ts) noexcept
+{
+	alignas(struct cmsghdr) char control[256];
+
+	struct msghdr msg = {};
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	/* OPT_TSONLY: no payload is looped back */
+	if(::recvmsg(socket, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+		return false;
+	return parse_timestamp(msg, ts);
+}
+#endif /* defined(__linux__) */
+
 }//POSIX
 }//Soca
 
@@ -0,0 +1,291 @@
+#ifndef SOCA_POSIX_PIPELINED_CLIENT_IMPL_HPP__
+#define SOCA_POSIX_PIPELINED_CLIENT_IMPL_HPP__
+
+#include "../pipelined_client.hpp"
+
+#include <cstring>
+
+namespace Soca{
+namespace POSIX{
+
+template<class Endpoint,
+		typename Framing,
+		unsigned Capacity,
+		int Flags>
+pipelined_client<Endpoint, Framing, Capacity, Flags>::
+pipelined_client(){}
+
+template<class Endpoint,
+		typename Framing,
+		unsigned Capacity,
+		int Flags>
+void
+pipelined_client<Endpoint, Framing, Capacity, Flags>::
+open(endpoint& ep, Error& ec) noexcept
+{
+	conn_.open(ep, ec);
+}
+
+template<class Endpoint,
+		typename Framing,
+		unsigned Capacity,
+		int Flags>
+bool
+pipelined_client<Endpoint, Framing, Capacity, Flags>::
+is_open() const noexcept
+{
+	return conn_.is_open();
+}
+
+template<class Endpoint,
+		typename Framing,
+		unsigned Capacity,
+		int Flags>
+void
+pipelined_client<Endpoint, Framing, Capacity, Flags>::
+close() noexcept
+{
+	if(conn_.is_open()) conn_.close();
+	out_.clear();
+	out_sent_ = 0;
+	in_size_ = 0;
+
+	Error ec;
+	ec = errc::socket_error;
+	fail_all(ec);
+}
+
+template<class Endpoint,
+		typename Framing,
+		unsigned Capacity,
+		int Flags>
+typename pipelined_client<Endpoint, Framing, Capacity, Flags>::handler
+pipelined_client<Endpoint, Framing, Capacity, Flags>::
+native() const noexcept
+{
+	return conn_.native();
+}
+
+template<class Endpoint,
+		typename Framing,
+		unsigned Capacity,
+		int Flags>
+std::uint32_t
+pipelined_client<Endpoint, Framing, Capacity, Flags>::
+request(const void* payload, std::size_t len,
+		callback cb, void* user, Error& ec) noexcept
+{
+	if(in_flight_ == Capacity)
+	{
+		ec = errc::no_free_slots;
+		return invalid_id;
+	}
+
+	/* ids keep increasing: a late response to a canceled id doesn't match */
+	std::uint32_t id;
+	do id = next_id_++;
+	while(id == invalid_id || slots_[id & mask].cb);
+
+	request_id(id, payload, len, cb, user, ec);
+	return ec ? invalid_id : id;
+}
+
+template<class Endpoint,
+		typename Framing,
+		unsigned Capacity,
+		int Flags>
+void
+pipelined_client<Endpoint, Framing, Capacity, Flags>::
+request_id(std::uint32_t id, const void* payload, std::size_t len,
+		callback cb, void* user, Error& ec) noexcept
+{
+	if(in_flight_ == Capacity)
+	{
+		ec = errc::no_free_slots;
+		return;
+	}
+
+	slot& s = slots_[id & mask];
+	if(s.cb)
+	{
+		ec = errc::transaction_ocupied;
+		return;
+	}
+
+	std::size_t offset = out_.size();
+	try{
+		out_.resize(offset + Framing::header_size + len);
+	}catch(...){
+		ec = errc::out_of_resources;
+		return;
+	}
+	std::size_t header = Framing::write_header(out_.data() + offset, id, len);
+	std::memcpy(out_.data() + offset + header, payload, len);
+
+	s.id = id;
+	s.cb = cb;
+	s.user = user;
+	in_flight_++;
+}
+
+template<class Endpoint,
+		typename Framing,
+		unsigned Capacity,
+		int Flags>
+bool
+pipelined_client<Endpoint, Framing, Capacity, Flags>::
+cancel(std::uint32_t id) noexcept
+{
+	slot& s = slots_[id & mask];
+	if(!s.cb || s.id != id) return false;
+
+	s.cb = nullptr;
+	in_flight_--;
+	return true;
+}
+
+template<class Endpoint,
+		typename Framing,
+		unsigned Capacity,
+		int Flags>
+bool
+pipelined_client<Endpoint, Framing, Capacity, Flags>::
+flush(Error& ec) noexcept
+{
+	while(out_sent_ < out_.size())
+	{
+		std::size_t sent = conn_.send(out_.data() + out_sent_, out_.size() - out_sent_, ec);
+		if(ec) return false;
+		if(sent == 0) break;
+		out_sent_ += sent;
+	}
+
+	if(out_sent_ == out_.size())
+	{
+		out_.clear();
+		out_sent_ = 0;
+		return true;
+	}
+
+	/* keeps the buffer from growing while the socket is full */
+	if(out_sent_ > out_.size() / 2)
+	{
+		out_.erase(out_.begin(), out_.begin() + static_cast<std::ptrdiff_t>(out_sent_));
+		out_sent_ = 0;
+	}
+	return false;
+}
+
+template<class Endpoint,
+		typename Framing,
+		unsigned Capacity,
+		int Flags>
+std::size_t
+pipelined_client<Endpoint, Framing, Capacity, Flags>::
+process(Error& ec) noexcept
+{
+	std::size_t completed = 0;
+	while(conn_.is_open())
+	{
+		/* out of memory: the data waits at the socket */
+		if(in_.size() - in_size_ < 4096 && !grow(in_.size() < 16384 ? 16384 : in_.size() * 2))
+		{
+			ec = errc::out_of_resources;
+			break;
+		}
+
+		std::size_t size = conn_.receive(in_.data() + in_size_, in_.size() - in_size_, ec);
+		if(ec)
+		{
+			/* closed by the peer (or error): fails what is left */
+			close();
+			break;
+		}
+		if(size == 0) break;
+		in_size_ += size;
+
+		/* completes the whole frames received */
+		std::size_t offset = 0;
+		while(true)
+		{
+			std::uint8_t const* frame = in_.data() + offset;
+			std::size_t frame_size = Framing::frame_size(frame, in_size_ - offset);
+			if(frame_size == 0) break;
+			if(frame_size > SOCA_PIPELINE_MAX_FRAME)
+			{
+				ec = errc::invalid_data;
+				close();
+				return completed;
+			}
+			if(frame_size > in_size_ - offset)
+			{
+				/* moved to the start below: frame_size is enough */
+				if(in_.size() < frame_size && !grow(frame_size))
+					ec = errc::out_of_resources;
+				break;
+			}
+
+			std::uint32_t id = Framing::id(frame);
+			slot& s = slots_[id & mask];
+			if(s.cb && s.id == id)
+			{
+				/* freed before the call: the callback may request again */
+				callback cb = s.cb;
+				s.cb = nullptr;
+				in_flight_--;
+				completed++;
+				cb(id, frame + Framing::header_size, frame_size - Framing::header_size,
+						Error{}, s.user);
+				if(!conn_.is_open()) return completed;
+			}
+			offset += frame_size;
+		}
+
+		if(offset)
+		{
+			std::memmove(in_.data(), in_.data() + offset, in_size_ - offset);
+			in_size_ -= offset;
+		}
+		if(ec) break;
+	}
+	return completed;
+}
+
+template<class Endpoint,
+		typename Framing,
+		unsigned Capacity,
+		int Flags>
+bool
+pipelined_client<Endpoint, Framing, Capacity, Flags>::
+grow(std::size_t size) noexcept
+{
+	try{
+		in_.resize(size);
+	}catch(...){
+		return false;
+	}
+	return true;
+}
+
+template<class Endpoint,
+		typename Framing,
+		unsigned Capacity,
+		int Flags>
+void
+pipelined_client<Endpoint, Framing, Capacity, Flags>::
+fail_all(Error const& ec) noexcept
+{
+	for(slot& s : slots_)
+	{
+		if(!s.cb) continue;
+		callback cb = s.cb;
+		s.cb = nullptr;
+		in_flight_--;
+		cb(s.id, nullptr, 0, ec, s.user);
+	}
+}
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_POSIX_PIPELINED_CLIENT_IMPL_HPP__ */
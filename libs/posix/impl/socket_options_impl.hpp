@@ -0,0 +1,107 @@
+#ifndef SOCA_POSIX_SOCKET_OPTIONS_IMPL_HPP__
+#define SOCA_POSIX_SOCKET_OPTIONS_IMPL_HPP__
+
+#include "../socket_options.hpp"
+
+#include <cstring>
+
+namespace Soca{
+namespace POSIX{
+namespace detail{
+
+template<typename Handler>
+bool set_option(Handler socket, int level, int name, int value) noexcept
+{
+	return ::setsockopt(socket, level, name,
+			reinterpret_cast<const char*>(&value), sizeof(value)) == 0;
+}
+
+}//detail
+
+template<typename Handler>
+bool apply_options(Handler socket, socket_options const& opt, bool tcp, Error& ec) noexcept
+{
+	if(opt.empty()) return true;
+
+	bool ok = true;
+	if(opt.receive_buffer != socket_options::unset)
+		ok &= detail::set_option(socket, SOL_SOCKET, SO_RCVBUF, opt.receive_buffer);
+	if(opt.send_buffer != socket_options::unset)
+		ok &= detail::set_option(socket, SOL_SOCKET, SO_SNDBUF, opt.send_buffer);
+#ifdef SO_BUSY_POLL
+	if(opt.busy_poll != socket_options::unset)
+		ok &= detail::set_option(socket, SOL_SOCKET, SO_BUSY_POLL, opt.busy_poll);
+#endif /* SO_BUSY_POLL */
+#ifdef SO_PREFER_BUSY_POLL
+	if(opt.prefer_busy_poll != socket_options::unset)
+		ok &= detail::set_option(socket, SOL_SOCKET, SO_PREFER_BUSY_POLL, opt.prefer_busy_poll);
+#endif /* SO_PREFER_BUSY_POLL */
+#ifdef SO_BUSY_POLL_BUDGET
+	if(opt.busy_poll_budget != socket_options::unset)
+		ok &= detail::set_option(socket, SOL_SOCKET, SO_BUSY_POLL_BUDGET, opt.busy_poll_budget);
+#endif /* SO_BUSY_POLL_BUDGET */
+#ifdef SO_INCOMING_CPU
+	if(opt.incoming_cpu != socket_options::unset)
+		ok &= detail::set_option(socket, SOL_SOCKET, SO_INCOMING_CPU, opt.incoming_cpu);
+#endif /* SO_INCOMING_CPU */
+#ifdef SO_REUSEPORT
+	if(opt.reuse_port != socket_options::unset)
+		ok &= detail::set_option(socket, SOL_SOCKET, SO_REUSEPORT, opt.reuse_port);
+#endif /* SO_REUSEPORT */
+
+	if(tcp)
+	{
+		if(opt.nodelay != socket_options::unset)
+			ok &= detail::set_option(socket, IPPROTO_TCP, TCP_NODELAY, opt.nodelay);
+#ifdef TCP_QUICKACK
+		if(opt.quickack != socket_options::unset)
+			ok &= detail::set_option(socket, IPPROTO_TCP, TCP_QUICKACK, opt.quickack);
+#endif /* TCP_QUICKACK */
+#ifdef TCP_NOTSENT_LOWAT
+		if(opt.notsent_lowat != socket_options::unset)
+			ok &= detail::set_option(socket, IPPROTO_TCP, TCP_NOTSENT_LOWAT, opt.notsent_lowat);
+#endif /* TCP_NOTSENT_LOWAT */
+#ifdef TCP_DEFER_ACCEPT
+		if(opt.defer_accept != socket_options::unset)
+			ok &= detail::set_option(socket, IPPROTO_TCP, TCP_DEFER_ACCEPT, opt.defer_accept);
+#endif /* TCP_DEFER_ACCEPT */
+#ifdef TCP_CONGESTION
+		if(opt.congestion)
+			ok &= ::setsockopt(socket, IPPROTO_TCP, TCP_CONGESTION,
+					opt.congestion, static_cast<socklen_t>(std::strlen(opt.congestion))) == 0;
+#endif /* TCP_CONGESTION */
+	}
+
+	if(!ok) ec = errc::socket_option;
+	return ok;
+}
+
+template<typename Handler>
+bool cork(Handler socket, bool on) noexcept
+{
+#if defined(TCP_CORK)
+	return detail::set_option(socket, IPPROTO_TCP, TCP_CORK, on ? 1 : 0);
+#elif defined(TCP_NOPUSH)
+	return detail::set_option(socket, IPPROTO_TCP, TCP_NOPUSH, on ? 1 : 0);
+#else
+	(void)socket;
+	(void)on;
+	return false;
+#endif
+}
+
+template<typename Handler>
+bool quickack(Handler socket) noexcept
+{
+#ifdef TCP_QUICKACK
+	return detail::set_option(socket, IPPROTO_TCP, TCP_QUICKACK, 1);
+#else
+	(void)socket;
+	return false;
+#endif /* TCP_QUICKACK */
+}
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_POSIX_SOCKET_OPTIONS_IMPL_HPP__ */
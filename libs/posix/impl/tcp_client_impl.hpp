@@ -5,38 +5,49 @@
 #include "../functions.hpp"
 
 #include <cerrno>
+#include <chrono>
 
 namespace Soca{
 namespace POSIX{
 
 template<class Endpoint,
-		int Flags>
-tcp_client<Endpoint, Flags>::
+		int Flags,
+		class Options>
+tcp_client<Endpoint, Flags, Options>::
 tcp_client() : socket_(0){}
 
 template<class Endpoint,
-		int Flags>
-tcp_client<Endpoint, Flags>::
+		int Flags,
+		class Options>
+tcp_client<Endpoint, Flags, Options>::
 ~tcp_client()
 {
 	if(is_open()) close();
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 void
-tcp_client<Endpoint, Flags>::
+tcp_client<Endpoint, Flags, Options>::
 open(endpoint& ep, Error& ec) noexcept
 {
-	if((socket_ = ::socket(ep.family(), SOCK_STREAM, IPPROTO_TCP)) == -1)
+	if((socket_ = ::socket(ep.family(), stream_type<endpoint>::value, 0)) == -1)
 	{
 		ec = errc::socket_error;
 		return;
 	}
 
+	/* before connect: the buffer sizes set the window scale */
+	if(!apply_options(socket_, options_, tcp_level<endpoint>::value, ec))
+	{
+		close();
+		return;
+	}
+
 	if(::connect(socket_,
 		reinterpret_cast<struct sockaddr const*>(ep.native()),
-		sizeof(typename endpoint::native_type)) < 0)
+		ep.size()) < 0)
 	{
 		ec = errc::socket_error;
 		close();
@@ -48,23 +59,30 @@ open(endpoint& ep, Error& ec) noexcept
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 bool
-tcp_client<Endpoint, Flags>::
+tcp_client<Endpoint, Flags, Options>::
 async_open(endpoint& ep, Error& ec) noexcept
 {
-	if((socket_ = ::socket(ep.family(), SOCK_STREAM, IPPROTO_TCP)) == -1)
+	if((socket_ = ::socket(ep.family(), stream_type<endpoint>::value, 0)) == -1)
 	{
 		ec = errc::socket_error;
 		return false;
 	}
 
+	if(!apply_options(socket_, options_, tcp_level<endpoint>::value, ec))
+	{
+		close();
+		return false;
+	}
+
 	if constexpr((Flags & MSG_DONTWAIT) != 0)
 		nonblock_socket(socket_);
 
 	int res = ::connect(socket_,
 			reinterpret_cast<struct sockaddr const*>(ep.native()),
-			sizeof(typename endpoint::native_type));
+			ep.size());
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
 	if(res == -1 && WSAGetLastError() == WSAEINPROGRESS)
 #else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
@@ -81,10 +99,11 @@ async_open(endpoint& ep, Error& ec) noexcept
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 template<int BlockTimeMs /* = -1 */>
 bool
-tcp_client<Endpoint, Flags>::
+tcp_client<Endpoint, Flags, Options>::
 wait_connect(Error& ec) const noexcept
 {
 	struct timeval tv = {
@@ -140,23 +159,238 @@ wait_connect(Error& ec) const noexcept
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
+template<int AttemptDelayMs /* = 250 */, int BlockTimeMs /* = -1 */>
+int
+tcp_client<Endpoint, Flags, Options>::
+connect_any(endpoint const* eps, std::size_t count, Error& ec) noexcept
+{
+	using clock = std::chrono::steady_clock;
+
+	if(is_open()) close();
+	if(count > SOCA_CONNECT_ANY_MAX) count = SOCA_CONNECT_ANY_MAX;
+
+	/* interleaves the families, first family of eps[0] (RFC 8305, 4) */
+	std::size_t order[SOCA_CONNECT_ANY_MAX];
+	{
+		std::size_t first[SOCA_CONNECT_ANY_MAX], other[SOCA_CONNECT_ANY_MAX];
+		std::size_t nfirst = 0, nother = 0, n = 0;
+		for(std::size_t i = 0; i < count; i++)
+		{
+			if(eps[i].family() == eps[0].family()) first[nfirst++] = i;
+			else other[nother++] = i;
+		}
+		for(std::size_t i = 0; i < nfirst || i < nother; i++)
+		{
+			if(i < nfirst) order[n++] = first[i];
+			if(i < nother) order[n++] = other[i];
+		}
+	}
+
+	auto close_socket = [](handler s){
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+		::closesocket(s);
+#else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+		::close(s);
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	};
+
+	/* error of the last attempt failed, reported if none connects */
+	errc error = errc::socket_error;
+	auto failed = [&error](int err){
+		switch(err)
+		{
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+			case WSAECONNREFUSED: error = errc::connect_refused; break;
+			case WSAETIMEDOUT: error = errc::connect_timeout; break;
+			case WSAENETUNREACH:
+			case WSAEHOSTUNREACH: error = errc::connect_unreachable; break;
+#else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+			case ECONNREFUSED: error = errc::connect_refused; break;
+			case ETIMEDOUT: error = errc::connect_timeout; break;
+			case ENETUNREACH:
+			case EHOSTUNREACH: error = errc::connect_unreachable; break;
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+			default: error = errc::socket_error; break;
+		}
+	};
+	auto last_error = []{
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+		return WSAGetLastError();
+#else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+		return errno;
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	};
+
+	handler sockets[SOCA_CONNECT_ANY_MAX];
+	bool connecting[SOCA_CONNECT_ANY_MAX] = {};
+	std::size_t started = 0, pending = 0;
+	int winner = -1;
+
+	auto deadline = clock::now() + std::chrono::milliseconds(BlockTimeMs);
+	auto next_attempt = clock::now();
+	while(winner == -1)
+	{
+		auto now = clock::now();
+		if constexpr(BlockTimeMs >= 0)
+		{
+			if(now >= deadline)
+			{
+				if(pending) error = errc::connect_timeout;
+				break;
+			}
+		}
+
+		/* next attempt: delay elapsed or nothing in flight */
+		if(started < count && (pending == 0 || now >= next_attempt))
+		{
+			std::size_t i = started++;
+			next_attempt = now + std::chrono::milliseconds(AttemptDelayMs);
+
+			endpoint const& ep = eps[order[i]];
+			if((sockets[i] = ::socket(ep.family(), stream_type<endpoint>::value, 0)) == -1)
+			{
+				failed(last_error());
+				continue;
+			}
+			Error opt_ec;
+			if(!apply_options(sockets[i], options_, tcp_level<endpoint>::value, opt_ec))
+			{
+				error = errc::socket_option;
+				close_socket(sockets[i]);
+				continue;
+			}
+			nonblock_socket(sockets[i]);
+
+			int res = ::connect(sockets[i],
+					reinterpret_cast<struct sockaddr const*>(ep.native()),
+					ep.size());
+			if(res == 0)
+			{
+				winner = static_cast<int>(i);
+				break;
+			}
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+			if(WSAGetLastError() != WSAEWOULDBLOCK)
+#else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+			if(errno != EINPROGRESS)
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+			{
+				failed(last_error());
+				close_socket(sockets[i]);
+				continue;
+			}
+			connecting[i] = true;
+			pending++;
+			continue;
+		}
+		if(pending == 0) break;
+
+		/* waits a connect or the next attempt */
+		auto until = started < count ? next_attempt : clock::time_point::max();
+		if constexpr(BlockTimeMs >= 0)
+		{
+			if(deadline < until) until = deadline;
+		}
+		struct timeval tv = {0, 0};
+		if(until != clock::time_point::max())
+		{
+			auto wait = std::chrono::duration_cast<std::chrono::microseconds>(until - now).count();
+			if(wait > 0)
+			{
+				tv.tv_sec = static_cast<decltype(tv.tv_sec)>(wait / 1000000);
+				tv.tv_usec = static_cast<decltype(tv.tv_usec)>(wait % 1000000);
+			}
+		}
+
+		fd_set wfds, efds;
+		FD_ZERO(&wfds);
+		FD_ZERO(&efds);
+		handler max = 0;
+		for(std::size_t i = 0; i < started; i++)
+		{
+			if(!connecting[i]) continue;
+			FD_SET(sockets[i], &wfds);
+			FD_SET(sockets[i], &efds);
+			if(sockets[i] > max) max = sockets[i];
+		}
+
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+		int s = select(0, NULL, &wfds, &efds,
+				until == clock::time_point::max() ? NULL : &tv);
+#else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+		int s = select(max + 1, NULL, &wfds, &efds,
+				until == clock::time_point::max() ? NULL : &tv);
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+		if(s < 0)
+		{
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+			if(errno == EINTR) continue;
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+			error = errc::socket_error;
+			break;
+		}
+
+		for(std::size_t i = 0; i < started && s > 0; i++)
+		{
+			if(!connecting[i]
+				|| (!FD_ISSET(sockets[i], &wfds) && !FD_ISSET(sockets[i], &efds)))
+				continue;
+
+			int so_error = 0;
+			socklen_t len = sizeof(so_error);
+			if(::getsockopt(sockets[i], SOL_SOCKET, SO_ERROR,
+					reinterpret_cast<char*>(&so_error), &len) == -1)
+				so_error = last_error();
+			if(so_error == 0)
+			{
+				winner = static_cast<int>(i);
+				break;
+			}
+			/* failed: the next attempt starts at once */
+			failed(so_error);
+			close_socket(sockets[i]);
+			connecting[i] = false;
+			pending--;
+		}
+	}
+
+	for(std::size_t i = 0; i < started; i++)
+		if(connecting[i] && static_cast<int>(i) != winner) close_socket(sockets[i]);
+
+	if(winner == -1)
+	{
+		ec = error;
+		return -1;
+	}
+
+	socket_ = sockets[winner];
+	if constexpr((Flags & MSG_DONTWAIT) == 0)
+		block_socket(socket_);
+	return static_cast<int>(order[winner]);
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
 void
-tcp_client<Endpoint, Flags>::
+tcp_client<Endpoint, Flags, Options>::
 bind(endpoint& ep, Error& ec) noexcept
 {
 	if (::bind(socket_,
 		reinterpret_cast<struct sockaddr const*>(ep.native()),
-		sizeof(typename endpoint::native_type)) == -1)
+		ep.size()) == -1)
 	{
 		ec = errc::socket_bind;
 	}
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 bool
-tcp_client<Endpoint, Flags>::
+tcp_client<Endpoint, Flags, Options>::
 is_connected() const noexcept
 {
 	Error ec;
@@ -164,18 +398,20 @@ is_connected() const noexcept
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 bool
-tcp_client<Endpoint, Flags>::
+tcp_client<Endpoint, Flags, Options>::
 is_open() const noexcept
 {
 	return socket_ != 0;
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 void
-tcp_client<Endpoint, Flags>::
+tcp_client<Endpoint, Flags, Options>::
 close() noexcept
 {
 	::shutdown(socket_, SHUT_RDWR);
@@ -188,38 +424,89 @@ close() noexcept
 }
 
 template<class Endpoint,
-		int Flags>
-typename tcp_client<Endpoint, Flags>::handler
-tcp_client<Endpoint, Flags>::
+		int Flags,
+		class Options>
+typename tcp_client<Endpoint, Flags, Options>::handler
+tcp_client<Endpoint, Flags, Options>::
 native() const noexcept
 {
 	return socket_;
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
+void
+tcp_client<Endpoint, Flags, Options>::
+options(socket_options const& opt) noexcept
+{
+	options_ = Options::options().merge(opt);
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+socket_options const&
+tcp_client<Endpoint, Flags, Options>::
+options() const noexcept
+{
+	return options_;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+void
+tcp_client<Endpoint, Flags, Options>::
+cork(bool on, Error& ec) noexcept
+{
+	if(!POSIX::cork(socket_, on))
+		ec = errc::socket_option;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
 std::size_t
-tcp_client<Endpoint, Flags>::
+tcp_client<Endpoint, Flags, Options>::
 send(const void* buffer, std::size_t buffer_len, Error& ec) noexcept
 {
+	SOCA_METRIC_TIMER(timer, send);
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
 	int sent = ::send(socket_, static_cast<const char*>(buffer), static_cast<int>(buffer_len), 0);
 #else /* #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
 	int sent = ::send(socket_, buffer, buffer_len, 0);
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	SOCA_PROBE(tcp_client_send, socket_, sent, sent < 0 ? errno : 0);
 	if(sent < 0)
 	{
+		if constexpr((Flags & MSG_DONTWAIT) != 0)
+		{
+#if	defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+			if(WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+			{
+				SOCA_METRIC_ADD(would_block, 1);
+				return 0;
+			}
+		}
 		ec = errc::socket_send;
+		SOCA_METRIC_ADD(errors, 1);
 		return 0;
 	}
 
+	SOCA_METRIC_ADD(packets_sent, 1);
+	SOCA_METRIC_ADD(bytes_sent, sent);
 	return sent;
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 std::size_t
-tcp_client<Endpoint, Flags>::
+tcp_client<Endpoint, Flags, Options>::
 receive(void* buffer, std::size_t buffer_len, Error& ec) noexcept
 {
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
@@ -227,6 +514,7 @@ receive(void* buffer, std::size_t buffer_len, Error& ec) noexcept
 #else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
 	int recv = ::recv(socket_, buffer, buffer_len, 0);
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	SOCA_PROBE(tcp_client_receive, socket_, recv, recv < 0 ? errno : 0);
 	if(recv < 1)
 	{
 		if constexpr((Flags & MSG_DONTWAIT) != 0)
@@ -236,19 +524,27 @@ receive(void* buffer, std::size_t buffer_len, Error& ec) noexcept
 #else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
 			if(recv == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+			{
+				SOCA_METRIC_ADD(would_block, 1);
 				return 0;
+			}
 		}
+		/* 0: closed by the peer, not an error (also sets ec) */
 		ec = errc::socket_receive;
+		if(recv != 0) SOCA_METRIC_ADD(errors, 1);
 		return 0;
 	}
+	SOCA_METRIC_ADD(packets_received, 1);
+	SOCA_METRIC_ADD(bytes_received, recv);
 	return recv;
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 template<int BlockTimeMs>
 std::size_t
-tcp_client<Endpoint, Flags>::
+tcp_client<Endpoint, Flags, Options>::
 receive(void* buffer, std::size_t buffer_len, Error& ec) noexcept
 {
 	struct timeval tv = {
@@ -278,6 +574,41 @@ receive(void* buffer, std::size_t buffer_len, Error& ec) noexcept
 	return 0;
 }
 
+#if SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+io_awaiter<connect_op<tcp_client<Endpoint, Flags, Options>>>
+tcp_client<Endpoint, Flags, Options>::
+async_connect(executor& exec, endpoint& ep, Error& ec) noexcept
+{
+	bool connected = async_open(ep, ec);
+	return {exec, socket_, EPOLLOUT, *this, ec, connected};
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+io_awaiter<receive_op<tcp_client<Endpoint, Flags, Options>>>
+tcp_client<Endpoint, Flags, Options>::
+async_receive(executor& exec, void* buffer, std::size_t buffer_len, Error& ec) noexcept
+{
+	return {exec, socket_, EPOLLIN, *this, buffer, buffer_len, ec};
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+io_awaiter<send_op<tcp_client<Endpoint, Flags, Options>>>
+tcp_client<Endpoint, Flags, Options>::
+async_send(executor& exec, const void* buffer, std::size_t buffer_len, Error& ec) noexcept
+{
+	return {exec, socket_, EPOLLOUT, *this, buffer, buffer_len, ec};
+}
+
+#endif /* SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1 */
+
 }//POSIX
 }//Soca
 
@@ -0,0 +1,318 @@
+#ifndef SOCA_POSIX_TCP_CLIENT_POOL_IMPL_HPP__
+#define SOCA_POSIX_TCP_CLIENT_POOL_IMPL_HPP__
+
+#include "../tcp_client_pool.hpp"
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace Soca{
+namespace POSIX{
+
+template<class Endpoint,
+		int Flags>
+tcp_client_pool<Endpoint, Flags>::
+tcp_client_pool(config const& cfg /* = config{} */)
+	: config_(cfg),
+	  slots_(new slot[cfg.max_total ? cfg.max_total : 1]),
+	  destinations_(cfg.max_total ? cfg.max_total : 1)
+{
+	if(!config_.max_total) config_.max_total = 1;
+	/* free list */
+	for(std::size_t i = config_.max_total; i-- > 0;)
+	{
+		slots_[i].next = free_;
+		free_ = static_cast<std::uint32_t>(i);
+	}
+}
+
+template<class Endpoint,
+		int Flags>
+tcp_client_pool<Endpoint, Flags>::
+~tcp_client_pool()
+{
+	close();
+}
+
+template<class Endpoint,
+		int Flags>
+void
+tcp_client_pool<Endpoint, Flags>::
+open(Error& ec) noexcept
+{
+	epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+	if(epoll_fd_ == -1)
+		ec = errc::socket_error;
+}
+
+template<class Endpoint,
+		int Flags>
+bool
+tcp_client_pool<Endpoint, Flags>::
+is_open() const noexcept
+{
+	return epoll_fd_ != -1;
+}
+
+template<class Endpoint,
+		int Flags>
+void
+tcp_client_pool<Endpoint, Flags>::
+close() noexcept
+{
+	if(epoll_fd_ == -1) return;
+
+	for(std::uint32_t i = 0; i < config_.max_total; i++)
+		if(slots_[i].idle) close_slot(i);
+	::close(epoll_fd_);
+	epoll_fd_ = -1;
+}
+
+template<class Endpoint,
+		int Flags>
+typename tcp_client_pool<Endpoint, Flags>::handler
+tcp_client_pool<Endpoint, Flags>::
+native() const noexcept
+{
+	return epoll_fd_;
+}
+
+template<class Endpoint,
+		int Flags>
+typename tcp_client_pool<Endpoint, Flags>::lease
+tcp_client_pool<Endpoint, Flags>::
+checkout(endpoint const& ep, Error& ec) noexcept
+{
+	SOCA_METRIC_TIMER(timer, pool_wait);
+
+	if(epoll_fd_ == -1)
+	{
+		ec = errc::socket_error;
+		return lease{};
+	}
+
+	/* drops the idle connections closed by the peer */
+	poll_events();
+
+	endpoint_key key{ep};
+	destination* dest = destinations_.find(key);
+	if(dest && dest->head != none)
+	{
+		std::uint32_t index = dest->head;
+		remove_idle(*dest, index);
+		SOCA_METRIC_ADD(pool_hits, 1);
+		return lease{this, index, true};
+	}
+
+	SOCA_METRIC_ADD(pool_misses, 1);
+	std::uint32_t index = connect(ep, key, ec);
+	if(index == none) return lease{};
+	return lease{this, index, false};
+}
+
+template<class Endpoint,
+		int Flags>
+std::size_t
+tcp_client_pool<Endpoint, Flags>::
+prewarm(endpoint const& ep, std::size_t count, Error& ec) noexcept
+{
+	if(epoll_fd_ == -1)
+	{
+		ec = errc::socket_error;
+		return 0;
+	}
+
+	poll_events();
+
+	endpoint_key key{ep};
+	if(count > config_.max_idle) count = config_.max_idle;
+	while(true)
+	{
+		destination* dest = destinations_.find(key);
+		std::size_t idle = dest ? dest->idle : 0;
+		if(idle >= count) return idle;
+
+		std::uint32_t index = connect(ep, key, ec);
+		if(index == none) return idle;
+		checkin(index, true);
+	}
+}
+
+template<class Endpoint,
+		int Flags>
+std::size_t
+tcp_client_pool<Endpoint, Flags>::
+reap() noexcept
+{
+	std::size_t closed = poll_events();
+
+	auto oldest = clock::now() - std::chrono::milliseconds(config_.idle_timeout_ms);
+	for(std::uint32_t i = 0; i < config_.max_total; i++)
+	{
+		if(!slots_[i].idle || slots_[i].idle_since > oldest) continue;
+		close_slot(i);
+		closed++;
+	}
+	return closed;
+}
+
+template<class Endpoint,
+		int Flags>
+std::uint32_t
+tcp_client_pool<Endpoint, Flags>::
+connect(endpoint const& ep, endpoint_key const& key, Error& ec) noexcept
+{
+	bool inserted;
+	destination* dest = destinations_.insert(key, inserted);
+	if(!dest || dest->total >= config_.max_per_destination || free_ == none)
+	{
+		ec = errc::no_free_slots;
+		return none;
+	}
+
+	std::uint32_t index = free_;
+	slot& s = slots_[index];
+
+	endpoint to = ep;
+	s.conn.open(to, ec);
+	if(ec)
+	{
+		if(dest->total == 0) destinations_.erase(key);
+		return none;
+	}
+
+	if(!arm(index, EPOLL_CTL_ADD))
+	{
+		s.conn.close();
+		if(dest->total == 0) destinations_.erase(key);
+		ec = errc::socket_error;
+		return none;
+	}
+
+	free_ = s.next;
+	s.key = key;
+	s.prev = s.next = none;
+	s.idle = false;
+	dest->total++;
+	size_++;
+	return index;
+}
+
+template<class Endpoint,
+		int Flags>
+void
+tcp_client_pool<Endpoint, Flags>::
+checkin(std::uint32_t index, bool reusable) noexcept
+{
+	slot& s = slots_[index];
+	destination* dest = destinations_.find(s.key);
+
+	if(!reusable || epoll_fd_ == -1 || !dest || dest->idle >= config_.max_idle
+		|| !s.conn.is_open() || !arm(index, EPOLL_CTL_MOD))
+	{
+		close_slot(index);
+		return;
+	}
+
+	s.idle_since = clock::now();
+	push_idle(*dest, index);
+}
+
+template<class Endpoint,
+		int Flags>
+void
+tcp_client_pool<Endpoint, Flags>::
+push_idle(destination& dest, std::uint32_t index) noexcept
+{
+	slot& s = slots_[index];
+	s.idle = true;
+	s.prev = none;
+	s.next = dest.head;
+	if(dest.head != none) slots_[dest.head].prev = index;
+	else dest.tail = index;
+	dest.head = index;
+	dest.idle++;
+	idle_++;
+}
+
+template<class Endpoint,
+		int Flags>
+void
+tcp_client_pool<Endpoint, Flags>::
+remove_idle(destination& dest, std::uint32_t index) noexcept
+{
+	slot& s = slots_[index];
+	if(s.prev != none) slots_[s.prev].next = s.next;
+	else dest.head = s.next;
+	if(s.next != none) slots_[s.next].prev = s.prev;
+	else dest.tail = s.prev;
+	s.prev = s.next = none;
+	s.idle = false;
+	dest.idle--;
+	idle_--;
+}
+
+template<class Endpoint,
+		int Flags>
+void
+tcp_client_pool<Endpoint, Flags>::
+close_slot(std::uint32_t index) noexcept
+{
+	slot& s = slots_[index];
+	destination* dest = destinations_.find(s.key);
+	if(dest)
+	{
+		if(s.idle) remove_idle(*dest, index);
+		if(--dest->total == 0) destinations_.erase(s.key);
+	}
+
+	/* closing removes it from the epoll */
+	if(s.conn.is_open()) s.conn.close();
+	s.next = free_;
+	free_ = index;
+	size_--;
+}
+
+template<class Endpoint,
+		int Flags>
+std::size_t
+tcp_client_pool<Endpoint, Flags>::
+poll_events() noexcept
+{
+	std::size_t closed = 0;
+	epoll_event events[16];
+	int n;
+	do
+	{
+		n = ::epoll_wait(epoll_fd_, events, 16, 0);
+		for(int i = 0; i < n; i++)
+		{
+			/* leased: the one shot event is the response; ignored */
+			std::uint32_t index = events[i].data.u32;
+			if(!slots_[index].idle) continue;
+
+			/* idle: closed by the peer, error or unexpected data */
+			SOCA_METRIC_ADD(pool_dead, 1);
+			close_slot(index);
+			closed++;
+		}
+	}while(n == 16);
+	return closed;
+}
+
+template<class Endpoint,
+		int Flags>
+bool
+tcp_client_pool<Endpoint, Flags>::
+arm(std::uint32_t index, int op) noexcept
+{
+	epoll_event event = {};
+	event.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+	event.data.u32 = index;
+	return ::epoll_ctl(epoll_fd_, op, slots_[index].conn.native(), &event) == 0;
+}
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_POSIX_TCP_CLIENT_POOL_IMPL_HPP__ */
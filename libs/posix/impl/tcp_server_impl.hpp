@@ -5,13 +5,15 @@
 #include "../port.hpp"
 
 #include <type_traits>
+#include <cerrno>
 
 namespace Soca{
 namespace POSIX{
 
 template<class Endpoint,
-		int Flags>
-tcp_server<Endpoint, Flags>::tcp_server()
+		int Flags,
+		class Options>
+tcp_server<Endpoint, Flags, Options>::tcp_server()
 	: socket_(0)
 #if SOCA_USE_SELECT != 1
 	  , epoll_fd_(0)
@@ -20,16 +22,30 @@ tcp_server<Endpoint, Flags>::tcp_server()
 #if SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1
 	FD_ZERO(&list_);
 #endif /* SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1 */
+#if SOCA_USE_SELECT == 1
+	FD_ZERO(&watched_);
+#endif /* SOCA_USE_SELECT == 1 */
 }
 
 template<class Endpoint,
-		int Flags>
-template<int PendingQueueSize /* = 10 */>
+		int Flags,
+		class Options>
+template<int PendingQueueSize /* = SOCA_TCP_SERVER_BACKLOG */>
 void
-tcp_server<Endpoint, Flags>::
+tcp_server<Endpoint, Flags, Options>::
 open(endpoint& ep, Error& ec) noexcept
 {
-	if((socket_ = ::socket(ep.family(), SOCK_STREAM, IPPROTO_TCP)) == -1)
+	open(ep, PendingQueueSize, ec);
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+void
+tcp_server<Endpoint, Flags, Options>::
+open(endpoint& ep, int backlog, Error& ec) noexcept
+{
+	if((socket_ = ::socket(ep.family(), stream_type<endpoint>::value, 0)) == -1)
 	{
 		ec = errc::socket_error;
 		return;
@@ -47,16 +63,23 @@ open(endpoint& ep, Error& ec) noexcept
 		return;
 	}
 
+	/* before listen: the buffer sizes set the window scale */
+	if(!apply_options(socket_, options_, tcp_level<endpoint>::value, ec))
+	{
+		close();
+		return;
+	}
+
 	if (::bind(socket_,
 		reinterpret_cast<struct sockaddr const*>(ep.native()),
-		sizeof(typename endpoint::native_type)) == -1)
+		ep.size()) == -1)
 	{
 		close();
 		ec = errc::socket_bind;
 		return;
 	}
 
-	if(::listen(socket_, PendingQueueSize) == -1)
+	if(::listen(socket_, backlog) == -1)
 	{
 		close();
 		ec = errc::socket_error;
@@ -73,35 +96,156 @@ open(endpoint& ep, Error& ec) noexcept
 	}
 }
 
+#if defined(__linux__) && SOCA_USE_SELECT != 1
 template<class Endpoint,
-		int Flags>
-bool tcp_server<Endpoint, Flags>::
+		int Flags,
+		class Options>
+void
+tcp_server<Endpoint, Flags, Options>::
+share(tcp_server const& listener, Error& ec) noexcept
+{
+	if((socket_ = ::dup(listener.native())) == -1)
+	{
+		socket_ = 0;
+		ec = errc::socket_error;
+		return;
+	}
+	options_ = listener.options_;
+
+	if(!open_poll())
+	{
+		close();
+		ec = errc::socket_error;
+	}
+}
+#endif /* defined(__linux__) && SOCA_USE_SELECT != 1 */
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+void
+tcp_server<Endpoint, Flags, Options>::
+assign(handler listener, Error& ec) noexcept
+{
+	socket_ = listener;
+	if constexpr((Flags & MSG_DONTWAIT) != 0)
+		nonblock_socket(socket_);
+
+	if(!open_poll())
+	{
+		close();
+		ec = errc::socket_error;
+	}
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+bool tcp_server<Endpoint, Flags, Options>::
 is_open() const noexcept
 {
 	return socket_ != 0;
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
+typename tcp_server<Endpoint, Flags, Options>::handler
+tcp_server<Endpoint, Flags, Options>::
+native() const noexcept
+{
+	return socket_;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+void
+tcp_server<Endpoint, Flags, Options>::
+options(socket_options const& opt) noexcept
+{
+	options_ = Options::options().merge(opt);
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+socket_options const&
+tcp_server<Endpoint, Flags, Options>::
+options() const noexcept
+{
+	return options_;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+void
+tcp_server<Endpoint, Flags, Options>::
+cork(handler socket, bool on, Error& ec) noexcept
+{
+	if(!POSIX::cork(socket, on))
+		ec = errc::socket_option;
+}
+
+#if defined(__linux__) && SOCA_USE_SELECT != 1
+template<class Endpoint,
+		int Flags,
+		class Options>
+void
+tcp_server<Endpoint, Flags, Options>::
+busy_poll(unsigned usecs, unsigned budget, bool prefer, Error& ec) noexcept
+{
+	if(!epoll_busy_poll(epoll_fd_, usecs, budget, prefer))
+		ec = errc::socket_option;
+}
+#endif /* defined(__linux__) && SOCA_USE_SELECT != 1 */
+
+template<class Endpoint,
+		int Flags,
+		class Options>
 bool
-tcp_server<Endpoint, Flags>::
+tcp_server<Endpoint, Flags, Options>::
 open_poll() noexcept
 {
 #if SOCA_USE_SELECT != 1
 	epoll_fd_ = epoll_create1(0);
 	if(epoll_fd_ == -1)
 		return false;
+#endif /* SOCA_USE_SELECT = 1 */
+	return add_listener_poll();
+}
 
-	if(!add_socket_poll(socket_, EPOLLIN | EPOLLOUT | EPOLLET))
+template<class Endpoint,
+		int Flags,
+		class Options>
+bool
+tcp_server<Endpoint, Flags, Options>::
+add_listener_poll() noexcept
+{
+#if SOCA_USE_SELECT != 1
+	/**
+	 * Level triggered: connections left by accept_batch wake the loop
+	 * again. Exclusive: a connection wakes only one of the loops
+	 * sharing the listener (share()). EPOLLEXCLUSIVE can't be modified,
+	 * so pause/resume remove and add it again.
+	 */
+#ifdef EPOLLEXCLUSIVE
+	if(!add_socket_poll(socket_, EPOLLIN | EPOLLEXCLUSIVE))
+#else /* EPOLLEXCLUSIVE */
+	if(!add_socket_poll(socket_, EPOLLIN))
+#endif /* EPOLLEXCLUSIVE */
 		return false;
-#endif /* SOCA_USE_SELECT = 1 */
+#endif /* SOCA_USE_SELECT != 1 */
+	accepting_ = true;
 	return true;
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 bool
-tcp_server<Endpoint, Flags>::
+tcp_server<Endpoint, Flags, Options>::
 add_socket_poll(handler socket, std::uint32_t events [[maybe_unused]]) noexcept
 {
 #if SOCA_USE_SELECT != 1
@@ -114,12 +258,230 @@ add_socket_poll(handler socket, std::uint32_t events [[maybe_unused]]) noexcept
 #if SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1
 	FD_SET(socket, &list_);
 #endif /* SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1 */
+	/**
+	 * The number may be of a watched socket closed by its owner. State is
+	 * only reset here (close_client may run at a dispatcher worker)
+	 */
+	state(socket, 0);
+	return true;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+std::uint8_t
+tcp_server<Endpoint, Flags, Options>::
+state(handler socket) const noexcept
+{
+#if SOCA_USE_SELECT != 1
+	std::size_t i = static_cast<std::size_t>(socket);
+	return i < fds_.size() ? fds_[i] : 0;
+#else /* SOCA_USE_SELECT != 1 */
+	return FD_ISSET(socket, &watched_) ? fd_watched : 0;
+#endif /* SOCA_USE_SELECT != 1 */
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+bool
+tcp_server<Endpoint, Flags, Options>::
+state(handler socket, std::uint8_t st) noexcept
+{
+#if SOCA_USE_SELECT != 1
+	std::size_t i = static_cast<std::size_t>(socket);
+	if(i >= fds_.size())
+	{
+		if(!st) return true;
+		try{
+			fds_.resize(i + 1);
+		}catch(...){
+			return false;
+		}
+	}
+	fds_[i] = st;
+#else /* SOCA_USE_SELECT != 1 */
+	if(st & fd_watched)
+		FD_SET(socket, &watched_);
+	else
+		FD_CLR(socket, &watched_);
+#endif /* SOCA_USE_SELECT != 1 */
+	return true;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+bool
+tcp_server<Endpoint, Flags, Options>::
+watch(handler socket, Error& ec [[maybe_unused]], bool writable /* = true */ [[maybe_unused]]) noexcept
+{
+#if SOCA_USE_SELECT != 1
+	struct epoll_event ev;
+	ev.events = EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLHUP;
+	if(writable) ev.events |= EPOLLOUT;
+	ev.data.fd = socket;
+	std::uint8_t mask = writable ? fd_writable : 0;
+	if(epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket, &ev) == -1)
+	{
+		/* Already at the loop (e.g. a accepted client): just add EPOLLOUT */
+		if(errno != EEXIST)
+		{
+			ec = errc::socket_error;
+			return false;
+		}
+		/* kept to restore the events at pause/resume */
+		if(!state(socket, static_cast<std::uint8_t>((state(socket) & ~fd_writable) | mask)))
+		{
+			ec = errc::out_of_resources;
+			return false;
+		}
+		if(epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, socket, &ev) == -1)
+		{
+			ec = errc::socket_error;
+			return false;
+		}
+		return true;
+	}
+	if(!state(socket, fd_watched | mask))
+	{
+		epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket, NULL);
+		ec = errc::out_of_resources;
+		return false;
+	}
+#else /* SOCA_USE_SELECT != 1 */
+	/* already at the loop: accepted or watched */
+	if(!FD_ISSET(socket, &list_))
+		state(socket, fd_watched);
+#endif /* SOCA_USE_SELECT != 1 */
+#if SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1
+	FD_SET(socket, &list_);
+#endif /* SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1 */
+	return true;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+void
+tcp_server<Endpoint, Flags, Options>::
+unwatch(handler socket) noexcept
+{
+#if SOCA_USE_SELECT != 1
+	epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket, NULL);
+#endif /* SOCA_USE_SELECT != 1 */
+#if SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1
+	FD_CLR(socket, &list_);
+#endif /* SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1 */
+	state(socket, 0);
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+bool
+tcp_server<Endpoint, Flags, Options>::
+adopt(handler socket, Error& ec) noexcept
+{
+#if SOCA_USE_SELECT != 1
+	if(!add_socket_poll(socket, EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLHUP))
+#else /* SOCA_USE_SELECT != 1 */
+	if(!add_socket_poll(socket, 0))
+#endif /* SOCA_USE_SELECT != 1 */
+	{
+		ec = errc::socket_error;
+		return false;
+	}
+	SOCA_METRIC_GAUGE(connections, 1);
+	return true;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+bool
+tcp_server<Endpoint, Flags, Options>::
+pause(handler socket, Error& ec) noexcept
+{
+#if SOCA_USE_SELECT != 1
+	int ret;
+	if(socket == socket_)
+	{
+		fd_limit_ = false;
+		ret = epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket_, NULL);
+		if(ret == -1 && errno == ENOENT) ret = 0;
+		if(ret == 0) accepting_ = false;
+	}
+	else
+	{
+		struct epoll_event ev;
+		ev.events = EPOLLET | EPOLLRDHUP | EPOLLHUP;
+		if(state(socket) & fd_writable) ev.events |= EPOLLOUT;
+		ev.data.fd = socket;
+		ret = epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, socket, &ev);
+	}
+	if(ret == -1)
+	{
+		ec = errc::socket_error;
+		return false;
+	}
+#else /* SOCA_USE_SELECT != 1 */
+	if(socket == socket_)
+	{
+		fd_limit_ = false;
+		accepting_ = false;
+	}
+	else
+		FD_CLR(socket, &list_);
+#endif /* SOCA_USE_SELECT != 1 */
+	return true;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+bool
+tcp_server<Endpoint, Flags, Options>::
+resume(handler socket, Error& ec) noexcept
+{
+#if SOCA_USE_SELECT != 1
+	int ret = 0;
+	if(socket == socket_)
+	{
+		if(!add_listener_poll())
+		{
+			if(errno != EEXIST) ret = -1;
+			else accepting_ = true;
+		}
+	}
+	else
+	{
+		/* modifying re-arms the edge: reported if data is pending */
+		struct epoll_event ev;
+		ev.events = EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLHUP;
+		if(state(socket) & fd_writable) ev.events |= EPOLLOUT;
+		ev.data.fd = socket;
+		ret = epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, socket, &ev);
+	}
+	if(ret == -1)
+	{
+		ec = errc::socket_error;
+		return false;
+	}
+#else /* SOCA_USE_SELECT != 1 */
+	(void)ec;
+	if(socket == socket_)
+		add_listener_poll();
+	else
+		FD_SET(socket, &list_);
+#endif /* SOCA_USE_SELECT != 1 */
 	return true;
 }
 
 template<class Endpoint,
-		int Flags>
-void tcp_server<Endpoint, Flags>::
+		int Flags,
+		class Options>
+void tcp_server<Endpoint, Flags, Options>::
 close() noexcept
 {
 #if SOCA_USE_SELECT != 1
@@ -130,6 +492,11 @@ close() noexcept
 #if SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1
 	FD_ZERO(&list_);
 #endif /* SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1 */
+#if SOCA_USE_SELECT != 1
+	fds_.clear();
+#else /* SOCA_USE_SELECT != 1 */
+	FD_ZERO(&watched_);
+#endif /* SOCA_USE_SELECT != 1 */
 	if(socket_)
 	{
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
@@ -139,11 +506,13 @@ close() noexcept
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
 	}
 	socket_ = 0;
+	fd_limit_ = false;
 }
 
 template<class Endpoint,
-	int Flags>
-void tcp_server<Endpoint, Flags>::
+	int Flags,
+	class Options>
+void tcp_server<Endpoint, Flags, Options>::
 close_client(handler socket) noexcept
 {
 #if SOCA_USE_SELECT != 1
@@ -152,6 +521,8 @@ close_client(handler socket) noexcept
 #if SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1
 	FD_CLR(socket, &list_);
 #endif /* SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1 */
+	SOCA_METRIC_ADD(closes, 1);
+	SOCA_METRIC_GAUGE(connections, -1);
 	::shutdown(socket, SHUT_RDWR);
 	
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
@@ -159,47 +530,158 @@ close_client(handler socket) noexcept
 #else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
 	::close(socket);
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	fd_released();
 }
 
 template<class Endpoint,
-		int Flags>
-typename tcp_server<Endpoint, Flags>::handler
-tcp_server<Endpoint, Flags>::
-accept(Error& ec) noexcept
+	int Flags,
+	class Options>
+void tcp_server<Endpoint, Flags, Options>::
+detach_client(handler socket) noexcept
 {
-	handler s = 0;
-	endpoint ep;
-	socklen_t len = sizeof(typename endpoint::native_type);
-	if((s = ::accept(socket_, reinterpret_cast<struct sockaddr*>(ep.native()), &len)) == -1)
+#if SOCA_USE_SELECT != 1
+	epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, socket, NULL);
+#endif /* SOCA_USE_SELECT != 1 */
+#if SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1
+	FD_CLR(socket, &list_);
+#endif /* SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1 */
+	SOCA_METRIC_GAUGE(connections, -1);
+	/* no shutdown: it would end the connection at the other processes too */
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+	::closesocket(socket);
+#else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	::close(socket);
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	fd_released();
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+void
+tcp_server<Endpoint, Flags, Options>::
+fd_released() noexcept
+{
+	if(!fd_limit_) return;
+	Error ec;
+	if(resume(socket_, ec)) fd_limit_ = false;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+typename tcp_server<Endpoint, Flags, Options>::handler
+tcp_server<Endpoint, Flags, Options>::
+accept_socket(Error& ec) noexcept
+{
+#if defined(__linux__)
+	/* no fcntl: non-blocking already */
+	handler s = ::accept4(socket_, nullptr, nullptr,
+			(Flags & MSG_DONTWAIT) != 0 ? SOCK_NONBLOCK | SOCK_CLOEXEC : SOCK_CLOEXEC);
+#else /* defined(__linux__) */
+	handler s = ::accept(socket_, nullptr, nullptr);
+#endif /* defined(__linux__) */
+	SOCA_PROBE(tcp_server_accept, s, 0, s == -1 ? errno : 0);
+	if(s == -1)
 	{
-		ec = errc::socket_error;
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+		int err = WSAGetLastError();
+		if(err == WSAEMFILE)
+#else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+		if(errno == EMFILE || errno == ENFILE)
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+			ec = errc::out_of_resources;
+		/* nothing to accept, or the connection is gone */
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+		else if(err != WSAEWOULDBLOCK && err != WSAECONNRESET)
+#else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+		else if(errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNABORTED && errno != EINTR)
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+			ec = errc::socket_error;
+		return s;
 	}
-	else
+
+	SOCA_METRIC_ADD(accepts, 1);
+	SOCA_METRIC_GAUGE(connections, 1);
+#if !defined(__linux__)
+	if constexpr((Flags & MSG_DONTWAIT) != 0)
+		nonblock_socket(s);
+#endif /* !defined(__linux__) */
+	/* the other options are inherited from the listening socket */
+	if constexpr(tcp_level<endpoint>::value)
+		if(options_.quickack > 0) quickack(s);
+	return s;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+typename tcp_server<Endpoint, Flags, Options>::handler
+tcp_server<Endpoint, Flags, Options>::
+accept(Error& ec) noexcept
+{
+	handler s = accept_socket(ec);
+	if(s == -1)
 	{
+		if(ec == errc::out_of_resources)
+		{
+			/**
+			 * Descriptors limit: the connection stays at the backlog and the
+			 * listener (level triggered) would wake the loop at once, again
+			 * and again. Paused until a connection is closed.
+			 */
+			ec.clear();
+			if(pause(socket_, ec)) fd_limit_ = true;
+		}
+		return s;
+	}
+
 #if SOCA_USE_SELECT != 1
-		if(!add_socket_poll(s, EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLHUP))
+	if(!add_socket_poll(s, EPOLLIN | EPOLLET | EPOLLRDHUP | EPOLLHUP))
 #else /* SOCA_USE_SELECT != 1 */
-		if(!add_socket_poll(s, 0))
+	if(!add_socket_poll(s, 0))
 #endif /* SOCA_USE_SELECT != 1 */
-			ec = errc::socket_error;
-		if constexpr((Flags & MSG_DONTWAIT) != 0)
-			nonblock_socket(s);
-	}
+		ec = errc::socket_error;
 	return s;
 }
 
+template<class Endpoint,
+		int Flags,
+		class Options>
+template<typename OpenCb>
+void
+tcp_server<Endpoint, Flags, Options>::
+accept_batch(Error& ec, OpenCb& open_cb [[maybe_unused]]) noexcept
+{
+	for(unsigned i = 0; i < SOCA_TCP_SERVER_ACCEPT_BATCH; i++)
+	{
+		handler c = accept(ec);
+		if(c == static_cast<handler>(-1)) break;
+		if constexpr(!std::is_same<void*, OpenCb>::value)
+		{
+			open_cb(c);
+		}
+		/* a blocking accept would wait the next connection */
+		if constexpr((Flags & MSG_DONTWAIT) == 0) break;
+		/* paused at open_cb (admission control) */
+		if(!accepting_) break;
+	}
+}
+
 #if SOCA_USE_SELECT != 1
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 template<
 		int BlockTimeMs /* = 0 */,
 		unsigned MaxEvents /* = 32 */,
+		unsigned SpinUs /* = 0 */,
 		typename ReadCb,
 		typename OpenCb /* = void* */,
 		typename CloseCb /* = void* */>
 bool
-tcp_server<Endpoint, Flags>::
+tcp_server<Endpoint, Flags, Options>::
 run(Error& ec,
 		ReadCb read_cb,
 		OpenCb open_cb/* = nullptr */ [[maybe_unused]],
@@ -207,21 +689,30 @@ run(Error& ec,
 {
 	struct epoll_event events[MaxEvents];
 
-	int event_num = epoll_wait(epoll_fd_, events, MaxEvents, BlockTimeMs);
+	int event_num;
+	if constexpr(SpinUs != 0)
+	{
+		spin_wait<SpinUs>(spin_,
+			[&]{
+				event_num = epoll_wait(epoll_fd_, events, MaxEvents, 0);
+				return event_num != 0;
+			},
+			[&]{ event_num = epoll_wait(epoll_fd_, events, MaxEvents, BlockTimeMs); });
+	}
+	else
+		event_num = epoll_wait(epoll_fd_, events, MaxEvents, BlockTimeMs);
 	for (int i = 0; i < event_num; i++)
 	{
 		if (events[i].data.fd == socket_)
 		{
-			[[maybe_unused]] int c = accept(ec);
-			if constexpr(!std::is_same<void*, OpenCb>::value)
-			{
-				open_cb(c);
-			}
+			accept_batch(ec, open_cb);
 		}
-		else if (events[i].events & EPOLLIN)
+		else if (events[i].events & (EPOLLIN | EPOLLOUT))
 		{
-			/* handle EPOLLIN event */
+			/* handle EPOLLIN event (EPOLLOUT only for watched sockets) */
 			handler s = events[i].data.fd;
+			SOCA_PROBE(tcp_server_dispatch, s, events[i].events, 0);
+			SOCA_METRIC_TIMER(timer, read_callback);
 			read_cb(s);
 		}
 		/* check if the connection is closing */
@@ -232,7 +723,57 @@ run(Error& ec,
 			{
 				close_cb(s);
 			}
-			close_client(s);
+			/* watched: closed by its owner */
+			if(state(s) & fd_watched)
+				unwatch(s);
+			else
+				close_client(s);
+		}
+	}
+	return ec ? false : true;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+template<
+		int BlockTimeMs /* = 0 */,
+		unsigned MaxEvents /* = 32 */,
+		typename Dispatcher,
+		typename OpenCb /* = void* */>
+bool
+tcp_server<Endpoint, Flags, Options>::
+run_dispatch(Error& ec,
+		Dispatcher& dispatcher,
+		OpenCb open_cb/* = nullptr */ [[maybe_unused]]) noexcept
+{
+	struct epoll_event events[MaxEvents];
+
+	int event_num = epoll_wait(epoll_fd_, events, MaxEvents, BlockTimeMs);
+	for (int i = 0; i < event_num; i++)
+	{
+		handler s = events[i].data.fd;
+		if (s == socket_)
+		{
+			accept_batch(ec, open_cb);
+			continue;
+		}
+		if (events[i].events & (EPOLLIN | EPOLLOUT))
+		{
+			SOCA_PROBE(tcp_server_dispatch, s, events[i].events, 0);
+			dispatcher.read(s);
+		}
+		if (events[i].events & (EPOLLRDHUP | EPOLLHUP))
+		{
+			/**
+			 * Out of the set here, so it is closed once: edge triggered, a
+			 * HUP may follow the RDHUP, and the worker close may release the
+			 * fd number to a new connection before it
+			 */
+			bool owned = !(state(s) & fd_watched);
+			unwatch(s);
+			/* closed at the worker, after the pending reads (watched: just reported) */
+			dispatcher.close(s, owned);
 		}
 	}
 	return ec ? false : true;
@@ -241,20 +782,24 @@ run(Error& ec,
 #else /* SOCA_USE_SELECT == 1 */
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 template<
 		int BlockTimeMs /* = 0 */,
 		unsigned MaxEvents /* = 32 */,
+		unsigned SpinUs /* = 0 */,
 		typename ReadCb,
 		typename OpenCb /* = void* */,
 		typename CloseCb /* = void* */>
 bool
-tcp_server<Endpoint, Flags>::
+tcp_server<Endpoint, Flags, Options>::
 run(Error& ec,
 		ReadCb read_cb,
 		OpenCb open_cb/* = nullptr */ [[maybe_unused]],
 		CloseCb close_cb/* = nullptr */ [[maybe_unused]]) noexcept
 {
+	static_assert(SpinUs == 0, "spinning requires epoll");
+
 	fd_set rfds;
 
 	struct timeval tv = {
@@ -263,7 +808,7 @@ run(Error& ec,
 	};
 
 	std::memcpy(&rfds, &list_, sizeof(fd_set));
-	FD_SET(socket_, &rfds);
+	if(accepting_) FD_SET(socket_, &rfds);
 
 	int max = 0;
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
@@ -290,19 +835,18 @@ run(Error& ec,
 		{
 			if(rfds.fd_array[i] == socket_)
 			{
-				[[maybe_unused]] handler c = accept(ec);
-				if constexpr(!std::is_same<void*, OpenCb>::value)
-				{
-					open_cb(c);
-				}
+				accept_batch(ec, open_cb);
 			}
-			else if(!read_cb(rfds.fd_array[i]))
+			else if(SOCA_METRIC_TIMER(timer, read_callback); !read_cb(rfds.fd_array[i]))
 			{
 				if constexpr(!std::is_same<void*, CloseCb>::value)
 				{
 					close_cb(rfds.fd_array[i]);
 				}
-				close_client(rfds.fd_array[i]);
+				if(state(rfds.fd_array[i]) & fd_watched)
+					unwatch(rfds.fd_array[i]);
+				else
+					close_client(rfds.fd_array[i]);
 			}
 			count++;
 		}
@@ -314,19 +858,18 @@ run(Error& ec,
 		{
 			if(i == socket_)
 			{
-				[[maybe_unused]] handler c = accept(ec);
-				if constexpr(!std::is_same<void*, OpenCb>::value)
-				{
-					open_cb(c);
-				}
+				accept_batch(ec, open_cb);
 			}
-			else if(!read_cb(i))
+			else if(SOCA_METRIC_TIMER(timer, read_callback); !read_cb(i))
 			{
 				if constexpr(!std::is_same<void*, CloseCb>::value)
 				{
 					close_cb(i);
 				}
-				close_client(i);
+				if(state(i) & fd_watched)
+					unwatch(i);
+				else
+					close_client(i);
 			}
 			count++;
 		}
@@ -338,9 +881,10 @@ run(Error& ec,
 #endif /* SOCA_USE_SELECT == 1 */
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 std::size_t
-tcp_server<Endpoint, Flags>::
+tcp_server<Endpoint, Flags, Options>::
 receive(handler socket, void* buffer, std::size_t buffer_len, Error& ec) noexcept
 {
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
@@ -348,6 +892,7 @@ receive(handler socket, void* buffer, std::size_t buffer_len, Error& ec) noexcep
 #else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
 	ssize_t bytes = ::recv(socket, buffer, buffer_len, 0);
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	SOCA_PROBE(tcp_server_receive, socket, bytes, bytes < 0 ? errno : 0);
 	if(bytes < 1)
 	{
 		if constexpr((Flags & MSG_DONTWAIT) != 0)
@@ -358,26 +903,55 @@ receive(handler socket, void* buffer, std::size_t buffer_len, Error& ec) noexcep
 			if(bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
 			{
+				SOCA_METRIC_ADD(would_block, 1);
 				return 0;
 			}
 		}
+		/* 0: closed by the peer, not an error (also sets ec) */
 		ec = errc::socket_receive;
+		if(bytes != 0) SOCA_METRIC_ADD(errors, 1);
 		return 0;
 	}
+	SOCA_METRIC_ADD(packets_received, 1);
+	SOCA_METRIC_ADD(bytes_received, bytes);
 	return bytes;
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 std::size_t
-tcp_server<Endpoint, Flags>::
+tcp_server<Endpoint, Flags, Options>::
+receive(handler socket, buffer& buf, Error& ec) noexcept
+{
+	if(!buf || !buf.unique())
+	{
+		buf = buffer{SOCA_BUFFER_POOL_DEFAULT_SIZE};
+		if(!buf)
+		{
+			ec = errc::insufficient_buffer;
+			return 0;
+		}
+	}
+	std::size_t size = receive(socket, buf.data(), buf.capacity(), ec);
+	buf.size(size);
+	return size;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+std::size_t
+tcp_server<Endpoint, Flags, Options>::
 send(handler to_socket, const void* buffer, std::size_t buffer_len, Error& ec)  noexcept
 {
+	SOCA_METRIC_TIMER(timer, send);
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
 	int size = ::send(to_socket, static_cast<const char*>(buffer), static_cast<int>(buffer_len), 0);
 #else /* #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
 	int size = ::send(to_socket, buffer, buffer_len, 0);
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	SOCA_PROBE(tcp_server_send, to_socket, size, size < 0 ? errno : 0);
 	if(size < 0)
 	{
 		if constexpr((Flags & MSG_DONTWAIT) != 0)
@@ -388,20 +962,140 @@ send(handler to_socket, const void* buffer, std::size_t buffer_len, Error& ec)
 			if(errno == EAGAIN || errno == EWOULDBLOCK)
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
 			{
+				SOCA_METRIC_ADD(would_block, 1);
 				return 0;
 			}
 		}
 		ec = errc::socket_send;
+		SOCA_METRIC_ADD(errors, 1);
 		return 0;
 	}
+	SOCA_METRIC_ADD(packets_sent, 1);
+	SOCA_METRIC_ADD(bytes_sent, size);
 	return size;
 }
 
+#if defined(__linux__)
+template<class Endpoint,
+		int Flags,
+		class Options>
+void
+tcp_server<Endpoint, Flags, Options>::
+timestamping(handler socket, unsigned flags, Error& ec) noexcept
+{
+	if(!enable_timestamping(socket, flags))
+		ec = errc::socket_option;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+std::size_t
+tcp_server<Endpoint, Flags, Options>::
+receive(handler socket, void* buffer, std::size_t buffer_len, timestamp& ts, Error& ec) noexcept
+{
+	ssize_t bytes = receive_timestamp(socket, buffer, buffer_len, nullptr, nullptr, ts);
+	SOCA_PROBE(tcp_server_receive, socket, bytes, bytes < 0 ? errno : 0);
+	if(bytes < 1)
+	{
+		if constexpr((Flags & MSG_DONTWAIT) != 0)
+		{
+			if(bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			{
+				SOCA_METRIC_ADD(would_block, 1);
+				return 0;
+			}
+		}
+		/* 0: closed by the peer, not an error (also sets ec) */
+		ec = errc::socket_receive;
+		if(bytes != 0) SOCA_METRIC_ADD(errors, 1);
+		return 0;
+	}
+	SOCA_METRIC_ADD(packets_received, 1);
+	SOCA_METRIC_ADD(bytes_received, bytes);
+	return bytes;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+bool
+tcp_server<Endpoint, Flags, Options>::
+tx_timestamp(handler socket, timestamp& ts) noexcept
+{
+	return read_tx_timestamp(socket, ts);
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+std::size_t
+tcp_server<Endpoint, Flags, Options>::
+send_file(handler to_socket, int file_fd,
+		std::size_t offset, std::size_t len, Error& ec) noexcept
+{
+	off_t off = static_cast<off_t>(offset);
+	ssize_t size = ::sendfile(to_socket, file_fd, &off, len);
+	SOCA_PROBE(tcp_server_send, to_socket, size, size < 0 ? errno : 0);
+	if(size < 0)
+	{
+		if constexpr((Flags & MSG_DONTWAIT) != 0)
+		{
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				SOCA_METRIC_ADD(would_block, 1);
+				return 0;
+			}
+		}
+		ec = errc::socket_send;
+		SOCA_METRIC_ADD(errors, 1);
+		return 0;
+	}
+	SOCA_METRIC_ADD(bytes_sent, size);
+	return size;
+}
+#endif /* defined(__linux__) */
+
+#if SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1
+template<class Endpoint,
+		int Flags,
+		class Options>
+io_awaiter<accept_op<tcp_server<Endpoint, Flags, Options>>>
+tcp_server<Endpoint, Flags, Options>::
+async_accept(executor& exec, Error& ec) noexcept
+{
+	return {exec, socket_, EPOLLIN, *this, ec};
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+io_awaiter<server_receive_op<tcp_server<Endpoint, Flags, Options>>>
+tcp_server<Endpoint, Flags, Options>::
+async_receive(executor& exec, handler socket,
+		void* buffer, std::size_t buffer_len, Error& ec) noexcept
+{
+	return {exec, socket, EPOLLIN, *this, socket, buffer, buffer_len, ec};
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+io_awaiter<server_send_op<tcp_server<Endpoint, Flags, Options>>>
+tcp_server<Endpoint, Flags, Options>::
+async_send(executor& exec, handler to_socket,
+		const void* buffer, std::size_t buffer_len, Error& ec) noexcept
+{
+	return {exec, to_socket, EPOLLOUT, *this, to_socket, buffer, buffer_len, ec};
+}
+#endif /* SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1 */
+
 #if SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 fd_set const&
-tcp_server<Endpoint, Flags>::
+tcp_server<Endpoint, Flags, Options>::
 client_list() const noexcept
 {
 	return list_;
@@ -0,0 +1,574 @@
+#ifndef SOCA_POSIX_UDP_SESSION_SERVER_IMPL_HPP__
+#define SOCA_POSIX_UDP_SESSION_SERVER_IMPL_HPP__
+
+#include "../udp_session_server.hpp"
+
+#include <type_traits>
+#include <cerrno>
+
+namespace Soca{
+namespace POSIX{
+
+template<class Endpoint,
+		class State,
+		int Flags>
+udp_session_server<Endpoint, State, Flags>::
+udp_session_server(config const& cfg /* = config{} */, std::uint64_t seed /* = 0 */)
+	: config_(cfg),
+	  slots_(new session[cfg.max_sessions ? cfg.max_sessions : 1]),
+	  sessions_(cfg.max_sessions ? cfg.max_sessions : 1, seed),
+	  wheel_(SOCA_UDP_SESSION_WHEEL_SLOTS,
+			  static_cast<std::uint64_t>(cfg.idle_timeout_ms) * 1000000 / (SOCA_UDP_SESSION_WHEEL_SLOTS - 1),
+			  now_ns())
+{
+	if(!config_.max_sessions) config_.max_sessions = 1;
+	if(!config_.batch) config_.batch = 1;
+#ifdef SO_REUSEPORT
+	if(!config_.unpin_rate) config_.unpin_rate = config_.pin_rate / 2;
+	if(config_.pin_rate) pinned_.resize(config_.max_pinned);
+#else /* SO_REUSEPORT */
+	config_.pin_rate = 0;
+#endif /* SO_REUSEPORT */
+	/* free list */
+	for(std::size_t i = config_.max_sessions; i-- > 0;)
+	{
+		slots_[i].next = free_;
+		free_ = static_cast<std::uint32_t>(i);
+	}
+
+	data_.reset(new std::uint8_t[config_.batch * config_.datagram_size]);
+	peers_.resize(config_.batch);
+	sizes_.resize(config_.batch);
+	next_.resize(config_.batch);
+	order_.reserve(config_.batch);
+	datagrams_.reserve(config_.batch);
+#if defined(__linux__)
+	msgs_.resize(config_.batch);
+	iovs_.resize(config_.batch);
+	for(unsigned i = 0; i < config_.batch; i++)
+	{
+		iovs_[i].iov_base = data_.get() + i * config_.datagram_size;
+		iovs_[i].iov_len = config_.datagram_size;
+		msgs_[i].msg_hdr = {};
+		msgs_[i].msg_hdr.msg_name = peers_[i].native();
+		msgs_[i].msg_hdr.msg_iov = &iovs_[i];
+		msgs_[i].msg_hdr.msg_iovlen = 1;
+	}
+#endif /* defined(__linux__) */
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+void
+udp_session_server<Endpoint, State, Flags>::
+open(endpoint& ep, Error& ec) noexcept
+{
+	if(config_.pin_rate)
+	{
+		/* the pinned sockets join its group */
+		socket_options opt;
+		opt.reuse_port = 1;
+		socket_.options(socket_.options().merge(opt));
+	}
+	socket_.open(ep, ec);
+	if(ec)
+	{
+		/* the socket is created before binding */
+		if(is_open()) socket_.close();
+		return;
+	}
+	if(!config_.pin_rate) return;
+
+	/* the port chosen, if 0 */
+	socklen_t len = sizeof(typename endpoint::native_type);
+	if(::getsockname(socket_.native(),
+			reinterpret_cast<struct sockaddr*>(local_.native()), &len) == -1)
+	{
+		ec = errc::socket_error;
+		socket_.close();
+		return;
+	}
+	local_.size(len);
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+void
+udp_session_server<Endpoint, State, Flags>::
+close() noexcept
+{
+	if(!is_open()) return;
+	for(std::uint32_t i = 0; i < pinned_.size(); i++)
+	{
+		if(pinned_[i].index == none) continue;
+		slots_[pinned_[i].index].pinned = none;
+		close_pinned(i);
+	}
+	socket_.close();
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+bool
+udp_session_server<Endpoint, State, Flags>::
+is_open() const noexcept
+{
+	/* closed is 0, a failed open -1 */
+	return socket_.native() > 0;
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+typename udp_session_server<Endpoint, State, Flags>::handler
+udp_session_server<Endpoint, State, Flags>::
+native() const noexcept
+{
+	return socket_.native();
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+std::size_t
+udp_session_server<Endpoint, State, Flags>::
+receive_batch(socket_type& sock, Error& ec) noexcept
+{
+#if defined(__linux__)
+	for(struct mmsghdr& msg : msgs_)
+		msg.msg_hdr.msg_namelen = sizeof(typename endpoint::native_type);
+
+	int count;
+	do count = ::recvmmsg(sock.native(), msgs_.data(), config_.batch, MSG_DONTWAIT, nullptr);
+	while(count == -1 && errno == EINTR);
+	if(count < 0)
+	{
+		if(errno != EAGAIN && errno != EWOULDBLOCK)
+		{
+			ec = errc::socket_receive;
+			SOCA_METRIC_ADD(errors, 1);
+		}
+		return 0;
+	}
+
+	std::size_t bytes = 0;
+	for(int i = 0; i < count; i++)
+	{
+		peers_[i].size(msgs_[i].msg_hdr.msg_namelen);
+		sizes_[i] = msgs_[i].msg_len;
+		bytes += msgs_[i].msg_len;
+	}
+	SOCA_METRIC_ADD(packets_received, count);
+	SOCA_METRIC_ADD(bytes_received, bytes);
+	return static_cast<std::size_t>(count);
+#else /* defined(__linux__) */
+	std::size_t count = 0;
+	while(count < config_.batch)
+	{
+		std::size_t size = sock.receive(data_.get() + count * config_.datagram_size,
+				config_.datagram_size, peers_[count], ec);
+		if(ec || !size) break;
+		sizes_[count++] = size;
+		/* a blocking receive would wait the next datagram */
+		if constexpr((Flags & MSG_DONTWAIT) == 0) break;
+	}
+	return count;
+#endif /* defined(__linux__) */
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+std::uint32_t
+udp_session_server<Endpoint, State, Flags>::
+lookup(endpoint_key const& key, bool& created, std::uint64_t now) noexcept
+{
+	created = false;
+	std::uint32_t* index = sessions_.find(key);
+	if(index) return *index;
+
+	if(free_ == none) return none;
+	index = sessions_.insert(key);
+	if(!index) return none;
+
+	std::uint32_t i = free_;
+	session& s = slots_[i];
+	free_ = s.next;
+
+	s.key = key;
+	s.state = State{};
+	s.last_ns = now;
+	s.window_ns = now;
+	s.packets = 0;
+	s.batch = 0;
+	s.first = s.last = 0;
+	s.generation++;
+	s.active = true;
+	*index = i;
+	SOCA_METRIC_GAUGE(sessions, 1);
+
+	/* a session never expired would hold the slot */
+	if(!wheel_.schedule(timer{i, s.generation},
+			now + static_cast<std::uint64_t>(config_.idle_timeout_ms) * 1000000))
+	{
+		release(i);
+		return none;
+	}
+	created = true;
+	return i;
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+void
+udp_session_server<Endpoint, State, Flags>::
+release(std::uint32_t index) noexcept
+{
+	session& s = slots_[index];
+	sessions_.erase(s.key);
+	if(s.pinned != none)
+	{
+		close_pinned(s.pinned);
+		s.pinned = none;
+	}
+	s.active = false;
+	/* not linked to a later session of the slot */
+	s.batch = 0;
+	s.first = s.last = 0;
+	/* wheel entry invalid */
+	s.generation++;
+	s.next = free_;
+	free_ = index;
+	SOCA_METRIC_GAUGE(sessions, -1);
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+template<int BlockTimeMs /* = 0 */,
+		typename DataCb,
+		typename OpenCb /* = void* */,
+		typename CloseCb /* = void* */>
+bool
+udp_session_server<Endpoint, State, Flags>::
+run(Error& ec, DataCb data_cb,
+		OpenCb open_cb /* = nullptr */ [[maybe_unused]],
+		CloseCb close_cb /* = nullptr */) noexcept
+{
+	struct timeval tv = {
+		/*.tv_sec = */BlockTimeMs / 1000,
+		/*.tv_usec = */(BlockTimeMs % 1000) * 1000
+	};
+	fd_set rfds;
+	FD_ZERO(&rfds);
+	FD_SET(socket_.native(), &rfds);
+	handler max = socket_.native();
+	for(pinned_peer const& p : pinned_)
+	{
+		if(p.index == none) continue;
+		FD_SET(p.socket.native(), &rfds);
+		if(p.socket.native() > max) max = p.socket.native();
+	}
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+	(void)max;
+	int ready = select(0, &rfds, NULL, NULL, BlockTimeMs < 0 ? NULL : &tv);
+#else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	int ready = select(max + 1, &rfds, NULL, NULL, BlockTimeMs < 0 ? NULL : &tv);
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	if(ready < 0 && errno != EINTR)
+	{
+		ec = errc::socket_receive;
+		return false;
+	}
+
+	if(ready > 0)
+	{
+		if(FD_ISSET(socket_.native(), &rfds))
+		{
+			std::size_t count = receive_batch(socket_, ec);
+			if(count) dispatch(count, none, data_cb, open_cb);
+		}
+		for(std::uint32_t i = 0; i < pinned_.size(); i++)
+		{
+			pinned_peer& p = pinned_[i];
+			/* unpinned by a callback */
+			if(p.index == none || !FD_ISSET(p.socket.native(), &rfds)) continue;
+			Error ecp;
+			std::size_t count = receive_batch(p.socket, ecp);
+			if(count) dispatch(count, p.index, data_cb, open_cb);
+			else if(ecp && p.index != none)
+			{
+				/* ICMP error reported at the connected socket: back to the shared one */
+				session& s = slots_[p.index];
+				pin_changes_.push_back(pin_change{p.index, s.generation, false});
+			}
+		}
+		apply_pins(data_cb, open_cb);
+	}
+
+	expire(close_cb);
+	return ec ? false : true;
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+template<typename DataCb, typename OpenCb>
+void
+udp_session_server<Endpoint, State, Flags>::
+dispatch(std::size_t count, std::uint32_t known, DataCb& data_cb, OpenCb& open_cb [[maybe_unused]]) noexcept
+{
+	std::uint64_t now = now_ns();
+	batch_++;
+	order_.clear();
+
+	/* each session datagrams linked, in arrival order */
+	for(std::uint32_t i = 0; i < count; i++)
+	{
+		std::uint32_t index = known;
+		if(index == none)
+		{
+			bool created;
+			index = lookup(endpoint_key{peers_[i]}, created, now);
+			if(index == none)
+			{
+				dropped_++;
+				SOCA_METRIC_ADD(session_drops, 1);
+				continue;
+			}
+			if(created)
+			{
+				slots_[index].peer = peers_[i];
+				if constexpr(!std::is_same<void*, OpenCb>::value)
+				{
+					open_cb(slots_[index]);
+					/* rejected (closed) by the callback: the slot is free */
+					if(!slots_[index].active) continue;
+				}
+			}
+		}
+
+		session& s = slots_[index];
+		s.last_ns = now;
+		s.packets++;
+		next_[i] = none;
+		if(s.batch != batch_)
+		{
+			s.batch = batch_;
+			s.first = i;
+			order_.push_back(index);
+		}
+		else
+			next_[s.last] = i;
+		s.last = i;
+	}
+
+	for(std::uint32_t index : order_)
+	{
+		session& s = slots_[index];
+		/* closed by a callback of this batch */
+		if(!s.active || s.batch != batch_) continue;
+		datagrams_.clear();
+		for(std::uint32_t i = s.first; i != none; i = next_[i])
+			datagrams_.push_back(datagram{data_.get() + i * config_.datagram_size, sizes_[i]});
+		data_cb(s, datagrams_.data(), datagrams_.size());
+		if(s.active) measure(s, index, now);
+	}
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+void
+udp_session_server<Endpoint, State, Flags>::
+measure(session& s, std::uint32_t index, std::uint64_t now) noexcept
+{
+	if(!config_.pin_rate) return;
+	std::uint64_t elapsed = now - s.window_ns;
+	if(elapsed < static_cast<std::uint64_t>(config_.rate_window_ms) * 1000000) return;
+
+	std::uint64_t rate = static_cast<std::uint64_t>(s.packets) * 1000000000 / elapsed;
+	s.window_ns = now;
+	s.packets = 0;
+	if(s.pinned == none)
+	{
+		if(rate >= config_.pin_rate && pinned_count_ < pinned_.size())
+			pin_changes_.push_back(pin_change{index, s.generation, true});
+	}
+	else if(rate < config_.unpin_rate)
+		pin_changes_.push_back(pin_change{index, s.generation, false});
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+template<typename DataCb, typename OpenCb>
+void
+udp_session_server<Endpoint, State, Flags>::
+apply_pins(DataCb& data_cb, OpenCb& open_cb) noexcept
+{
+	/* the drains may add changes */
+	while(!pin_changes_.empty())
+	{
+		pin_change change = pin_changes_.back();
+		pin_changes_.pop_back();
+
+		session& s = slots_[change.index];
+		if(!s.active || s.generation != change.generation) continue;
+		if(change.pin && s.pinned == none)
+			pin(change.index, data_cb, open_cb);
+		else if(!change.pin && s.pinned != none)
+		{
+			std::uint32_t slot = s.pinned;
+			/* datagrams queued, before the peer is back at the shared socket */
+			drain(slot, change.index, data_cb, open_cb);
+			if(pinned_[slot].index != change.index) continue;
+			close_pinned(slot);
+			s.pinned = none;
+		}
+	}
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+template<typename DataCb, typename OpenCb>
+void
+udp_session_server<Endpoint, State, Flags>::
+pin(std::uint32_t index, DataCb& data_cb, OpenCb& open_cb) noexcept
+{
+	std::uint32_t slot = 0;
+	while(slot < pinned_.size() && pinned_[slot].index != none) slot++;
+	if(slot == pinned_.size()) return;
+
+	session& s = slots_[index];
+	socket_type& sock = pinned_[slot].socket;
+	Error ec;
+	/* same options of the shared socket, SO_REUSEPORT included */
+	sock.options(socket_.options());
+	sock.open(local_, ec);
+	if(!ec) sock.connect(s.peer, ec);
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+	if(!ec && sock.native() >= FD_SETSIZE) ec = errc::out_of_resources;
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+	if(ec)
+	{
+		sock.close();
+		return;
+	}
+
+	pinned_[slot].index = index;
+	s.pinned = slot;
+	pinned_count_++;
+	SOCA_METRIC_ADD(peer_pins, 1);
+	SOCA_METRIC_GAUGE(pinned_peers, 1);
+
+	/**
+	 * Bound, the socket is at the SO_REUSEPORT group before connected: it
+	 * may have received datagrams of other peers
+	 */
+	drain(slot, index, data_cb, open_cb);
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+template<typename DataCb, typename OpenCb>
+void
+udp_session_server<Endpoint, State, Flags>::
+drain(std::uint32_t slot, std::uint32_t index, DataCb& data_cb, OpenCb& open_cb) noexcept
+{
+	std::size_t count;
+	do{
+		Error ec;
+		count = receive_batch(pinned_[slot].socket, ec);
+		/* any peer: looked up */
+		if(count) dispatch(count, none, data_cb, open_cb);
+	}while(count == config_.batch && pinned_[slot].index == index);
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+void
+udp_session_server<Endpoint, State, Flags>::
+close_pinned(std::uint32_t slot) noexcept
+{
+	pinned_[slot].socket.close();
+	pinned_[slot].index = none;
+	pinned_count_--;
+	SOCA_METRIC_ADD(peer_unpins, 1);
+	SOCA_METRIC_GAUGE(pinned_peers, -1);
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+template<typename CloseCb /* = void* */>
+std::size_t
+udp_session_server<Endpoint, State, Flags>::
+expire(CloseCb close_cb /* = nullptr */ [[maybe_unused]]) noexcept
+{
+	std::uint64_t now = now_ns();
+	std::uint64_t timeout = static_cast<std::uint64_t>(config_.idle_timeout_ms) * 1000000;
+	std::size_t evicted = 0;
+	wheel_.advance(now, [&](timer const& t){
+		session& s = slots_[t.index];
+		if(!s.active || s.generation != t.generation) return;
+		if(now - s.last_ns < timeout)
+		{
+			/* active since scheduled (if not rescheduled, evicted now) */
+			if(wheel_.schedule(t, s.last_ns + timeout)) return;
+		}
+		if constexpr(!std::is_same<void*, CloseCb>::value)
+		{
+			close_cb(s);
+		}
+		release(t.index);
+		evicted++;
+	});
+	return evicted;
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+std::size_t
+udp_session_server<Endpoint, State, Flags>::
+send(session& s, const void* buffer, std::size_t buffer_len, Error& ec) noexcept
+{
+	if(s.pinned != none)
+		return pinned_[s.pinned].socket.send(buffer, buffer_len, ec);
+	return socket_.send(buffer, buffer_len, s.peer, ec);
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+typename udp_session_server<Endpoint, State, Flags>::session*
+udp_session_server<Endpoint, State, Flags>::
+find(endpoint_key const& key) noexcept
+{
+	std::uint32_t* index = sessions_.find(key);
+	return index ? &slots_[*index] : nullptr;
+}
+
+template<class Endpoint,
+		class State,
+		int Flags>
+void
+udp_session_server<Endpoint, State, Flags>::
+close(session& s) noexcept
+{
+	if(!s.active) return;
+	release(static_cast<std::uint32_t>(&s - slots_.get()));
+}
+
+}//POSIX
+}//Soca
+
+#endif /* SOCA_POSIX_UDP_SESSION_SERVER_IMPL_HPP__ */
@@ -10,52 +10,71 @@ namespace Soca{
 namespace POSIX{
 
 template<class Endpoint,
-		int Flags>
-udp<Endpoint, Flags>::
+		int Flags,
+		class Options>
+udp<Endpoint, Flags, Options>::
 udp() : socket_(0){}
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 void
-udp<Endpoint, Flags>::
+udp<Endpoint, Flags, Options>::
 open(Error& ec) noexcept
 {
-	if((socket_ = ::socket(endpoint::ep_family, SOCK_DGRAM, IPPROTO_UDP)) == -1)
+	if((socket_ = ::socket(endpoint::ep_family, SOCK_DGRAM, 0)) == -1)
 	{
 		ec = errc::socket_error;
 		return;
 	}
+	if(!apply_options(socket_, options_, false, ec))
+	{
+		close();
+		return;
+	}
 	if constexpr((Flags & MSG_DONTWAIT) != 0)
 		nonblock_socket(socket_);
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 void
-udp<Endpoint, Flags>::
+udp<Endpoint, Flags, Options>::
 open(sa_family_t family, Error& ec) noexcept
 {
-	if((socket_ = ::socket(family, SOCK_DGRAM, IPPROTO_UDP)) == -1)
+	if((socket_ = ::socket(family, SOCK_DGRAM, 0)) == -1)
 	{
 		ec = errc::socket_error;
 		return;
 	}
+	if(!apply_options(socket_, options_, false, ec))
+	{
+		close();
+		return;
+	}
 	if constexpr((Flags & MSG_DONTWAIT) != 0)
 		nonblock_socket(socket_);
 
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 void
-udp<Endpoint, Flags>::
+udp<Endpoint, Flags, Options>::
 open(endpoint& ep, Error& ec) noexcept
 {
-	if((socket_ = ::socket(ep.family(), SOCK_DGRAM, IPPROTO_UDP)) == -1)
+	if((socket_ = ::socket(ep.family(), SOCK_DGRAM, 0)) == -1)
 	{
 		ec = errc::socket_error;
 		return;
 	}
+	if(!apply_options(socket_, options_, false, ec))
+	{
+		close();
+		return;
+	}
 	if constexpr((Flags & MSG_DONTWAIT) != 0)
 		nonblock_socket(socket_);
 
@@ -63,23 +82,40 @@ open(endpoint& ep, Error& ec) noexcept
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 void
-udp<Endpoint, Flags>::
+udp<Endpoint, Flags, Options>::
 bind(endpoint& ep, Error& ec) noexcept
 {
 	if (::bind(socket_,
 		reinterpret_cast<struct sockaddr const*>(ep.native()),
-		sizeof(typename endpoint::native_type)) == -1)
+		ep.size()) == -1)
 	{
 		ec = errc::socket_bind;
 	}
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
+void
+udp<Endpoint, Flags, Options>::
+connect(endpoint& ep, Error& ec) noexcept
+{
+	if(::connect(socket_,
+		reinterpret_cast<struct sockaddr const*>(ep.native()),
+		ep.size()) == -1)
+	{
+		ec = errc::socket_error;
+	}
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
 void
-udp<Endpoint, Flags>::
+udp<Endpoint, Flags, Options>::
 close() noexcept
 {
 	::shutdown(socket_, SHUT_RDWR);
@@ -92,52 +128,173 @@ close() noexcept
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
+typename udp<Endpoint, Flags, Options>::handler
+udp<Endpoint, Flags, Options>::
+native() const noexcept
+{
+	return socket_;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+void
+udp<Endpoint, Flags, Options>::
+options(socket_options const& opt) noexcept
+{
+	options_ = Options::options().merge(opt);
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+socket_options const&
+udp<Endpoint, Flags, Options>::
+options() const noexcept
+{
+	return options_;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
 std::size_t
-udp<Endpoint, Flags>::
+udp<Endpoint, Flags, Options>::
 send(const void* buffer, std::size_t buffer_len, endpoint& ep, Error& ec) noexcept
 {
+	SOCA_METRIC_TIMER(timer, send);
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
 	int sent = ::sendto(socket_, static_cast<const char*>(buffer), static_cast<int>(buffer_len), 0,
 				reinterpret_cast<struct sockaddr const*>(ep.native()),
-				sizeof(typename endpoint::native_type));
+				ep.size());
 #else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
 	int sent = ::sendto(socket_, buffer, buffer_len, 0,
 				reinterpret_cast<struct sockaddr const*>(ep.native()),
-				sizeof(typename endpoint::native_type));
+				ep.size());
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	SOCA_PROBE(udp_send, socket_, sent, sent < 0 ? errno : 0);
 	if(sent < 0)
 	{
+		if constexpr((Flags & MSG_DONTWAIT) != 0)
+		{
+#if	defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+			if(WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+			{
+				SOCA_METRIC_ADD(would_block, 1);
+				return 0;
+			}
+		}
 		ec = errc::socket_send;
+		SOCA_METRIC_ADD(errors, 1);
 		return 0;
 	}
 
+	SOCA_METRIC_ADD(packets_sent, 1);
+	SOCA_METRIC_ADD(bytes_sent, sent);
 	return sent;
 }
 
 template<class Endpoint,
-		int Flags>
+		int Flags,
+		class Options>
 std::size_t
-udp<Endpoint, Flags>::
+udp<Endpoint, Flags, Options>::
 receive(void* buffer, std::size_t buffer_len, endpoint& ep, Error& ec) noexcept
 {
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
-	/**
-	 * sockaddr_storage fits both IPv4 and IPv6
-	 */
-	int addr_len = sizeof(struct sockaddr_storage);
+	int addr_len = sizeof(typename endpoint::native_type);
 	int recv = ::recvfrom(socket_,
 			static_cast<char*>(buffer), static_cast<int>(buffer_len), 0,
 			reinterpret_cast<struct sockaddr*>(ep.native()), &addr_len);
 #else /* #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
-	/**
-	 * sockaddr_storage fits both IPv4 and IPv6
-	 */
-	unsigned addr_len = sizeof(struct sockaddr_storage);
+	socklen_t addr_len = sizeof(typename endpoint::native_type);
 	int recv = ::recvfrom(socket_,
 			buffer, buffer_len, 0,
 			reinterpret_cast<struct sockaddr*>(ep.native()), &addr_len);
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	SOCA_PROBE(udp_receive, socket_, recv, recv < 0 ? errno : 0);
+
+	if(recv < 0)
+	{
+		if constexpr((Flags & MSG_DONTWAIT) != 0)
+		{
+#if	defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+			if(WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+			{
+				SOCA_METRIC_ADD(would_block, 1);
+				return 0;
+			}
+		}
+		ec = errc::socket_receive;
+		SOCA_METRIC_ADD(errors, 1);
+		return 0;
+	}
+	ep.size(static_cast<socklen_t>(addr_len));
+
+	SOCA_METRIC_ADD(packets_received, 1);
+	SOCA_METRIC_ADD(bytes_received, recv);
+	return recv;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+std::size_t
+udp<Endpoint, Flags, Options>::
+send(const void* buffer, std::size_t buffer_len, Error& ec) noexcept
+{
+	SOCA_METRIC_TIMER(timer, send);
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+	int sent = ::send(socket_, static_cast<const char*>(buffer), static_cast<int>(buffer_len), 0);
+#else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	int sent = ::send(socket_, buffer, buffer_len, 0);
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	SOCA_PROBE(udp_send, socket_, sent, sent < 0 ? errno : 0);
+	if(sent < 0)
+	{
+		if constexpr((Flags & MSG_DONTWAIT) != 0)
+		{
+#if	defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+			if(WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+			{
+				SOCA_METRIC_ADD(would_block, 1);
+				return 0;
+			}
+		}
+		ec = errc::socket_send;
+		SOCA_METRIC_ADD(errors, 1);
+		return 0;
+	}
+
+	SOCA_METRIC_ADD(packets_sent, 1);
+	SOCA_METRIC_ADD(bytes_sent, sent);
+	return sent;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+std::size_t
+udp<Endpoint, Flags, Options>::
+receive(void* buffer, std::size_t buffer_len, Error& ec) noexcept
+{
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+	int recv = ::recv(socket_, static_cast<char*>(buffer), static_cast<int>(buffer_len), 0);
+#else /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	int recv = ::recv(socket_, buffer, buffer_len, 0);
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+	SOCA_PROBE(udp_receive, socket_, recv, recv < 0 ? errno : 0);
 
 	if(recv < 0)
 	{
@@ -148,22 +305,190 @@ receive(void* buffer, std::size_t buffer_len, endpoint& ep, Error& ec) noexcept
 #else
 			if(errno == EAGAIN || errno == EWOULDBLOCK)
 #endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+			{
+				SOCA_METRIC_ADD(would_block, 1);
+				return 0;
+			}
+		}
+		ec = errc::socket_receive;
+		SOCA_METRIC_ADD(errors, 1);
+		return 0;
+	}
+
+	SOCA_METRIC_ADD(packets_received, 1);
+	SOCA_METRIC_ADD(bytes_received, recv);
+	return recv;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+std::size_t
+udp<Endpoint, Flags, Options>::
+receive(buffer& buf, endpoint& ep, Error& ec) noexcept
+{
+	if(!buf || !buf.unique())
+	{
+		buf = buffer{SOCA_BUFFER_POOL_DEFAULT_SIZE};
+		if(!buf)
+		{
+			ec = errc::insufficient_buffer;
+			return 0;
+		}
+	}
+	std::size_t size = receive(buf.data(), buf.capacity(), ep, ec);
+	buf.size(size);
+	return size;
+}
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+template<class Endpoint,
+		int Flags,
+		class Options>
+void
+udp<Endpoint, Flags, Options>::
+pktinfo(Error& ec) noexcept
+{
+	if(!enable_packet_info(socket_))
+		ec = errc::socket_option;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+std::size_t
+udp<Endpoint, Flags, Options>::
+receive(void* buffer, std::size_t buffer_len, endpoint& ep, packet_info& info, Error& ec) noexcept
+{
+	socklen_t addr_len = sizeof(typename endpoint::native_type);
+	ssize_t recv = receive_packet_info(socket_, buffer, buffer_len, ep.native(), &addr_len, info);
+	SOCA_PROBE(udp_receive, socket_, recv, recv < 0 ? errno : 0);
+	if(recv < 0)
+	{
+		if constexpr((Flags & MSG_DONTWAIT) != 0)
+		{
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				SOCA_METRIC_ADD(would_block, 1);
+				return 0;
+			}
+		}
+		ec = errc::socket_receive;
+		SOCA_METRIC_ADD(errors, 1);
+		return 0;
+	}
+	ep.size(static_cast<socklen_t>(addr_len));
+
+	SOCA_METRIC_ADD(packets_received, 1);
+	SOCA_METRIC_ADD(bytes_received, recv);
+	return recv;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+std::size_t
+udp<Endpoint, Flags, Options>::
+send(const void* buffer, std::size_t buffer_len, endpoint& ep, packet_info const& info, Error& ec) noexcept
+{
+	SOCA_METRIC_TIMER(timer, send);
+	ssize_t sent = send_packet_info(socket_, buffer, buffer_len, ep.native(), ep.size(), info);
+	SOCA_PROBE(udp_send, socket_, sent, sent < 0 ? errno : 0);
+	if(sent < 0)
+	{
+		if constexpr((Flags & MSG_DONTWAIT) != 0)
+		{
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				SOCA_METRIC_ADD(would_block, 1);
+				return 0;
+			}
+		}
+		ec = errc::socket_send;
+		SOCA_METRIC_ADD(errors, 1);
+		return 0;
+	}
+
+	SOCA_METRIC_ADD(packets_sent, 1);
+	SOCA_METRIC_ADD(bytes_sent, sent);
+	return sent;
+}
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+
+#if defined(__linux__)
+template<class Endpoint,
+		int Flags,
+		class Options>
+void
+udp<Endpoint, Flags, Options>::
+timestamping(unsigned flags, Error& ec) noexcept
+{
+	if(!enable_timestamping(socket_, flags))
+		ec = errc::socket_option;
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+std::size_t
+udp<Endpoint, Flags, Options>::
+receive(void* buffer, std::size_t buffer_len, endpoint& ep, timestamp& ts, Error& ec) noexcept
+{
+	socklen_t addr_len = sizeof(typename endpoint::native_type);
+	ssize_t recv = receive_timestamp(socket_, buffer, buffer_len, ep.native(), &addr_len, ts);
+	SOCA_PROBE(udp_receive, socket_, recv, recv < 0 ? errno : 0);
+	if(recv < 0)
+	{
+		if constexpr((Flags & MSG_DONTWAIT) != 0)
+		{
+			if(errno == EAGAIN || errno == EWOULDBLOCK)
+			{
+				SOCA_METRIC_ADD(would_block, 1);
 				return 0;
+			}
 		}
 		ec = errc::socket_receive;
+		SOCA_METRIC_ADD(errors, 1);
 		return 0;
 	}
+	ep.size(static_cast<socklen_t>(addr_len));
 
+	SOCA_METRIC_ADD(packets_received, 1);
+	SOCA_METRIC_ADD(bytes_received, recv);
 	return recv;
 }
 
 template<class Endpoint,
-		int Flags>
-template<int BlockTimeMs>
+		int Flags,
+		class Options>
+bool
+udp<Endpoint, Flags, Options>::
+tx_timestamp(timestamp& ts) noexcept
+{
+	return read_tx_timestamp(socket_, ts);
+}
+#endif /* defined(__linux__) */
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+template<int BlockTimeMs, unsigned SpinUs /* = 0 */>
 std::size_t
-udp<Endpoint, Flags>::
+udp<Endpoint, Flags, Options>::
 receive(void* buffer, std::size_t buffer_len, endpoint& ep, Error& ec) noexcept
 {
+	if constexpr(SpinUs != 0)
+	{
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+		static_assert(SpinUs == 0, "spinning not supported");
+#endif /* defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__) */
+		std::size_t size = 0;
+		spin_wait<SpinUs>(spin_,
+			[&]{ return try_receive(buffer, buffer_len, ep, size, ec); },
+			[&]{ size = receive<BlockTimeMs>(buffer, buffer_len, ep, ec); });
+		return size;
+	}
+
 	struct timeval tv = {
 		/*.tv_sec = */BlockTimeMs / 1000,
 		/*.tv_usec = */(BlockTimeMs % 1000) * 1000
@@ -191,6 +516,67 @@ receive(void* buffer, std::size_t buffer_len, endpoint& ep, Error& ec) noexcept
 	return 0;
 }
 
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+/**
+ * Non-blocking receive, even if the socket is blocking. Returns false if
+ * there is nothing to read.
+ */
+template<class Endpoint,
+		int Flags,
+		class Options>
+bool
+udp<Endpoint, Flags, Options>::
+try_receive(void* buffer, std::size_t buffer_len, endpoint& ep,
+		std::size_t& size, Error& ec) noexcept
+{
+	socklen_t addr_len = sizeof(typename endpoint::native_type);
+	ssize_t recv = ::recvfrom(socket_,
+			buffer, buffer_len, MSG_DONTWAIT,
+			reinterpret_cast<struct sockaddr*>(ep.native()), &addr_len);
+	if(recv < 0)
+	{
+		if(errno == EAGAIN || errno == EWOULDBLOCK) return false;
+		SOCA_PROBE(udp_receive, socket_, recv, errno);
+		ec = errc::socket_receive;
+		SOCA_METRIC_ADD(errors, 1);
+		return true;
+	}
+	SOCA_PROBE(udp_receive, socket_, recv, 0);
+	ep.size(static_cast<socklen_t>(addr_len));
+
+	SOCA_METRIC_ADD(packets_received, 1);
+	SOCA_METRIC_ADD(bytes_received, recv);
+	size = static_cast<std::size_t>(recv);
+	return true;
+}
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+
+#if SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+io_awaiter<receive_from_op<udp<Endpoint, Flags, Options>>>
+udp<Endpoint, Flags, Options>::
+async_receive(executor& exec, void* buffer, std::size_t buffer_len,
+		endpoint& ep, Error& ec) noexcept
+{
+	return {exec, socket_, EPOLLIN, *this, buffer, buffer_len, ep, ec};
+}
+
+template<class Endpoint,
+		int Flags,
+		class Options>
+io_awaiter<send_to_op<udp<Endpoint, Flags, Options>>>
+udp<Endpoint, Flags, Options>::
+async_send(executor& exec, const void* buffer, std::size_t buffer_len,
+		endpoint& ep, Error& ec) noexcept
+{
+	return {exec, socket_, EPOLLOUT, *this, buffer, buffer_len, ep, ec};
+}
+
+#endif /* SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1 */
+
 }//POSIX
 }//Soca
 
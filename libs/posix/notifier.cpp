@@ -0,0 +1,65 @@
+#include "notifier.hpp"
+
+#if defined(__linux__)
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace Soca{
+namespace POSIX{
+
+notifier::notifier()
+	: fd_(-1){}
+
+notifier::~notifier()
+{
+	if(is_open()) close();
+}
+
+void notifier::open(Error& ec) noexcept
+{
+	fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(fd_ == -1)
+		ec = errc::socket_error;
+}
+
+void notifier::assign(handler fd) noexcept
+{
+	if(is_open()) close();
+	fd_ = fd;
+}
+
+bool notifier::is_open() const noexcept
+{
+	return fd_ != -1;
+}
+
+void notifier::close() noexcept
+{
+	if(fd_ != -1) ::close(fd_);
+	fd_ = -1;
+}
+
+notifier::handler notifier::native() const noexcept
+{
+	return fd_;
+}
+
+void notifier::notify() noexcept
+{
+	std::uint64_t one = 1;
+	[[maybe_unused]] ssize_t n = ::write(fd_, &one, sizeof(one));
+}
+
+std::uint64_t notifier::consume() noexcept
+{
+	std::uint64_t count = 0;
+	if(::read(fd_, &count, sizeof(count)) != sizeof(count))
+		return 0;
+	return count;
+}
+
+}//POSIX
+}//Soca
+
+#endif /* defined(__linux__) */
@@ -0,0 +1,58 @@
+#ifndef SOCA_POSIX_NOTIFIER_HPP__
+#define SOCA_POSIX_NOTIFIER_HPP__
+
+#if defined(__linux__)
+
+#include <cstdlib>
+#include <cstdint>
+#include "../error.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Cross-thread wakeup of a event loop (eventfd)
+ *
+ * Add it to the tcp_server loop (watch(native(), ec, false)). Other
+ * threads push to a queue (spsc_queue/mpsc_queue) and call notify();
+ * the loop thread sleeps at epoll_wait until then. At read_cb,
+ * consume() and drain the queue.
+ */
+class notifier{
+	public:
+		using handler = int;
+
+		notifier();
+		~notifier();
+
+		void open(Error&) noexcept;
+		/**
+		 * \brief Takes ownership of a eventfd opened elsewhere (e.g.
+		 * received from other process)
+		 */
+		void assign(handler) noexcept;
+		bool is_open() const noexcept;
+		void close() noexcept;
+
+		handler native() const noexcept;
+
+		/**
+		 * \brief Wakes the loop. Any thread.
+		 */
+		void notify() noexcept;
+
+		/**
+		 * \brief Clears the notifications. Returns the number of notify()
+		 * calls since last consume().
+		 */
+		std::uint64_t consume() noexcept;
+	private:
+		handler		fd_;
+};
+
+}//POSIX
+}//Soca
+
+#endif /* defined(__linux__) */
+
+#endif /* SOCA_POSIX_NOTIFIER_HPP__ */
@@ -0,0 +1,188 @@
+#ifndef SOCA_POSIX_PIPELINED_CLIENT_HPP__
+#define SOCA_POSIX_PIPELINED_CLIENT_HPP__
+
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+
+#include "../error.hpp"
+#include "tcp_client.hpp"
+
+/**
+ * Maximum frame (header + payload) received; bigger frames close the
+ * connection (errc::invalid_data)
+ */
+#ifndef SOCA_PIPELINE_MAX_FRAME
+#define SOCA_PIPELINE_MAX_FRAME		(64 * 1024)
+#endif /* SOCA_PIPELINE_MAX_FRAME */
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Default framing of pipelined_client
+ *
+ * Header: payload length (u32) | id (u32), network byte order.
+ *
+ * Other framings must define the same members: header_size,
+ * write_header (returns the bytes written), frame_size (0 if the header
+ * is not complete) and id.
+ */
+struct length_id_framing{
+	static constexpr const std::size_t header_size = 8;
+
+	static std::size_t write_header(std::uint8_t* out, std::uint32_t id, std::size_t payload_len) noexcept
+	{
+		write32(out, static_cast<std::uint32_t>(payload_len));
+		write32(out + 4, id);
+		return header_size;
+	}
+
+	static std::size_t frame_size(std::uint8_t const* data, std::size_t len) noexcept
+	{
+		if(len < header_size) return 0;
+		return header_size + read32(data);
+	}
+
+	static std::uint32_t id(std::uint8_t const* frame) noexcept
+	{
+		return read32(frame + 4);
+	}
+private:
+	static void write32(std::uint8_t* out, std::uint32_t value) noexcept
+	{
+		out[0] = static_cast<std::uint8_t>(value >> 24);
+		out[1] = static_cast<std::uint8_t>(value >> 16);
+		out[2] = static_cast<std::uint8_t>(value >> 8);
+		out[3] = static_cast<std::uint8_t>(value);
+	}
+
+	static std::uint32_t read32(std::uint8_t const* data) noexcept
+	{
+		return static_cast<std::uint32_t>(data[0]) << 24 |
+				static_cast<std::uint32_t>(data[1]) << 16 |
+				static_cast<std::uint32_t>(data[2]) << 8 |
+				static_cast<std::uint32_t>(data[3]);
+	}
+};
+
+/**
+ * \brief Many requests in flight over one tcp_client
+ *
+ * request() frames the requests back to back at a output buffer, and
+ * flush() writes them with as few send calls as possible. Requests are
+ * tracked by id at a fixed table of \p Capacity (power of 2) slots: the
+ * id selects the slot (id & (Capacity - 1)), so lookup is O(1) and
+ * responses complete in any order.
+ *
+ * Ids are chosen by the client (request()), or by the caller (token,
+ * message ID: request_id()); a id whose slot is in use fails with
+ * errc::transaction_ocupied, and a full table with errc::no_free_slots.
+ *
+ * The socket must be non-blocking (MSG_DONTWAIT). At the loop: call
+ * process() when readable, and flush() when writable if want_write().
+ */
+template<class Endpoint,
+		typename Framing = length_id_framing,
+		unsigned Capacity = 64,
+		int Flags = MSG_DONTWAIT>
+class pipelined_client{
+	public:
+		static_assert(Capacity && (Capacity & (Capacity - 1)) == 0,
+				"Capacity must be power of 2");
+		static_assert((Flags & MSG_DONTWAIT) != 0, "socket must be non-blocking");
+
+		using endpoint = Endpoint;
+		using client = tcp_client<Endpoint, Flags>;
+		using handler = typename client::handler;
+		/**
+		 * \brief Called with the response payload, or with the error
+		 * (connection closed) and no data
+		 */
+		using callback = void(*)(std::uint32_t id, const void* data, std::size_t size,
+								Error const&, void* user);
+
+		pipelined_client();
+
+		void open(endpoint&, Error&) noexcept;
+		bool is_open() const noexcept;
+		/**
+		 * \brief Closes the connection. The requests in flight complete
+		 * with errc::socket_error.
+		 */
+		void close() noexcept;
+
+		handler native() const noexcept;
+		client& connection() noexcept{ return conn_; }
+
+		/**
+		 * \brief Id never given by request(): returned at error (0 is
+		 * a valid id)
+		 */
+		static constexpr const std::uint32_t invalid_id = ~std::uint32_t(0);
+
+		/**
+		 * \brief Queues a request with a free id. Returns the id, or
+		 * invalid_id (\p ec set).
+		 */
+		std::uint32_t request(const void* payload, std::size_t len,
+				callback, void* user, Error&) noexcept;
+		/**
+		 * \brief Queues a request with id \p id. Out of memory: \p ec
+		 * errc::out_of_resources.
+		 */
+		void request_id(std::uint32_t id, const void* payload, std::size_t len,
+				callback, void* user, Error&) noexcept;
+		/**
+		 * \brief Forgets a request (the callback is not called; the
+		 * response, if any, is dropped)
+		 */
+		bool cancel(std::uint32_t id) noexcept;
+
+		/**
+		 * \brief Writes the queued requests. Returns true if all written.
+		 */
+		bool flush(Error&) noexcept;
+		bool want_write() const noexcept{ return out_sent_ < out_.size(); }
+
+		/**
+		 * \brief Reads and completes the responses received. Returns
+		 * the number completed. If the input buffer can't grow, \p ec
+		 * is errc::out_of_resources and the connection is kept (call again).
+		 */
+		std::size_t process(Error&) noexcept;
+
+		/**
+		 * \brief Requests waiting response
+		 */
+		std::size_t in_flight() const noexcept{ return in_flight_; }
+		static constexpr std::size_t capacity() noexcept{ return Capacity; }
+	private:
+		static constexpr const std::uint32_t mask = Capacity - 1;
+
+		struct slot{
+			std::uint32_t	id;
+			callback		cb = nullptr;
+			void*			user;
+		};
+
+		void fail_all(Error const&) noexcept;
+		bool grow(std::size_t size) noexcept;
+
+		client						conn_;
+		slot						slots_[Capacity];
+		std::size_t					in_flight_ = 0;
+		std::uint32_t				next_id_ = 0;
+
+		std::vector<std::uint8_t>	out_;
+		std::size_t					out_sent_ = 0;
+		std::vector<std::uint8_t>	in_;
+		std::size_t					in_size_ = 0;
+};
+
+}//POSIX
+}//Soca
+
+#include "impl/pipelined_client_impl.hpp"
+
+#endif /* SOCA_POSIX_PIPELINED_CLIENT_HPP__ */
@@ -11,11 +11,41 @@
 #error "System not supported"
 #endif
 
+#include <type_traits>
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Socket type of the connection oriented sockets (tcp_server,
+ * tcp_client): Endpoint::stream_type if defined, SOCK_STREAM otherwise.
+ */
+template<class Endpoint, typename = void>
+struct stream_type{
+	static constexpr const int value = SOCK_STREAM;
+};
+
+template<class Endpoint>
+struct stream_type<Endpoint, std::void_t<decltype(Endpoint::stream_type)>>{
+	static constexpr const int value = Endpoint::stream_type;
+};
+
+}//POSIX
+}//Soca
+
 #include "endpoint_ipv4.hpp"
 #include "endpoint_ipv6.hpp"
 #include "endpoint_ip.hpp"
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+#include "endpoint_unix.hpp"
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
 #include "udp_socket.hpp"
 #include "tcp_client.hpp"
 #include "tcp_server.hpp"
+#include "splice_relay.hpp"
+#include "tcp_info_sampler.hpp"
+#include "dispatcher.hpp"
+#include "notifier.hpp"
+#include "shm_channel.hpp"
 
 #endif /* SOCA_POSIX_HPP__ */
@@ -0,0 +1,669 @@
+#include "resolver.hpp"
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include "address.hpp"
+#include "../metrics.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+static constexpr const std::uint16_t type_a = 1;
+static constexpr const std::uint16_t type_soa = 6;
+static constexpr const std::uint16_t type_aaaa = 28;
+static constexpr const std::uint16_t class_in = 1;
+
+static constexpr const std::size_t header_size = 12;
+static constexpr const std::size_t max_name = 253;
+static constexpr const std::size_t max_message = 512;		//UDP, no EDNS
+
+static std::uint16_t read16(std::uint8_t const* data) noexcept
+{
+	return static_cast<std::uint16_t>(data[0] << 8 | data[1]);
+}
+
+static std::uint32_t read32(std::uint8_t const* data) noexcept
+{
+	return static_cast<std::uint32_t>(data[0]) << 24 |
+			static_cast<std::uint32_t>(data[1]) << 16 |
+			static_cast<std::uint32_t>(data[2]) << 8 |
+			static_cast<std::uint32_t>(data[3]);
+}
+
+static void write16(std::uint8_t* data, std::uint16_t value) noexcept
+{
+	data[0] = static_cast<std::uint8_t>(value >> 8);
+	data[1] = static_cast<std::uint8_t>(value);
+}
+
+/**
+ * Index of the family at request::records: AAAA first
+ */
+static std::size_t family_index(std::uint16_t type) noexcept
+{
+	return type == type_aaaa ? 0 : 1;
+}
+
+static std::string make_key(std::string const& name, std::uint16_t type)
+{
+	std::string key = name;
+	key.push_back('\0');
+	key.push_back(type == type_a ? '4' : '6');
+	return key;
+}
+
+/**
+ * Lowercase, without the trailing dot. Empty if invalid.
+ */
+static std::string normalize(const char* name)
+{
+	std::string norm;
+	std::size_t len = std::strlen(name);
+	if(len && name[len - 1] == '.') len--;
+	if(len == 0 || len > max_name) return norm;
+
+	std::size_t label = 0;
+	for(std::size_t i = 0; i < len; i++)
+	{
+		char c = name[i];
+		if(c == '.')
+		{
+			if(label == 0) return std::string{};
+			label = 0;
+		}
+		else
+		{
+			if(++label > 63 || c <= ' ' || c > '~') return std::string{};
+			if(c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+		}
+		norm.push_back(c);
+	}
+	return norm;
+}
+
+/**
+ * Skips a (maybe compressed) name at \p offset. Returns the offset
+ * after it, or 0 if malformed.
+ */
+static std::size_t skip_name(std::uint8_t const* msg, std::size_t len, std::size_t offset) noexcept
+{
+	while(offset < len)
+	{
+		std::uint8_t label = msg[offset];
+		if(label == 0) return offset + 1;
+		if((label & 0xc0) == 0xc0) return offset + 2 <= len ? offset + 2 : 0;
+		if(label & 0xc0) return 0;
+		offset += 1 + label;
+	}
+	return 0;
+}
+
+/**
+ * Compares the (not compressed) question name at \p offset to \p name.
+ * Returns the offset after the name, or 0 if different.
+ */
+static std::size_t match_name(std::uint8_t const* msg, std::size_t len,
+		std::size_t offset, std::string const& name) noexcept
+{
+	std::size_t n = 0;
+	while(offset < len)
+	{
+		std::uint8_t label = msg[offset++];
+		if(label == 0) return n == name.size() ? offset : 0;
+		if(label & 0xc0 || offset + label > len) return 0;
+		if(n)
+		{
+			if(n >= name.size() || name[n] != '.') return 0;
+			n++;
+		}
+		for(std::size_t i = 0; i < label; i++, n++)
+		{
+			char c = static_cast<char>(msg[offset + i]);
+			if(c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+			if(n >= name.size() || name[n] != c) return 0;
+		}
+		offset += label;
+	}
+	return 0;
+}
+
+resolver::resolver()
+	: rng_(std::random_device{}()){}
+
+resolver::~resolver()
+{
+	close();
+}
+
+void resolver::open(endpoint_ip const& server, Error& ec) noexcept
+{
+	if(open_) close();
+	server_ = server;
+	socket_.open(server_.family(), ec);
+	if(ec) return;
+	open_ = true;
+}
+
+void resolver::open(Error& ec) noexcept
+{
+	endpoint_ip server{"127.0.0.1", 53, ec};
+
+	std::FILE* file = std::fopen("/etc/resolv.conf", "r");
+	if(file)
+	{
+		char line[256], addr[128];
+		while(std::fgets(line, sizeof(line), file))
+		{
+			if(std::sscanf(line, " nameserver %127s", addr) == 1
+				&& server.set(addr, 53))
+				break;
+		}
+		std::fclose(file);
+	}
+
+	open(server, ec);
+}
+
+bool resolver::load_hosts(const char* path /* = "/etc/hosts" */) noexcept
+{
+	std::FILE* file = std::fopen(path, "r");
+	if(!file) return false;
+
+	hosts_.clear();
+	char line[512];
+	bool ok = true;
+	while(ok && std::fgets(line, sizeof(line), file))
+	{
+		char* comment = std::strchr(line, '#');
+		if(comment) *comment = '\0';
+
+		const char* delim = " \t\r\n";
+		char* save = nullptr;
+		char* token = strtok_r(line, delim, &save);
+		if(!token) continue;
+
+		std::size_t len = std::strlen(token);
+		ipv4_address addr4 = parse_ipv4(token, len);
+		ipv6_address addr6 = parse_ipv6(token, len);
+		if(!addr4.valid && !addr6.valid) continue;
+
+		try{
+			while((token = strtok_r(nullptr, delim, &save)))
+			{
+				std::string name = normalize(token);
+				if(name.empty()) continue;
+
+				record& rec = hosts_[make_key(name, addr4.valid ? type_a : type_aaaa)];
+				if(rec.count == SOCA_RESOLVER_MAX_ADDRESSES) continue;
+				std::memcpy(rec.addresses[rec.count++],
+						addr4.valid ? addr4.bytes : addr6.bytes,
+						addr4.valid ? 4 : 16);
+			}
+		}catch(...){
+			ok = false;
+		}
+	}
+	std::fclose(file);
+	return ok;
+}
+
+bool resolver::is_open() const noexcept
+{
+	return open_;
+}
+
+void resolver::close() noexcept
+{
+	if(!open_) return;
+	socket_.close();
+	open_ = false;
+
+	/* nobody will answer: fails the pending requests */
+	for(query& q : queries_)
+		if(q.type) complete(q, nullptr, errc::name_timeout);
+	run_callbacks();
+}
+
+resolver::handler resolver::native() const noexcept
+{
+	return socket_.native();
+}
+
+endpoint_ip const& resolver::server() const noexcept
+{
+	return server_;
+}
+
+std::size_t resolver::pending() const noexcept
+{
+	return pending_;
+}
+
+std::size_t resolver::cache_size() const noexcept
+{
+	return cache_.size();
+}
+
+void resolver::clear_cache() noexcept
+{
+	cache_.clear();
+}
+
+bool resolver::resolve(const char* name, std::uint16_t port, sa_family_t family,
+		callback cb, void* user, Error& ec) noexcept
+{
+	resolve_result result;
+
+	/* numeric */
+	endpoint_ip numeric;
+	if(numeric.set(name, port))
+	{
+		if(family == AF_UNSPEC || family == numeric.family())
+			result.addresses[result.count++] = numeric;
+		Error error;
+		if(!result.count) error = errc::name_not_found;
+		cb(name, result, error, user);
+		return true;
+	}
+
+	std::uint16_t types[2];
+	std::size_t ntypes = 0;
+	if(family != AF_INET) types[ntypes++] = type_aaaa;
+	if(family != AF_INET6) types[ntypes++] = type_a;
+
+	std::string norm;
+	record const* cached[2] = {};
+	std::uint16_t missing[2];
+	std::size_t nmissing = 0;
+	/* names and keys are allocated */
+	try{
+		norm = normalize(name);
+		if(norm.empty())
+		{
+			ec = errc::endpoint_error;
+			return false;
+		}
+
+		/* hosts: if the name is there, it is the only answer */
+		bool at_hosts = false;
+		for(std::uint16_t type : {type_aaaa, type_a})
+		{
+			auto it = hosts_.find(make_key(norm, type));
+			if(it == hosts_.end()) continue;
+			at_hosts = true;
+			for(std::size_t i = 0; i < ntypes; i++)
+				if(types[i] == type) append(result, it->second, type, port);
+		}
+
+		/* cache */
+		if(!at_hosts)
+		{
+			auto now = clock::now();
+			for(std::size_t i = 0; i < ntypes; i++)
+			{
+				auto it = cache_.find(make_key(norm, types[i]));
+				if(it != cache_.end() && it->second.expires <= now)
+				{
+					cache_.erase(it);
+					it = cache_.end();
+				}
+				if(it == cache_.end())
+				{
+					missing[nmissing++] = types[i];
+					continue;
+				}
+				SOCA_METRIC_ADD(dns_cache_hits, 1);
+				append(result, it->second, types[i], port);
+				cached[family_index(types[i])] = &it->second;
+			}
+		}
+	}catch(...){
+		ec = errc::out_of_resources;
+		return false;
+	}
+
+	if(nmissing == 0)
+	{
+		Error error;
+		if(!result.count) error = errc::name_not_found;
+		cb(name, result, error, user);
+		return true;
+	}
+
+	/* query the missing ones (sharing the queries in flight) */
+	query* queries[2] = {};
+	std::size_t free_slots = SOCA_RESOLVER_MAX_PENDING - pending_;
+	for(std::size_t i = 0; i < nmissing; i++)
+	{
+		queries[i] = find_query(norm, missing[i]);
+		if(!queries[i] && free_slots-- == 0)
+		{
+			ec = errc::no_free_slots;
+			return false;
+		}
+	}
+
+	request* req = new (std::nothrow) request;
+	if(!req)
+	{
+		ec = errc::out_of_resources;
+		return false;
+	}
+	req->cb = cb;
+	req->user = user;
+	req->port = port;
+	req->remaining = static_cast<unsigned>(nmissing);
+	for(std::size_t i = 0; i < 2; i++)
+		if(cached[i]) req->records[i] = *cached[i];
+
+	/* allocated before queuing: nothing to undo but the request */
+	bool ok = true;
+	try{
+		req->name = name;
+		for(std::size_t i = 0; ok && i < nmissing; i++)
+		{
+			if(!queries[i]) queries[i] = new_query(norm, missing[i]);
+			if(queries[i]) queries[i]->waiting.reserve(queries[i]->waiting.size() + 1);
+			else ok = false;
+		}
+	}catch(...){
+		ok = false;
+	}
+	if(!ok)
+	{
+		delete req;
+		ec = errc::out_of_resources;
+		return false;
+	}
+
+	for(std::size_t i = 0; i < nmissing; i++)
+		queries[i]->waiting.push_back(req);
+	return false;
+}
+
+void resolver::append(resolve_result& result, record const& rec,
+		std::uint16_t type, std::uint16_t port) noexcept
+{
+	for(std::size_t i = 0; i < rec.count; i++)
+	{
+		if(type == type_a)
+		{
+			in_addr_t addr;
+			std::memcpy(&addr, rec.addresses[i], sizeof(addr));
+			result.addresses[result.count++].set(addr, port);
+		}
+		else
+		{
+			in6_addr addr;
+			std::memcpy(&addr, rec.addresses[i], sizeof(addr));
+			result.addresses[result.count++].set(addr, port);
+		}
+	}
+}
+
+resolver::query* resolver::find_query(std::string const& name, std::uint16_t type) noexcept
+{
+	for(query& q : queries_)
+		if(q.type == type && q.name == name) return &q;
+	return nullptr;
+}
+
+resolver::query* resolver::new_query(std::string const& name, std::uint16_t type) noexcept
+{
+	query* q = nullptr;
+	for(query& slot : queries_)
+	{
+		if(!slot.type)
+		{
+			q = &slot;
+			break;
+		}
+	}
+
+	/* random id, not in use */
+	std::uint16_t id;
+	do id = static_cast<std::uint16_t>(rng_());
+	while([&]{
+		for(query const& other : queries_)
+			if(other.type && other.id == id) return true;
+		return false;
+	}());
+
+	/* out of memory: not used (nullptr) */
+	try{
+		q->name = name;
+	}catch(...){
+		return nullptr;
+	}
+	q->type = type;
+	q->id = id;
+	q->attempts = 0;
+	pending_++;
+
+	/* if not sent, check() retransmits */
+	send_query(*q);
+	return q;
+}
+
+void resolver::send_query(query& q) noexcept
+{
+	q.attempts++;
+	q.deadline = clock::now() + std::chrono::milliseconds(SOCA_RESOLVER_TIMEOUT_MS);
+
+	std::uint8_t msg[header_size + max_name + 2 + 4] = {};
+	write16(msg, q.id);
+	write16(msg + 2, 0x0100);			//recursion desired
+	write16(msg + 4, 1);				//questions
+
+	std::size_t n = header_size, label = n++;
+	for(char c : q.name)
+	{
+		if(c == '.')
+		{
+			msg[label] = static_cast<std::uint8_t>(n - label - 1);
+			label = n++;
+			continue;
+		}
+		msg[n++] = static_cast<std::uint8_t>(c);
+	}
+	msg[label] = static_cast<std::uint8_t>(n - label - 1);
+	msg[n++] = 0;
+	write16(msg + n, q.type);
+	write16(msg + n + 2, class_in);
+	n += 4;
+
+	SOCA_METRIC_ADD(dns_queries, 1);
+	Error ec;
+	socket_.send(msg, n, server_, ec);
+}
+
+void resolver::process(Error& ec) noexcept
+{
+	std::uint8_t msg[max_message];
+	endpoint_ip from;
+	while(true)
+	{
+		std::size_t size = socket_.receive(msg, sizeof(msg), from, ec);
+		if(ec || size == 0) break;
+		/* only the server answers */
+		if(from != server_) continue;
+		answer(msg, size);
+	}
+	run_callbacks();
+}
+
+void resolver::answer(std::uint8_t const* msg, std::size_t len) noexcept
+{
+	if(len < header_size) return;
+
+	std::uint16_t id = read16(msg), flags = read16(msg + 2);
+	if(!(flags & 0x8000) || read16(msg + 4) != 1) return;
+
+	query* q = nullptr;
+	for(query& slot : queries_)
+	{
+		if(slot.type && slot.id == id)
+		{
+			q = &slot;
+			break;
+		}
+	}
+	if(!q) return;
+
+	/* question must be the one asked */
+	std::size_t offset = match_name(msg, len, header_size, q->name);
+	if(!offset || offset + 4 > len
+		|| read16(msg + offset) != q->type
+		|| read16(msg + offset + 2) != class_in)
+		return;
+	offset += 4;
+
+	unsigned rcode = flags & 0x0f;
+	if(rcode != 0 && rcode != 3)
+	{
+		/* server failure, refused...: not cached */
+		complete(*q, nullptr, errc::name_server_error);
+		return;
+	}
+
+	record rec;
+	std::uint32_t ttl = SOCA_RESOLVER_MAX_TTL;
+	bool negative_ttl = false;
+	std::size_t address_size = q->type == type_a ? 4 : 16;
+	unsigned records = static_cast<unsigned>(read16(msg + 6)) + read16(msg + 8);
+	for(unsigned i = 0; i < records; i++)
+	{
+		offset = skip_name(msg, len, offset);
+		if(!offset || offset + 10 > len) return;
+		std::uint16_t type = read16(msg + offset),
+				rclass = read16(msg + offset + 2);
+		std::uint32_t rttl = read32(msg + offset + 4);
+		std::size_t rdlen = read16(msg + offset + 8);
+		offset += 10;
+		if(offset + rdlen > len) return;
+
+		if(rclass == class_in && type == q->type && rdlen == address_size && rcode == 0)
+		{
+			if(rec.count < SOCA_RESOLVER_MAX_ADDRESSES)
+				std::memcpy(rec.addresses[rec.count++], msg + offset, address_size);
+			if(rttl < ttl) ttl = rttl;
+		}
+		else if(type == type_soa && !negative_ttl)
+		{
+			/* negative answers TTL: min(SOA TTL, SOA minimum) (RFC 2308) */
+			std::size_t soa = skip_name(msg, len, offset);
+			if(soa) soa = skip_name(msg, len, soa);
+			if(soa && soa + 20 <= offset + rdlen)
+			{
+				std::uint32_t minimum = read32(msg + soa + 16);
+				negative_ttl = true;
+				ttl = rttl < minimum ? rttl : minimum;
+			}
+		}
+		offset += rdlen;
+	}
+
+	if(!rec.count && !negative_ttl) ttl = SOCA_RESOLVER_NEGATIVE_TTL;
+	if(ttl > SOCA_RESOLVER_MAX_TTL) ttl = SOCA_RESOLVER_MAX_TTL;
+	rec.expires = clock::now() + std::chrono::seconds(ttl);
+	cache(q->name, q->type, rec);
+
+	complete(*q, &rec, errc::name_not_found);
+}
+
+void resolver::cache(std::string const& name, std::uint16_t type, record const& rec) noexcept
+{
+	/* out of memory: just not cached */
+	try{
+		std::string key = make_key(name, type);
+		if(cache_.size() >= SOCA_RESOLVER_CACHE_SIZE && cache_.find(key) == cache_.end())
+		{
+			auto now = clock::now();
+			for(auto it = cache_.begin(); it != cache_.end();)
+			{
+				if(it->second.expires <= now) it = cache_.erase(it);
+				else ++it;
+			}
+			if(cache_.size() >= SOCA_RESOLVER_CACHE_SIZE)
+				cache_.erase(cache_.begin());
+		}
+		cache_[key] = rec;
+	}catch(...){}
+}
+
+void resolver::complete(query& q, record const* rec, errc error) noexcept
+{
+	for(request* req : q.waiting)
+	{
+		if(rec) req->records[family_index(q.type)] = *rec;
+		/* a server error or timeout prevails over not found */
+		if(!rec || !req->error) req->error = error;
+		if(--req->remaining == 0)
+		{
+			req->next = nullptr;
+			if(done_last_) done_last_->next = req;
+			else done_ = req;
+			done_last_ = req;
+		}
+	}
+
+	q.waiting.clear();
+	q.type = 0;
+	pending_--;
+}
+
+void resolver::run_callbacks() noexcept
+{
+	/* callbacks may resolve() again */
+	request* req = done_;
+	done_ = done_last_ = nullptr;
+	while(req)
+	{
+		request* next = req->next;
+		/* IPv6 first, whatever answered first (connect_any) */
+		resolve_result result;
+		append(result, req->records[0], type_aaaa, req->port);
+		append(result, req->records[1], type_a, req->port);
+		if(result.count) req->error.clear();
+		req->cb(req->name.c_str(), result, req->error, req->user);
+		delete req;
+		req = next;
+	}
+}
+
+void resolver::check() noexcept
+{
+	auto now = clock::now();
+	for(query& q : queries_)
+	{
+		if(!q.type || q.deadline > now) continue;
+		if(q.attempts < SOCA_RESOLVER_ATTEMPTS)
+		{
+			send_query(q);
+			continue;
+		}
+		SOCA_METRIC_ADD(dns_timeouts, 1);
+		complete(q, nullptr, errc::name_timeout);
+	}
+	run_callbacks();
+}
+
+int resolver::next_timeout() const noexcept
+{
+	if(!pending_) return -1;
+
+	auto now = clock::now();
+	auto next = clock::time_point::max();
+	for(query const& q : queries_)
+		if(q.type && q.deadline < next) next = q.deadline;
+	if(next <= now) return 0;
+	return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(next - now).count());
+}
+
+}//POSIX
+}//Soca
+
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
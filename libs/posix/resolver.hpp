@@ -0,0 +1,224 @@
+#ifndef SOCA_POSIX_RESOLVER_HPP__
+#define SOCA_POSIX_RESOLVER_HPP__
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <random>
+
+#include "../error.hpp"
+#include "endpoint_ip.hpp"
+#include "udp_socket.hpp"
+
+/**
+ * Maximum addresses kept of each name and family
+ */
+#ifndef SOCA_RESOLVER_MAX_ADDRESSES
+#define SOCA_RESOLVER_MAX_ADDRESSES		8
+#endif /* SOCA_RESOLVER_MAX_ADDRESSES */
+
+/**
+ * Maximum queries in flight
+ */
+#ifndef SOCA_RESOLVER_MAX_PENDING
+#define SOCA_RESOLVER_MAX_PENDING		64
+#endif /* SOCA_RESOLVER_MAX_PENDING */
+
+/**
+ * Maximum names cached (each family counts as one)
+ */
+#ifndef SOCA_RESOLVER_CACHE_SIZE
+#define SOCA_RESOLVER_CACHE_SIZE		1024
+#endif /* SOCA_RESOLVER_CACHE_SIZE */
+
+/**
+ * Time to retransmit a query, and number of transmissions
+ */
+#ifndef SOCA_RESOLVER_TIMEOUT_MS
+#define SOCA_RESOLVER_TIMEOUT_MS		1000
+#endif /* SOCA_RESOLVER_TIMEOUT_MS */
+
+#ifndef SOCA_RESOLVER_ATTEMPTS
+#define SOCA_RESOLVER_ATTEMPTS			3
+#endif /* SOCA_RESOLVER_ATTEMPTS */
+
+/**
+ * TTL (seconds) of the negative answers without SOA, and maximum TTL
+ * of any answer
+ */
+#ifndef SOCA_RESOLVER_NEGATIVE_TTL
+#define SOCA_RESOLVER_NEGATIVE_TTL		30
+#endif /* SOCA_RESOLVER_NEGATIVE_TTL */
+
+#ifndef SOCA_RESOLVER_MAX_TTL
+#define SOCA_RESOLVER_MAX_TTL			86400
+#endif /* SOCA_RESOLVER_MAX_TTL */
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Addresses of a name, with the port asked
+ *
+ * IPv6 addresses first, then IPv4 (as the server answered), as expected
+ * by tcp_client<endpoint_ip>::connect_any.
+ */
+struct resolve_result{
+	endpoint_ip		addresses[SOCA_RESOLVER_MAX_ADDRESSES * 2];
+	std::size_t		count = 0;
+};
+
+/**
+ * \brief Non-blocking DNS resolver (A/AAAA) with cache
+ *
+ * Names are looked up at: numeric addresses, hosts file (load_hosts),
+ * cache, and then queried to the DNS server by UDP. Answers are cached
+ * by its TTL; negative answers (name or address family not found) by the
+ * SOA minimum TTL. Concurrent requests of the same name share the query.
+ *
+ * Add native() to the loop (e.g. tcp_server::watch(native(), ec, false))
+ * and call process() when readable; call check() periodically (at most
+ * next_timeout() ms apart) to retransmit and time out queries. Not thread
+ * safe: use at the loop thread.
+ *
+ * The callback is called once per resolve(), with the addresses or the
+ * error (errc::name_not_found, errc::name_timeout, errc::name_server_error).
+ * Truncated answers are used as received (no TCP fallback).
+ */
+class resolver{
+	public:
+		using handler = int;
+		using callback = void(*)(const char* name, resolve_result const&, Error const&, void* user);
+
+		resolver();
+		~resolver();
+
+		resolver(resolver const&) = delete;
+		resolver& operator=(resolver const&) = delete;
+
+		/**
+		 * \brief Opens using \p server (e.g. 127.0.0.53:53)
+		 */
+		void open(endpoint_ip const& server, Error&) noexcept;
+		/**
+		 * \brief Opens using the first nameserver of /etc/resolv.conf
+		 * (127.0.0.1 if none)
+		 */
+		void open(Error&) noexcept;
+		/**
+		 * \brief Loads the names of a hosts file, never expired (replaces
+		 * the loaded before). Returns false if the file can't be read (or
+		 * out of memory: the names loaded are kept).
+		 */
+		bool load_hosts(const char* path = "/etc/hosts") noexcept;
+
+		bool is_open() const noexcept;
+		/**
+		 * \brief Closes the socket. Requests waiting the server fail
+		 * (errc::name_timeout).
+		 */
+		void close() noexcept;
+
+		handler native() const noexcept;
+		endpoint_ip const& server() const noexcept;
+
+		/**
+		 * \brief Resolves \p name to AF_INET, AF_INET6 or both (AF_UNSPEC)
+		 *
+		 * Returns true if completed at the call (\p cb already called);
+		 * false if waiting the server. \p ec is set (and \p cb not called)
+		 * if the request could not be made: invalid name (errc::endpoint_error),
+		 * too many queries in flight (errc::no_free_slots) or out of memory
+		 * (errc::out_of_resources).
+		 */
+		bool resolve(const char* name, std::uint16_t port, sa_family_t family,
+				callback cb, void* user, Error& ec) noexcept;
+
+		/**
+		 * \brief Reads the answers received, calling the callbacks of the
+		 * completed requests
+		 */
+		void process(Error&) noexcept;
+		/**
+		 * \brief Retransmits/times out the queries (calling its callbacks)
+		 */
+		void check() noexcept;
+		/**
+		 * \brief Milliseconds to the next check() needed; -1 if no query
+		 * in flight
+		 */
+		int next_timeout() const noexcept;
+
+		std::size_t pending() const noexcept;
+		std::size_t cache_size() const noexcept;
+		void clear_cache() noexcept;
+	private:
+		using clock = std::chrono::steady_clock;
+
+		/**
+		 * Addresses of a name of one family
+		 */
+		struct record{
+			std::uint8_t	addresses[SOCA_RESOLVER_MAX_ADDRESSES][16];
+			std::size_t		count = 0;
+			clock::time_point	expires;
+		};
+
+		struct request{
+			callback		cb;
+			void*			user;
+			std::uint16_t	port;
+			unsigned		remaining;		//queries to complete
+			Error			error;
+			/* by family (AAAA, A): the result is built at the end */
+			record			records[2];
+			std::string		name;
+			request*		next = nullptr;		//done list
+		};
+
+		struct query{
+			std::string		name;
+			std::uint16_t	type = 0;		//0: free
+			std::uint16_t	id = 0;
+			unsigned		attempts = 0;
+			clock::time_point	deadline;
+			std::vector<request*>	waiting;
+		};
+
+		query* find_query(std::string const&, std::uint16_t type) noexcept;
+		query* new_query(std::string const&, std::uint16_t type) noexcept;
+		void send_query(query&) noexcept;
+		void answer(std::uint8_t const*, std::size_t) noexcept;
+		void cache(std::string const& name, std::uint16_t type, record const&) noexcept;
+		void complete(query&, record const*, errc error) noexcept;
+		void run_callbacks() noexcept;
+		static void append(resolve_result&, record const&,
+				std::uint16_t type, std::uint16_t port) noexcept;
+
+		udp<endpoint_ip>	socket_;
+		bool				open_ = false;
+		endpoint_ip			server_;
+		std::mt19937		rng_;
+
+		query				queries_[SOCA_RESOLVER_MAX_PENDING];
+		std::size_t			pending_ = 0;
+		/* completed, callbacks to call (FIFO, not allocating) */
+		request*			done_ = nullptr;
+		request*			done_last_ = nullptr;
+
+		/* key: name + '\0' + type */
+		std::unordered_map<std::string, record>	cache_;
+		std::unordered_map<std::string, record>	hosts_;
+};
+
+}//POSIX
+}//Soca
+
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+
+#endif /* SOCA_POSIX_RESOLVER_HPP__ */
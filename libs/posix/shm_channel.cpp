@@ -0,0 +1,316 @@
+#include "shm_channel.hpp"
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "../cache_line.hpp"
+#include "../metrics.hpp"
+#include "../probe.hpp"
+#include "functions.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+		"shared memory atomics must be lock free");
+
+static constexpr const std::uint32_t shm_magic = 0x534F4348;	//"SOCH"
+static constexpr const std::uint32_t shm_version = 1;
+
+/**
+ * \p head: bytes written (producer); \p tail: bytes read (consumer).
+ * Free running, masked with capacity - 1.
+ */
+struct shm_channel::ring{
+	alignas(SOCA_CACHE_LINE_SIZE) std::atomic<std::uint64_t>	head;
+	alignas(SOCA_CACHE_LINE_SIZE) std::atomic<std::uint64_t>	tail;
+};
+
+/**
+ * Shared memory: header, rings, then the data of ring 0 and ring 1
+ */
+struct shm_channel::layout{
+	std::uint32_t	magic;
+	std::uint32_t	version;
+	std::uint64_t	capacity;
+	ring			rings[2];
+};
+
+static std::size_t round_pow2(std::size_t value) noexcept
+{
+	std::size_t n = SOCA_CACHE_LINE_SIZE;
+	while(n < value) n <<= 1;
+	return n;
+}
+
+shm_channel::shm_channel()
+	: memfd_(-1), shm_(nullptr), shm_size_(0),
+	  tx_(nullptr), rx_(nullptr),
+	  tx_data_(nullptr), rx_data_(nullptr),
+	  capacity_(0), side_(0){}
+
+shm_channel::~shm_channel()
+{
+	close();
+}
+
+void shm_channel::create(std::size_t capacity, Error& ec) noexcept
+{
+	capacity = round_pow2(capacity);
+
+	memfd_ = ::memfd_create("soca_shm_channel", MFD_CLOEXEC);
+	if(memfd_ == -1)
+	{
+		ec = errc::socket_error;
+		return;
+	}
+	if(::ftruncate(memfd_, sizeof(layout) + 2 * capacity) == -1)
+	{
+		ec = errc::out_of_resources;
+		close();
+		return;
+	}
+
+	doorbell_[0].open(ec);
+	if(!ec) doorbell_[1].open(ec);
+	if(ec)
+	{
+		close();
+		return;
+	}
+
+	map(memfd_, true, ec);
+}
+
+void shm_channel::share(int unix_socket, Error& ec) noexcept
+{
+	static const char tag[3] = {'m', '0', '1'};
+	if(!send_fd(unix_socket, memfd_, &tag[0], 1)
+		|| !send_fd(unix_socket, doorbell_[0].native(), &tag[1], 1)
+		|| !send_fd(unix_socket, doorbell_[1].native(), &tag[2], 1))
+		ec = errc::socket_send;
+}
+
+void shm_channel::attach(int unix_socket, Error& ec) noexcept
+{
+	int fds[3];
+	for(int i = 0; i < 3; i++)
+	{
+		fds[i] = receive_fd(unix_socket);
+		if(fds[i] == -1)
+		{
+			for(int j = 0; j < i; j++) ::close(fds[j]);
+			ec = errc::socket_receive;
+			return;
+		}
+	}
+	attach(fds[0], fds[1], fds[2], ec);
+}
+
+void shm_channel::attach(int memfd, int doorbell_0, int doorbell_1, Error& ec) noexcept
+{
+	memfd_ = memfd;
+	doorbell_[0].assign(doorbell_0);
+	doorbell_[1].assign(doorbell_1);
+
+	map(memfd_, false, ec);
+}
+
+void shm_channel::map(int memfd, bool creator, Error& ec) noexcept
+{
+	struct stat st;
+	if(::fstat(memfd, &st) == -1
+		|| static_cast<std::size_t>(st.st_size) < sizeof(layout))
+	{
+		ec = errc::invalid_data;
+		close();
+		return;
+	}
+
+	shm_size_ = static_cast<std::size_t>(st.st_size);
+	void* addr = ::mmap(nullptr, shm_size_, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+	if(addr == MAP_FAILED)
+	{
+		shm_ = nullptr;
+		ec = errc::out_of_resources;
+		close();
+		return;
+	}
+	shm_ = static_cast<layout*>(addr);
+
+	if(creator)
+	{
+		/* memfd pages are zeroed: head/tail already 0 */
+		capacity_ = (shm_size_ - sizeof(layout)) / 2;
+		shm_->capacity = capacity_;
+		shm_->version = shm_version;
+		shm_->magic = shm_magic;
+	}
+	else
+	{
+		/* read once: the peer may change it */
+		capacity_ = shm_->capacity;
+		if(shm_->magic != shm_magic
+			|| shm_->version != shm_version
+			|| capacity_ == 0
+			|| (capacity_ & (capacity_ - 1)) != 0		//index masked with capacity - 1
+			|| capacity_ != (shm_size_ - sizeof(layout)) / 2
+			|| sizeof(layout) + 2 * capacity_ != shm_size_)
+		{
+			ec = errc::invalid_data;
+			close();
+			return;
+		}
+	}
+
+	/* creator sends at ring 0, receives at ring 1 */
+	side_ = creator ? 0 : 1;
+	std::uint8_t* data = reinterpret_cast<std::uint8_t*>(shm_ + 1);
+	tx_ = &shm_->rings[side_];
+	rx_ = &shm_->rings[side_ ^ 1];
+	tx_data_ = data + side_ * capacity_;
+	rx_data_ = data + (side_ ^ 1) * capacity_;
+}
+
+bool shm_channel::is_open() const noexcept
+{
+	return shm_ != nullptr;
+}
+
+void shm_channel::close() noexcept
+{
+	if(shm_) ::munmap(shm_, shm_size_);
+	shm_ = nullptr;
+	tx_ = rx_ = nullptr;
+	tx_data_ = rx_data_ = nullptr;
+	capacity_ = 0;
+	if(memfd_ != -1) ::close(memfd_);
+	memfd_ = -1;
+	doorbell_[0].close();
+	doorbell_[1].close();
+}
+
+shm_channel::handler shm_channel::native() const noexcept
+{
+	return doorbell_[side_ ^ 1].native();
+}
+
+std::size_t shm_channel::send(const void* buffer, std::size_t buffer_len, Error& ec) noexcept
+{
+	/* closed (e.g. invalid ring) */
+	if(!shm_)
+	{
+		ec = errc::socket_error;
+		return 0;
+	}
+	std::uint64_t const capacity = capacity_;
+	std::uint64_t head = tx_->head.load(std::memory_order_relaxed);
+	std::uint64_t tail = tx_->tail.load(std::memory_order_acquire);
+
+	/* tail written by the peer */
+	if(head - tail > capacity)
+	{
+		ec = errc::invalid_data;
+		SOCA_METRIC_ADD(errors, 1);
+		close();
+		return 0;
+	}
+
+	std::size_t size = capacity - (head - tail);
+	if(size > buffer_len) size = buffer_len;
+	if(size == 0)
+	{
+		SOCA_METRIC_ADD(would_block, 1);
+		SOCA_PROBE(shm_send, doorbell_[side_].native(), 0, EAGAIN);
+		return 0;
+	}
+
+	std::size_t offset = head & (capacity - 1),
+				first = size < capacity - offset ? size : capacity - offset;
+	std::memcpy(tx_data_ + offset, buffer, first);
+	std::memcpy(tx_data_, static_cast<const std::uint8_t*>(buffer) + first, size - first);
+	tx_->head.store(head + size, std::memory_order_release);
+
+	/**
+	 * Rings only if the consumer had read all (it may be sleeping).
+	 * Pairs with the fence at receive.
+	 */
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(tx_->tail.load(std::memory_order_relaxed) == head)
+		doorbell_[side_].notify();
+
+	SOCA_PROBE(shm_send, doorbell_[side_].native(), size, 0);
+	SOCA_METRIC_ADD(packets_sent, 1);
+	SOCA_METRIC_ADD(bytes_sent, size);
+	return size;
+}
+
+std::size_t shm_channel::receive(void* buffer, std::size_t buffer_len, Error& ec) noexcept
+{
+	/* closed (e.g. invalid ring) */
+	if(!shm_)
+	{
+		ec = errc::socket_error;
+		return 0;
+	}
+	std::uint64_t const capacity = capacity_;
+	std::uint64_t tail = rx_->tail.load(std::memory_order_relaxed);
+	std::uint64_t head = rx_->head.load(std::memory_order_acquire);
+
+	if(head == tail)
+	{
+		/* empty: clear the doorbell, and check again (data may arrived in between) */
+		doorbell_[side_ ^ 1].consume();
+		head = rx_->head.load(std::memory_order_acquire);
+		if(head == tail)
+		{
+			SOCA_METRIC_ADD(would_block, 1);
+			SOCA_PROBE(shm_receive, native(), 0, EAGAIN);
+			return 0;
+		}
+	}
+
+	/* head written by the peer */
+	if(head - tail > capacity)
+	{
+		ec = errc::invalid_data;
+		SOCA_METRIC_ADD(errors, 1);
+		close();
+		return 0;
+	}
+
+	std::size_t size = head - tail;
+	if(size > buffer_len) size = buffer_len;
+
+	std::size_t offset = tail & (capacity - 1),
+				first = size < capacity - offset ? size : capacity - offset;
+	std::memcpy(buffer, rx_data_ + offset, first);
+	std::memcpy(static_cast<std::uint8_t*>(buffer) + first, rx_data_, size - first);
+	rx_->tail.store(tail + size, std::memory_order_release);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	SOCA_PROBE(shm_receive, native(), size, 0);
+	SOCA_METRIC_ADD(packets_received, 1);
+	SOCA_METRIC_ADD(bytes_received, size);
+	return size;
+}
+
+std::size_t shm_channel::available() const noexcept
+{
+	if(!shm_) return 0;
+	std::uint64_t size = rx_->head.load(std::memory_order_acquire)
+			- rx_->tail.load(std::memory_order_relaxed);
+	/* invalid: receive fails */
+	return size > capacity_ ? 0 : size;
+}
+
+}//POSIX
+}//Soca
+
+#endif /* defined(__linux__) */
@@ -0,0 +1,105 @@
+#ifndef SOCA_POSIX_SHM_CHANNEL_HPP__
+#define SOCA_POSIX_SHM_CHANNEL_HPP__
+
+#if defined(__linux__)
+
+#include <cstdlib>
+#include <cstdint>
+#include "../error.hpp"
+#include "notifier.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Same-host transport over shared memory
+ *
+ * A memfd holds two single producer / single consumer byte rings, one
+ * for each direction; each ring has a eventfd doorbell, rung when data
+ * is written to a empty ring. Data is copied once at each side, with no
+ * syscall while the peer is busy reading.
+ *
+ * One side create()s the channel and share()s it through a Unix socket
+ * (endpoint_unix); the other side attach()es. After fork, the child can
+ * use attach() with the descriptors directly.
+ *
+ * send/receive behave as a non-blocking tcp_client (stream, 0 if
+ * the ring is full/empty). To use with the tcp_server loop, watch
+ * native() (watch(native(), ec, false)); read_cb is called when data
+ * arrives, and must receive until 0.
+ *
+ * The peer is not trusted: the capacity is read once, at create/attach,
+ * and a ring with head/tail out of the capacity fails send/receive with
+ * errc::invalid_data (the channel is closed).
+ *
+ * \note A closed peer is not detected. Use the Unix socket for that.
+ */
+class shm_channel{
+	public:
+		using handler = int;
+
+		shm_channel();
+		~shm_channel();
+
+		shm_channel(shm_channel const&) = delete;
+		shm_channel& operator=(shm_channel const&) = delete;
+
+		/**
+		 * \brief Creates the shared memory. \p capacity of each ring
+		 * (rounded up to power of 2).
+		 */
+		void create(std::size_t capacity, Error&) noexcept;
+		/**
+		 * \brief Sends the channel descriptors to the peer
+		 */
+		void share(int unix_socket, Error&) noexcept;
+
+		/**
+		 * \brief Attaches to a channel shared by the peer
+		 */
+		void attach(int unix_socket, Error&) noexcept;
+		/**
+		 * \brief Attaches to the channel (creator side descriptors).
+		 * Takes ownership of the descriptors.
+		 */
+		void attach(int memfd, int doorbell_0, int doorbell_1, Error&) noexcept;
+
+		bool is_open() const noexcept;
+		void close() noexcept;
+
+		/**
+		 * \brief Receive doorbell (readable when data arrives)
+		 */
+		handler native() const noexcept;
+
+		std::size_t send(const void*, std::size_t, Error&) noexcept;
+		std::size_t receive(void*, std::size_t, Error&) noexcept;
+
+		/**
+		 * \brief Bytes ready to be received
+		 */
+		std::size_t available() const noexcept;
+	private:
+		struct layout;
+		struct ring;
+
+		void map(int memfd, bool creator, Error&) noexcept;
+
+		int				memfd_;
+		layout*			shm_;
+		std::size_t		shm_size_;
+		ring*			tx_;
+		ring*			rx_;
+		std::uint8_t*	tx_data_;
+		std::uint8_t*	rx_data_;
+		std::uint64_t	capacity_;		//of each ring; not read from the shared header
+		notifier		doorbell_[2];
+		unsigned		side_;
+};
+
+}//POSIX
+}//Soca
+
+#endif /* defined(__linux__) */
+
+#endif /* SOCA_POSIX_SHM_CHANNEL_HPP__ */
@@ -0,0 +1,205 @@
+#ifndef SOCA_POSIX_SOCKET_OPTIONS_HPP__
+#define SOCA_POSIX_SOCKET_OPTIONS_HPP__
+
+#include <cstdlib>
+#include <type_traits>
+
+#include "../error.hpp"
+
+/* not port.hpp: it includes the sockets, that include this file */
+#if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
+#include "windows.hpp"
+#elif defined(__unix__)
+#include "unix.hpp"
+#elif SOCA_ESP_IDF_PLATAFORM == 1
+#include "esp_idf.hpp"
+#endif
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Socket options applied when the socket is opened (tcp_server,
+ * tcp_client, udp)
+ *
+ * Fields left \p unset keep the system default. Options the system doesn't
+ * have are ignored, as the TCP options at UDP and Unix sockets.
+ */
+struct socket_options{
+	static constexpr const int unset = -1;
+
+	/**
+	 * TCP_NODELAY: small segments are sent at once (Nagle disabled)
+	 */
+	int			nodelay = unset;
+	/**
+	 * TCP_QUICKACK (Linux): ACKs without delay. The kernel may leave this
+	 * mode; see quickack().
+	 */
+	int			quickack = unset;
+	/**
+	 * TCP_NOTSENT_LOWAT: bytes not sent kept at the socket before it is
+	 * writable again. Low values keep the data fresh at the application.
+	 */
+	int			notsent_lowat = unset;
+	/**
+	 * TCP_DEFER_ACCEPT (Linux, listening socket): seconds a connection may
+	 * wait its first data before accepted; connections without data don't
+	 * wake the loop.
+	 */
+	int			defer_accept = unset;
+	/**
+	 * SO_RCVBUF/SO_SNDBUF, bytes. At Linux, setting it disables the
+	 * buffer auto tuning.
+	 */
+	int			receive_buffer = unset;
+	int			send_buffer = unset;
+	/**
+	 * SO_BUSY_POLL (Linux): microseconds to busy poll the device queue at
+	 * a blocking receive. Above net.core.busy_read requires CAP_NET_ADMIN.
+	 */
+	int			busy_poll = unset;
+	/**
+	 * SO_PREFER_BUSY_POLL and SO_BUSY_POLL_BUDGET (Linux 5.11): busy poll
+	 * is preferred over the device interrupts, and packets processed by
+	 * poll (above 64 requires CAP_NET_ADMIN)
+	 */
+	int			prefer_busy_poll = unset;
+	int			busy_poll_budget = unset;
+	/**
+	 * SO_INCOMING_CPU (Linux): CPU that should handle the socket (e.g.
+	 * to pick the listener of a SO_REUSEPORT group)
+	 */
+	int			incoming_cpu = unset;
+	/**
+	 * SO_REUSEPORT: sockets bound to the same address and port (same user)
+	 * share its traffic. At Linux, a connected UDP socket of the group
+	 * receives the datagrams of its peer.
+	 */
+	int			reuse_port = unset;
+	/**
+	 * TCP_CONGESTION (Linux): congestion control name (e.g. "bbr", "cubic").
+	 * Must be at net.ipv4.tcp_allowed_congestion_control.
+	 */
+	const char*	congestion = nullptr;
+
+	constexpr bool empty() const noexcept
+	{
+		return nodelay == unset && quickack == unset && notsent_lowat == unset
+				&& defer_accept == unset
+				&& receive_buffer == unset && send_buffer == unset
+				&& busy_poll == unset && prefer_busy_poll == unset
+				&& busy_poll_budget == unset && incoming_cpu == unset
+				&& reuse_port == unset
+				&& congestion == nullptr;
+	}
+
+	/**
+	 * \brief This options, overridden by the fields set at \p other
+	 */
+	constexpr socket_options merge(socket_options const& other) const noexcept
+	{
+		socket_options opt = *this;
+		if(other.nodelay != unset) opt.nodelay = other.nodelay;
+		if(other.quickack != unset) opt.quickack = other.quickack;
+		if(other.notsent_lowat != unset) opt.notsent_lowat = other.notsent_lowat;
+		if(other.defer_accept != unset) opt.defer_accept = other.defer_accept;
+		if(other.receive_buffer != unset) opt.receive_buffer = other.receive_buffer;
+		if(other.send_buffer != unset) opt.send_buffer = other.send_buffer;
+		if(other.busy_poll != unset) opt.busy_poll = other.busy_poll;
+		if(other.prefer_busy_poll != unset) opt.prefer_busy_poll = other.prefer_busy_poll;
+		if(other.busy_poll_budget != unset) opt.busy_poll_budget = other.busy_poll_budget;
+		if(other.incoming_cpu != unset) opt.incoming_cpu = other.incoming_cpu;
+		if(other.reuse_port != unset) opt.reuse_port = other.reuse_port;
+		if(other.congestion) opt.congestion = other.congestion;
+		return opt;
+	}
+
+	/**
+	 * \brief Request/response: no Nagle, no delayed ACK and a small
+	 * unsent queue
+	 */
+	static constexpr socket_options latency() noexcept
+	{
+		socket_options opt;
+		opt.nodelay = 1;
+		opt.quickack = 1;
+		opt.notsent_lowat = 16 * 1024;
+		return opt;
+	}
+
+	/**
+	 * \brief Bulk transfer: Nagle coalesces the small writes, and the
+	 * unsent queue is bounded (the buffers are left to auto tuning)
+	 */
+	static constexpr socket_options throughput() noexcept
+	{
+		socket_options opt;
+		opt.nodelay = 0;
+		opt.notsent_lowat = 128 * 1024;
+		return opt;
+	}
+};
+
+/**
+ * Options policies: the \p Options template parameter of tcp_server,
+ * tcp_client and udp. Must define a constexpr options().
+ */
+struct default_options{
+	static constexpr socket_options options() noexcept{ return socket_options{}; }
+};
+
+struct latency_options{
+	static constexpr socket_options options() noexcept{ return socket_options::latency(); }
+};
+
+struct throughput_options{
+	static constexpr socket_options options() noexcept{ return socket_options::throughput(); }
+};
+
+/**
+ * \brief If the TCP options apply to the sockets of \p Endpoint (false
+ * to Unix sockets)
+ */
+template<class Endpoint, typename = void>
+struct tcp_level{
+	static constexpr const bool value = true;
+};
+
+template<class Endpoint>
+struct tcp_level<Endpoint, std::void_t<decltype(Endpoint::ep_family)>>{
+	static constexpr const bool value = Endpoint::ep_family != AF_UNIX;
+};
+
+/**
+ * \brief Sets the options at \p socket. \p tcp selects if the TCP options
+ * are set.
+ *
+ * All options are tried; if any fails, returns false and \p ec is set to
+ * errc::socket_option.
+ */
+template<typename Handler>
+bool apply_options(Handler socket, socket_options const&, bool tcp, Error& ec) noexcept;
+
+/**
+ * \brief Holds (\p on) the partial segments until uncorked, so the writes
+ * in between go out as full segments (TCP_CORK, TCP_NOPUSH at BSD).
+ *
+ * Returns false if not supported.
+ */
+template<typename Handler>
+bool cork(Handler socket, bool on) noexcept;
+
+/**
+ * \brief Sets TCP_QUICKACK again (e.g. after a receive), as the kernel
+ * may return to delayed ACKs. Returns false if not supported.
+ */
+template<typename Handler>
+bool quickack(Handler socket) noexcept;
+
+}//POSIX
+}//Soca
+
+#include "impl/socket_options_impl.hpp"
+
+#endif /* SOCA_POSIX_SOCKET_OPTIONS_HPP__ */
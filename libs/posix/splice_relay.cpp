@@ -0,0 +1,104 @@
+#include "splice_relay.hpp"
+
+#if defined(__linux__)
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * Maximum bytes moved by each splice call (default pipe capacity)
+ */
+static constexpr const std::size_t splice_chunk = 65536;
+
+splice_relay::splice_relay()
+	: pipe_{-1, -1}, pending_(0){}
+
+splice_relay::~splice_relay()
+{
+	if(is_open()) close();
+}
+
+void splice_relay::open(Error& ec) noexcept
+{
+	if(::pipe2(pipe_, O_NONBLOCK | O_CLOEXEC) == -1)
+	{
+		pipe_[0] = pipe_[1] = -1;
+		ec = errc::socket_error;
+		return;
+	}
+	pending_ = 0;
+}
+
+bool splice_relay::is_open() const noexcept
+{
+	return pipe_[0] != -1;
+}
+
+void splice_relay::close() noexcept
+{
+	if(pipe_[0] != -1) ::close(pipe_[0]);
+	if(pipe_[1] != -1) ::close(pipe_[1]);
+	pipe_[0] = pipe_[1] = -1;
+	pending_ = 0;
+}
+
+std::size_t splice_relay::pending() const noexcept
+{
+	return pending_;
+}
+
+std::size_t splice_relay::flush(handler to, Error& ec) noexcept
+{
+	std::size_t sent = 0;
+	while(pending_ > 0)
+	{
+		ssize_t n = ::splice(pipe_[0], nullptr, to, nullptr, pending_,
+							SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		if(n < 0)
+		{
+			if(errno != EAGAIN && errno != EWOULDBLOCK)
+				ec = errc::socket_send;
+			break;
+		}
+		pending_ -= n;
+		sent += n;
+	}
+	return sent;
+}
+
+std::size_t splice_relay::transfer(handler from, handler to, Error& ec) noexcept
+{
+	std::size_t sent = flush(to, ec);
+	if(ec || pending_ > 0) return sent;
+
+	while(true)
+	{
+		ssize_t n = ::splice(from, nullptr, pipe_[1], nullptr, splice_chunk,
+							SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		if(n == 0)
+		{
+			/* peer closed */
+			ec = errc::socket_receive;
+			break;
+		}
+		if(n < 0)
+		{
+			if(errno != EAGAIN && errno != EWOULDBLOCK)
+				ec = errc::socket_receive;
+			break;
+		}
+		pending_ += n;
+		sent += flush(to, ec);
+		if(ec || pending_ > 0) break;
+	}
+	return sent;
+}
+
+}//POSIX
+}//Soca
+
+#endif /* defined(__linux__) */
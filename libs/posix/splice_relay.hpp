@@ -0,0 +1,63 @@
+#ifndef SOCA_POSIX_SPLICE_RELAY_HPP__
+#define SOCA_POSIX_SPLICE_RELAY_HPP__
+
+#if defined(__linux__)
+
+#include <cstdlib>
+#include <cstdint>
+#include "../error.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Socket to socket relay using splice
+ *
+ * Data is moved from one socket to the other through a kernel pipe,
+ * never entering user space. Sockets must be non-blocking.
+ *
+ * To be notified through the event loop, add both sockets to the
+ * tcp_server with watch() and call transfer() at the read callback.
+ */
+class splice_relay{
+	public:
+		using handler = int;
+
+		splice_relay();
+		~splice_relay();
+
+		/* owns the pipe */
+		splice_relay(splice_relay const&) = delete;
+		splice_relay& operator=(splice_relay const&) = delete;
+
+		void open(Error&) noexcept;
+		bool is_open() const noexcept;
+		void close() noexcept;
+
+		/**
+		 * \brief Moves all data available at \p from to \p to
+		 *
+		 * Data that \p to can't accept stay at the pipe, and is sent
+		 * at next call. Returns the number of bytes written to \p to.
+		 *
+		 * \note If \p from is closed, errc::socket_receive is set.
+		 */
+		std::size_t transfer(handler from, handler to, Error&) noexcept;
+
+		/**
+		 * \brief Bytes read from \p from but not yet written to \p to
+		 */
+		std::size_t pending() const noexcept;
+	private:
+		std::size_t flush(handler to, Error&) noexcept;
+
+		int pipe_[2];
+		std::size_t pending_;
+};
+
+}//POSIX
+}//Soca
+
+#endif /* defined(__linux__) */
+
+#endif /* SOCA_POSIX_SPLICE_RELAY_HPP__ */
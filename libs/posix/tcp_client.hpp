@@ -4,13 +4,25 @@
 #include <cstdlib>
 #include <cstdint>
 #include "../error.hpp"
+#include "../metrics.hpp"
+#include "../probe.hpp"
 #include "../port.hpp"
+#include "awaitable.hpp"
+#include "socket_options.hpp"
+
+/**
+ * Maximum endpoints raced by connect_any
+ */
+#ifndef SOCA_CONNECT_ANY_MAX
+#define SOCA_CONNECT_ANY_MAX		16
+#endif /* SOCA_CONNECT_ANY_MAX */
 
 namespace Soca{
 namespace POSIX{
 
 template<class Endpoint,
-		int Flags = MSG_DONTWAIT>
+		int Flags = MSG_DONTWAIT,
+		class Options = default_options>
 class tcp_client{
 	public:
 		static constexpr bool set_length = true;
@@ -27,10 +39,41 @@ class tcp_client{
 
 		handler native() const noexcept;
 
+		/**
+		 * \brief Options set at open: the \p Options policy, overridden by
+		 * the fields set at \p opt. Call before open.
+		 */
+		void options(socket_options const& opt) noexcept;
+		socket_options const& options() const noexcept;
+		/**
+		 * \brief Corks (\p on) or uncorks the socket, to send a batch of
+		 * writes as full segments
+		 */
+		void cork(bool on, Error&) noexcept;
+
 		void open(endpoint&, Error&) noexcept;
 		bool async_open(endpoint&, Error&) noexcept;
 		template<int BlockTimeMs = -1>
 		bool wait_connect(Error&) const noexcept;
+		/**
+		 * \brief Connects to the first of \p eps that answers (Happy
+		 * Eyeballs, RFC 8305)
+		 *
+		 * Starts a non-blocking connect every \p AttemptDelayMs (or as
+		 * soon as the previous fails), alternating the address families
+		 * (starting by the family of eps[0]). The first to complete is
+		 * kept and the others closed, so a broken path costs only
+		 * \p AttemptDelayMs. Blocks up to \p BlockTimeMs (-1: until all
+		 * fail).
+		 *
+		 * Returns the index at \p eps connected, or -1 (\p ec set: the
+		 * error of the last attempt, as errc::connect_refused,
+		 * errc::connect_unreachable or errc::connect_timeout; also at
+		 * \p BlockTimeMs). At most SOCA_CONNECT_ANY_MAX endpoints are
+		 * tried. A socket already open is closed first.
+		 */
+		template<int AttemptDelayMs = 250, int BlockTimeMs = -1>
+		int connect_any(endpoint const* eps, std::size_t count, Error&) noexcept;
 
 		void bind(endpoint&, Error&) noexcept;
 
@@ -42,8 +85,23 @@ class tcp_client{
 		std::size_t receive(void*, std::size_t, Error&) noexcept;
 		template<int BlockTimeMs>
 		std::size_t receive(void*, std::size_t, Error&) noexcept;
+
+#if SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1
+		/**
+		 * Awaitables (co_await) resumed by the executor.
+		 *
+		 * \note socket must be non-blocking (MSG_DONTWAIT)
+		 */
+		io_awaiter<connect_op<tcp_client>>
+		async_connect(executor&, endpoint&, Error&) noexcept;
+		io_awaiter<receive_op<tcp_client>>
+		async_receive(executor&, void*, std::size_t, Error&) noexcept;
+		io_awaiter<send_op<tcp_client>>
+		async_send(executor&, const void*, std::size_t, Error&) noexcept;
+#endif /* SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1 */
 	private:
 		handler socket_;
+		socket_options options_ = Options::options();
 };
 
 }//POSIX
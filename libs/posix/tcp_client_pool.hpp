@@ -0,0 +1,200 @@
+#ifndef SOCA_POSIX_TCP_CLIENT_POOL_HPP__
+#define SOCA_POSIX_TCP_CLIENT_POOL_HPP__
+
+#if defined(__linux__)
+
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <memory>
+
+#include "../error.hpp"
+#include "../metrics.hpp"
+#include "tcp_client.hpp"
+#include "flow_table.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Keep-alive connections to upstream servers
+ *
+ * Connections are leased with checkout() and return to the pool when
+ * the lease is destroyed. Idle connections are kept per destination
+ * (endpoint_key) as a stack: checkout and checkin are O(1), and the last
+ * used (warmest) connection is leased first.
+ *
+ * Idle connections are watched by a epoll (EPOLLRDHUP, one shot, re-armed
+ * at checkin): a connection closed by the peer, or with unexpected data,
+ * is closed at the next checkout/reap, without blocking.
+ *
+ * Not thread safe. The pool must outlive its leases.
+ */
+template<class Endpoint,
+		int Flags = MSG_DONTWAIT>
+class tcp_client_pool{
+	public:
+		using endpoint = Endpoint;
+		using client = tcp_client<Endpoint, Flags>;
+		using handler = int;
+
+		struct config{
+			std::size_t		max_total = 64;				//connections of the pool (idle + leased)
+			std::size_t		max_per_destination = 16;	//connections to each destination
+			std::size_t		max_idle = 4;				//idle connections kept, per destination
+			unsigned		idle_timeout_ms = 60000;	//idle time to close (reap)
+		};
+
+		/**
+		 * \brief A connection leased. Returns to the pool when destroyed
+		 * (or reset); closed instead if discard()ed.
+		 */
+		class lease{
+			public:
+				lease() noexcept : pool_(nullptr), index_(0){}
+				lease(lease&& other) noexcept
+					: pool_(other.pool_), index_(other.index_), reused_(other.reused_)
+				{
+					other.pool_ = nullptr;
+				}
+				lease& operator=(lease&& other) noexcept
+				{
+					if(this != &other)
+					{
+						reset();
+						pool_ = other.pool_;
+						index_ = other.index_;
+						reused_ = other.reused_;
+						other.pool_ = nullptr;
+					}
+					return *this;
+				}
+				lease(lease const&) = delete;
+				lease& operator=(lease const&) = delete;
+
+				~lease()
+				{
+					reset();
+				}
+
+				client& operator*() const noexcept{ return pool_->slots_[index_].conn; }
+				client* operator->() const noexcept{ return &pool_->slots_[index_].conn; }
+				explicit operator bool() const noexcept{ return pool_ != nullptr; }
+
+				/**
+				 * \brief Connection was idle at the pool (not new). A request
+				 * failing at a reused connection may be retried.
+				 */
+				bool reused() const noexcept{ return reused_; }
+
+				/**
+				 * \brief Returns the connection to the pool
+				 */
+				void reset() noexcept
+				{
+					if(pool_) pool_->checkin(index_, true);
+					pool_ = nullptr;
+				}
+
+				/**
+				 * \brief Closes the connection (e.g. error, protocol state unknown)
+				 */
+				void discard() noexcept
+				{
+					if(pool_) pool_->checkin(index_, false);
+					pool_ = nullptr;
+				}
+			private:
+				friend class tcp_client_pool;
+				lease(tcp_client_pool* pool, std::uint32_t index, bool reused) noexcept
+					: pool_(pool), index_(index), reused_(reused){}
+
+				tcp_client_pool*	pool_;
+				std::uint32_t		index_;
+				bool				reused_ = false;
+		};
+
+		explicit tcp_client_pool(config const& = config{});
+		~tcp_client_pool();
+
+		tcp_client_pool(tcp_client_pool const&) = delete;
+		tcp_client_pool& operator=(tcp_client_pool const&) = delete;
+
+		void open(Error&) noexcept;
+		bool is_open() const noexcept;
+		/**
+		 * \brief Closes the idle connections. Leased ones are closed at checkin.
+		 */
+		void close() noexcept;
+
+		/**
+		 * \brief Readable when a idle connection has events (call reap())
+		 */
+		handler native() const noexcept;
+
+		/**
+		 * \brief Leases a idle connection to \p ep, or connects a new one
+		 * (blocking connect). Empty lease (\p ec set) if the connect fails
+		 * or a limit is reached (errc::no_free_slots).
+		 */
+		lease checkout(endpoint const& ep, Error& ec) noexcept;
+
+		/**
+		 * \brief Opens connections to \p ep until \p count are idle (up to
+		 * the limits). Returns the number of idle connections.
+		 */
+		std::size_t prewarm(endpoint const& ep, std::size_t count, Error& ec) noexcept;
+
+		/**
+		 * \brief Closes the idle connections dead or idle for more than
+		 * idle_timeout_ms. Returns the number closed.
+		 */
+		std::size_t reap() noexcept;
+
+		std::size_t size() const noexcept{ return size_; }
+		std::size_t idle() const noexcept{ return idle_; }
+	private:
+		using clock = std::chrono::steady_clock;
+		static constexpr const std::uint32_t none = 0xffffffff;
+
+		struct slot{
+			client				conn;
+			endpoint_key		key;
+			std::uint32_t		prev = none;		//idle list, or free list (next)
+			std::uint32_t		next = none;
+			bool				idle = false;
+			clock::time_point	idle_since;
+		};
+
+		struct destination{
+			std::uint32_t	head = none;			//last checked in
+			std::uint32_t	tail = none;			//oldest
+			std::uint32_t	idle = 0;
+			std::uint32_t	total = 0;
+		};
+
+		std::uint32_t connect(endpoint const&, endpoint_key const&, Error&) noexcept;
+		void checkin(std::uint32_t index, bool reusable) noexcept;
+		void push_idle(destination&, std::uint32_t index) noexcept;
+		void remove_idle(destination&, std::uint32_t index) noexcept;
+		void close_slot(std::uint32_t index) noexcept;
+		std::size_t poll_events() noexcept;
+		bool arm(std::uint32_t index, int op) noexcept;
+
+		config						config_;
+		std::unique_ptr<slot[]>		slots_;
+		flow_table<destination>		destinations_;
+		std::uint32_t				free_ = none;
+		std::size_t					size_ = 0;
+		std::size_t					idle_ = 0;
+		int							epoll_fd_ = -1;
+};
+
+}//POSIX
+}//Soca
+
+#include "impl/tcp_client_pool_impl.hpp"
+
+#endif /* defined(__linux__) */
+
+#endif /* SOCA_POSIX_TCP_CLIENT_POOL_HPP__ */
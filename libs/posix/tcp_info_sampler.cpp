@@ -0,0 +1,183 @@
+#include "tcp_info_sampler.hpp"
+
+#if defined(__linux__)
+
+#include <cstddef>
+#include <chrono>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "../metrics.hpp"
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * struct tcp_info of the kernel (linux/tcp.h) up to tcpi_delivery_rate.
+ * The glibc one ends at tcpi_total_retrans, and linux/tcp.h conflicts
+ * with netinet/tcp.h. Older kernels fill less (checked by the length).
+ */
+struct kernel_tcp_info{
+	std::uint8_t	state;
+	std::uint8_t	ca_state;
+	std::uint8_t	retransmits;
+	std::uint8_t	probes;
+	std::uint8_t	backoff;
+	std::uint8_t	options;
+	std::uint8_t	wscale;
+	std::uint8_t	app_limited;
+
+	std::uint32_t	rto;
+	std::uint32_t	ato;
+	std::uint32_t	snd_mss;
+	std::uint32_t	rcv_mss;
+
+	std::uint32_t	unacked;
+	std::uint32_t	sacked;
+	std::uint32_t	lost;
+	std::uint32_t	retrans;
+	std::uint32_t	fackets;
+
+	std::uint32_t	last_data_sent;
+	std::uint32_t	last_ack_sent;
+	std::uint32_t	last_data_recv;
+	std::uint32_t	last_ack_recv;
+
+	std::uint32_t	pmtu;
+	std::uint32_t	rcv_ssthresh;
+	std::uint32_t	rtt;
+	std::uint32_t	rttvar;
+	std::uint32_t	snd_ssthresh;
+	std::uint32_t	snd_cwnd;
+	std::uint32_t	advmss;
+	std::uint32_t	reordering;
+
+	std::uint32_t	rcv_rtt;
+	std::uint32_t	rcv_space;
+
+	std::uint32_t	total_retrans;
+
+	std::uint64_t	pacing_rate;
+	std::uint64_t	max_pacing_rate;
+	std::uint64_t	bytes_acked;
+	std::uint64_t	bytes_received;
+	std::uint32_t	segs_out;
+	std::uint32_t	segs_in;
+
+	std::uint32_t	notsent_bytes;
+	std::uint32_t	min_rtt;
+	std::uint32_t	data_segs_in;
+	std::uint32_t	data_segs_out;
+
+	std::uint64_t	delivery_rate;
+};
+static_assert(offsetof(kernel_tcp_info, delivery_rate) == 160, "tcp_info layout");
+
+static std::uint64_t now_ns() noexcept
+{
+	return static_cast<std::uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+#define SOCA_TCP_INFO_HAS(len, field)	\
+	((len) >= offsetof(kernel_tcp_info, field) + sizeof(kernel_tcp_info::field))
+
+bool read_tcp_stats(int socket, tcp_stats& stats) noexcept
+{
+	kernel_tcp_info info = {};
+	socklen_t len = sizeof(info);
+	if(::getsockopt(socket, IPPROTO_TCP, TCP_INFO, &info, &len) != 0
+		|| !SOCA_TCP_INFO_HAS(len, total_retrans))
+		return false;
+
+	stats.rtt_us = info.rtt;
+	stats.rtt_var_us = info.rttvar;
+	stats.retransmits = info.total_retrans;
+	stats.cwnd = info.snd_cwnd;
+	stats.mss = info.snd_mss;
+	stats.unacked = info.unacked;
+	stats.min_rtt_us = SOCA_TCP_INFO_HAS(len, min_rtt) ? info.min_rtt : 0;
+	stats.notsent_bytes = SOCA_TCP_INFO_HAS(len, notsent_bytes) ? info.notsent_bytes : 0;
+	stats.delivery_rate = SOCA_TCP_INFO_HAS(len, delivery_rate) ? info.delivery_rate : 0;
+	stats.sampled_ns = now_ns();
+	return true;
+}
+
+tcp_info_sampler::tcp_info_sampler(unsigned interval_ms /* = SOCA_TCP_INFO_INTERVAL_MS */) noexcept
+	: interval_ns_(static_cast<std::uint64_t>(interval_ms) * 1000000){}
+
+bool tcp_info_sampler::add(handler socket, Error& ec) noexcept
+{
+	if(socket < 0)
+	{
+		ec = errc::socket_error;
+		return false;
+	}
+	std::size_t fd = static_cast<std::size_t>(socket);
+	try{
+		if(fd >= index_.size()) index_.resize(fd + 1, none);
+		if(index_[fd] != none) return true;
+		entries_.push_back(entry{socket, tcp_stats{}});
+	}catch(...){
+		ec = errc::out_of_resources;
+		return false;
+	}
+	index_[fd] = static_cast<std::uint32_t>(entries_.size() - 1);
+	return true;
+}
+
+bool tcp_info_sampler::remove(handler socket) noexcept
+{
+	std::size_t fd = static_cast<std::size_t>(socket);
+	if(socket < 0 || fd >= index_.size() || index_[fd] == none) return false;
+
+	/* the last entry takes the place of the removed */
+	std::uint32_t i = index_[fd];
+	index_[fd] = none;
+	if(i != entries_.size() - 1)
+	{
+		entries_[i] = entries_.back();
+		index_[static_cast<std::size_t>(entries_[i].socket)] = i;
+	}
+	entries_.pop_back();
+	return true;
+}
+
+std::size_t tcp_info_sampler::sample(std::size_t batch /* = 16 */) noexcept
+{
+	std::size_t sampled = 0;
+	std::uint64_t now = now_ns();
+	/* each entry visited once per call, at most */
+	for(std::size_t visited = 0;
+		visited < entries_.size() && sampled < batch;
+		visited++)
+	{
+		if(next_ >= entries_.size()) next_ = 0;
+		entry& e = entries_[next_++];
+		if(e.stats.sampled_ns && now - e.stats.sampled_ns < interval_ns_) continue;
+
+		[[maybe_unused]] std::uint32_t retransmits = e.stats.retransmits;
+		if(!read_tcp_stats(e.socket, e.stats)) continue;
+		sampled++;
+
+		SOCA_METRIC_ADD(tcp_retransmits, e.stats.retransmits - retransmits);
+		SOCA_METRIC_RECORD(tcp_rtt, static_cast<std::uint64_t>(e.stats.rtt_us) * 1000);
+		SOCA_METRIC_RECORD(tcp_cwnd, e.stats.cwnd);
+		SOCA_METRIC_RECORD(tcp_delivery_rate, e.stats.delivery_rate);
+		SOCA_METRIC_RECORD(tcp_notsent, e.stats.notsent_bytes);
+	}
+	return sampled;
+}
+
+tcp_stats const* tcp_info_sampler::stats(handler socket) const noexcept
+{
+	std::size_t fd = static_cast<std::size_t>(socket);
+	if(socket < 0 || fd >= index_.size() || index_[fd] == none) return nullptr;
+	return &entries_[index_[fd]].stats;
+}
+
+}//POSIX
+}//Soca
+
+#endif /* defined(__linux__) */
@@ -0,0 +1,112 @@
+#ifndef SOCA_POSIX_TCP_INFO_SAMPLER_HPP__
+#define SOCA_POSIX_TCP_INFO_SAMPLER_HPP__
+
+#if defined(__linux__)
+
+#include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include "../error.hpp"
+
+/**
+ * Minimum time between two samples of the same connection
+ */
+#ifndef SOCA_TCP_INFO_INTERVAL_MS
+#define SOCA_TCP_INFO_INTERVAL_MS		1000
+#endif /* SOCA_TCP_INFO_INTERVAL_MS */
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Kernel view of a TCP connection (TCP_INFO)
+ */
+struct tcp_stats{
+	std::uint32_t	rtt_us = 0;			//smoothed RTT
+	std::uint32_t	rtt_var_us = 0;
+	std::uint32_t	min_rtt_us = 0;		//0 if not reported by the kernel
+	std::uint32_t	retransmits = 0;	//segments retransmitted (total)
+	std::uint32_t	cwnd = 0;			//congestion window, segments
+	std::uint32_t	mss = 0;
+	std::uint32_t	unacked = 0;		//segments in flight
+	std::uint32_t	notsent_bytes = 0;	//send queue not yet sent
+	std::uint64_t	delivery_rate = 0;	//bytes/s, 0 if not reported
+	std::uint64_t	sampled_ns = 0;		//steady clock of the sample
+};
+
+/**
+ * \brief Reads TCP_INFO of \p socket. Returns false if \p socket is not
+ * a TCP socket (or closed).
+ */
+bool read_tcp_stats(int socket, tcp_stats&) noexcept;
+
+/**
+ * \brief Periodic TCP_INFO of many connections
+ *
+ * Connections are added (e.g. at the open callback of tcp_server) and
+ * removed (close callback). Each sample() call reads at most \p batch
+ * connections, round robin, each no more than once every \p interval_ms,
+ * so calling it at every loop iteration spreads the cost.
+ *
+ * Each sample records the histograms tcp_rtt, tcp_cwnd, tcp_delivery_rate,
+ * tcp_notsent, and the tcp_retransmits counter (SOCA_USE_METRICS).
+ */
+class tcp_info_sampler{
+	public:
+		using handler = int;
+
+		explicit tcp_info_sampler(unsigned interval_ms = SOCA_TCP_INFO_INTERVAL_MS) noexcept;
+
+		/**
+		 * \brief Starts sampling \p socket (sampled at the next call).
+		 * Returns false if out of memory (errc::out_of_resources).
+		 */
+		bool add(handler socket, Error&) noexcept;
+		bool remove(handler socket) noexcept;
+
+		/**
+		 * \brief Samples up to \p batch connections due. Returns the
+		 * number sampled.
+		 */
+		std::size_t sample(std::size_t batch = 16) noexcept;
+
+		/**
+		 * \brief Last sample of \p socket (nullptr if not added). All
+		 * zero if not sampled yet.
+		 */
+		tcp_stats const* stats(handler socket) const noexcept;
+
+		/**
+		 * \brief Calls fn(handler, tcp_stats const&) for each connection
+		 * (e.g. to close slow consumers). Connections must not be removed
+		 * inside \p fn.
+		 */
+		template<typename Fn>
+		void for_each(Fn&& fn) const
+		{
+			for(entry const& e : entries_)
+				fn(e.socket, e.stats);
+		}
+
+		std::size_t size() const noexcept{ return entries_.size(); }
+	private:
+		static constexpr const std::uint32_t none = 0xFFFFFFFF;
+
+		struct entry{
+			handler		socket;
+			tcp_stats	stats;
+		};
+
+		std::uint64_t				interval_ns_;
+		std::vector<entry>			entries_;
+		/* entry index, by socket */
+		std::vector<std::uint32_t>	index_;
+		std::size_t					next_ = 0;
+};
+
+}//POSIX
+}//Soca
+
+#endif /* defined(__linux__) */
+
+#endif /* SOCA_POSIX_TCP_INFO_SAMPLER_HPP__ */
@@ -3,15 +3,40 @@
 
 #include <cstdlib>
 #include <cstdint>
+#include <vector>
 
 #include "../error.hpp"
+#include "../metrics.hpp"
+#include "../probe.hpp"
+#include "../buffer_pool.hpp"
 #include "port.hpp"
+#include "functions.hpp"
+#include "awaitable.hpp"
+#include "socket_options.hpp"
+#include "busy_poll.hpp"
+
+/**
+ * Pending connections queue (listen backlog) of open. The kernel caps
+ * it at net.core.somaxconn.
+ */
+#ifndef SOCA_TCP_SERVER_BACKLOG
+#define SOCA_TCP_SERVER_BACKLOG			SOMAXCONN
+#endif /* SOCA_TCP_SERVER_BACKLOG */
+
+/**
+ * Maximum connections accepted by wakeup of the loop. The ones left wake
+ * it again, after the other events.
+ */
+#ifndef SOCA_TCP_SERVER_ACCEPT_BATCH
+#define SOCA_TCP_SERVER_ACCEPT_BATCH	64
+#endif /* SOCA_TCP_SERVER_ACCEPT_BATCH */
 
 namespace Soca{
 namespace POSIX{
 
 template<class Endpoint,
-		int Flags = MSG_DONTWAIT>
+		int Flags = MSG_DONTWAIT,
+		class Options = default_options>
 class tcp_server{
 	public:
 		static constexpr bool set_length = true;
@@ -25,36 +50,244 @@ class tcp_server{
 
 		tcp_server();
 
-		template<int PendingQueueSize = 10>
+		template<int PendingQueueSize = SOCA_TCP_SERVER_BACKLOG>
 		void open(endpoint&, Error&) noexcept;
+		void open(endpoint&, int backlog, Error&) noexcept;
+#if defined(__linux__) && SOCA_USE_SELECT != 1
+		/**
+		 * \brief Opens over the listening socket of \p listener (that
+		 * keeps serving), so each thread runs its own loop. The listener is
+		 * registered with EPOLLEXCLUSIVE: a connection wakes one of the loops.
+		 */
+		void share(tcp_server const& listener, Error&) noexcept;
+#endif /* defined(__linux__) && SOCA_USE_SELECT != 1 */
+		/**
+		 * \brief Opens over a listening socket already bound (e.g.
+		 * received at a hot restart, handoff_receive). Takes ownership of
+		 * \p listener. Options are the ones set by its creator.
+		 *
+		 * \note O_NONBLOCK is shared with the other processes of the socket
+		 */
+		void assign(handler listener, Error&) noexcept;
 		bool is_open() const noexcept;
+		handler native() const noexcept;
+
+		/**
+		 * \brief Options set at open: the \p Options policy, overridden by
+		 * the fields set at \p opt. Call before open.
+		 *
+		 * The listening socket gets all options, and the accepted sockets
+		 * inherit them; only TCP_QUICKACK (not inherited) is set again at
+		 * accept.
+		 */
+		void options(socket_options const& opt) noexcept;
+		socket_options const& options() const noexcept;
+		/**
+		 * \brief Corks (\p on) or uncorks the accepted \p socket, to send
+		 * a batch of writes as full segments
+		 */
+		void cork(handler socket, bool on, Error&) noexcept;
 
+		/**
+		 * \brief Waits the events (up to \p BlockTimeMs) and calls the
+		 * callbacks
+		 *
+		 * If \p SpinUs > 0, polls without blocking for up to \p SpinUs
+		 * microseconds before blocking, trading CPU for the wakeup latency
+		 * (see spin()). Only worth with a core dedicated to the
+		 * thread. Requires epoll.
+		 */
 		template<
 			int BlockTimeMs = 0,
 			unsigned MaxEvents = 32,
+			unsigned SpinUs = 0,
 			typename ReadCb,
 			typename OpenCb = void*,
 			typename CloseCb = void*>
 		bool run(Error&,
 				ReadCb, OpenCb = nullptr, CloseCb = nullptr) noexcept;
 
+		/**
+		 * \brief Time spinning and sleeping at run
+		 */
+		spin_stats const& spin() const noexcept{ return spin_; }
+		void reset_spin() noexcept{ spin_ = spin_stats{}; }
+#if defined(__linux__) && SOCA_USE_SELECT != 1
+		/**
+		 * \brief Busy polls the device queues at the blocking wait of run,
+		 * for \p usecs (epoll_busy_poll)
+		 */
+		void busy_poll(unsigned usecs, unsigned budget, bool prefer, Error&) noexcept;
+#endif /* defined(__linux__) && SOCA_USE_SELECT != 1 */
+
+#if SOCA_USE_SELECT != 1
+		/**
+		 * \brief Same as run, but read and close events are handed
+		 * to a dispatcher (worker threads). open_cb runs at this thread.
+		 */
+		template<
+			int BlockTimeMs = 0,
+			unsigned MaxEvents = 32,
+			typename Dispatcher,
+			typename OpenCb = void*>
+		bool run_dispatch(Error&, Dispatcher&, OpenCb = nullptr) noexcept;
+#endif /* SOCA_USE_SELECT != 1 */
+
 		std::size_t send(handler to_socket, const void*, std::size_t, Error&)  noexcept;
 		std::size_t receive(handler socket, void* buffer, std::size_t, Error&) noexcept;
+		/**
+		 * \brief Receives into a pool buffer
+		 *
+		 * If \p buf is empty or shared with other handles, a new buffer
+		 * of SOCA_BUFFER_POOL_DEFAULT_SIZE is taken from the pool.
+		 */
+		std::size_t receive(handler socket, buffer& buf, Error&) noexcept;
+#if defined(__linux__)
+		/**
+		 * \brief Sends \p len bytes of \p file_fd, starting at \p offset,
+		 * without copying the data to user space (sendfile).
+		 *
+		 * Returns the number of bytes sent (0 if the socket would block)
+		 */
+		std::size_t send_file(handler to_socket, int file_fd,
+				std::size_t offset, std::size_t len, Error&) noexcept;
+
+		/**
+		 * \brief Enables kernel timestamps (timestamp_rx, timestamp_tx,
+		 * timestamp_hardware) at \p socket (e.g. at open_cb)
+		 */
+		void timestamping(handler socket, unsigned flags, Error&) noexcept;
+		/**
+		 * \brief Receives, getting the kernel RX timestamp of the last
+		 * segment read
+		 */
+		std::size_t receive(handler socket, void* buffer, std::size_t,
+				timestamp&, Error&) noexcept;
+		/**
+		 * \brief Reads one TX timestamp of \p socket. \p ts.id is the
+		 * byte offset of the end of the send, timestamped when passed to
+		 * the device (TX software), not when acknowledged. Returns false
+		 * if there is none (yet).
+		 */
+		bool tx_timestamp(handler socket, timestamp& ts) noexcept;
+#endif /* defined(__linux__) */
+
+		/**
+		 * \brief Adds a socket not accepted by this server (e.g. a tcp_client)
+		 * to the server loop. read_cb will be called when it is readable or,
+		 * if \p writable, writable.
+		 *
+		 * The server doesn't own it: at hangup it is removed from the loop
+		 * and reported to close_cb, but not closed. Call unwatch before
+		 * closing it.
+		 *
+		 * At a socket accepted (already at the loop), just adds the
+		 * writable events.
+		 */
+		bool watch(handler socket, Error&, bool writable = true) noexcept;
+		/**
+		 * \brief Removes a watched socket from the loop
+		 */
+		void unwatch(handler socket) noexcept;
+		/**
+		 * \brief Adds a connection accepted elsewhere (e.g. received at a hot
+		 * restart, handoff_receive) as if accepted by this server: it is
+		 * owned, and closed at hangup.
+		 */
+		bool adopt(handler socket, Error&) noexcept;
+
+		/**
+		 * \brief Stops (pause) or restarts (resume) the read events of the
+		 * accepted \p socket; close events (and the writable events added
+		 * by watch) keep coming. Data arrived while paused wakes the loop
+		 * at resume.
+		 *
+		 * \note With select (SOCA_USE_SELECT), closing is only seen when
+		 * reading: a paused socket reports nothing, close included, until
+		 * resumed.
+		 *
+		 * Pausing the listening socket (native()) stops accepting: the
+		 * connections wait at the listen backlog. At the descriptors limit
+		 * (EMFILE/ENFILE) the server pauses it, and resumes at the next
+		 * close_client/detach_client, unless paused again here.
+		 */
+		bool pause(handler socket, Error&) noexcept;
+		bool resume(handler socket, Error&) noexcept;
 
 		void close() noexcept;
+		/**
+		 * \brief Closes an accepted (or adopted) connection. Not for the
+		 * watched sockets (unwatch): they aren't counted at the connections
+		 * gauge.
+		 */
 		void close_client(handler) noexcept;
+		/**
+		 * \brief Removes \p socket from the loop and closes its descriptor,
+		 * without shutting down the connection (e.g. passed to another
+		 * process, handoff_send)
+		 */
+		void detach_client(handler) noexcept;
+
+#if SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1
+		/**
+		 * Awaitables (co_await) resumed by the executor. The server
+		 * loop (run) is not used.
+		 *
+		 * \note socket must be non-blocking (MSG_DONTWAIT)
+		 */
+		io_awaiter<accept_op<tcp_server>>
+		async_accept(executor&, Error&) noexcept;
+		io_awaiter<server_receive_op<tcp_server>>
+		async_receive(executor&, handler socket, void*, std::size_t, Error&) noexcept;
+		io_awaiter<server_send_op<tcp_server>>
+		async_send(executor&, handler to_socket, const void*, std::size_t, Error&) noexcept;
+#endif /* SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1 */
 
 #if SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1
 		fd_set const& client_list() const noexcept;
 #endif /* SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1 */
 	private:
+#if SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1
+		friend struct accept_op<tcp_server>;
+#endif /* SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1 */
+
+		/**
+		 * \brief Accepts one connection. Returns -1 if there is none (\p ec
+		 * not set) or at error.
+		 */
 		handler accept(Error&) noexcept;
+		/**
+		 * \brief Accepts one connection, not added to the loop (shared with
+		 * async_accept). At the descriptors limit, -1 and out_of_resources.
+		 */
+		handler accept_socket(Error&) noexcept;
+		template<typename OpenCb>
+		void accept_batch(Error&, OpenCb&) noexcept;
 		bool open_poll() noexcept;
+		bool add_listener_poll() noexcept;
 		bool add_socket_poll(handler socket, std::uint32_t events) noexcept;
+		/* resumes the listener paused at the descriptors limit */
+		void fd_released() noexcept;
+
+		/**
+		 * Descriptor state
+		 */
+		static constexpr const std::uint8_t fd_watched = 1 << 0;	//not owned (watch)
+		static constexpr const std::uint8_t fd_writable = 1 << 1;	//EPOLLOUT (watch)
+
+		std::uint8_t state(handler socket) const noexcept;
+		bool state(handler socket, std::uint8_t) noexcept;
 
 		handler socket_;
+		socket_options options_ = Options::options();
+		spin_stats spin_;
+		bool accepting_ = true;
+		bool fd_limit_ = false;		//listener paused at EMFILE/ENFILE
 #if SOCA_USE_SELECT != 1
 		int epoll_fd_;
+		std::vector<std::uint8_t>	fds_;		//state, by descriptor
+#else /* SOCA_USE_SELECT != 1 */
+		fd_set	watched_;
 #endif /* SOCA_USE_SELECT != 1 */
 #if SOCA_USE_SELECT == 1 || SOCA_TCP_SERVER_CLIENT_LIST == 1
 		fd_set	list_;
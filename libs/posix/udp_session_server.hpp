@@ -0,0 +1,233 @@
+#ifndef SOCA_POSIX_UDP_SESSION_SERVER_HPP__
+#define SOCA_POSIX_UDP_SESSION_SERVER_HPP__
+
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "../error.hpp"
+#include "../metrics.hpp"
+#include "../timer_wheel.hpp"
+#include "udp_socket.hpp"
+#include "flow_table.hpp"
+
+/**
+ * Slots of the idle timer wheel. The tick is idle_timeout_ms / slots
+ */
+#ifndef SOCA_UDP_SESSION_WHEEL_SLOTS
+#define SOCA_UDP_SESSION_WHEEL_SLOTS		64
+#endif /* SOCA_UDP_SESSION_WHEEL_SLOTS */
+
+namespace Soca{
+namespace POSIX{
+
+/**
+ * \brief Datagram of a batch (valid during the data callback)
+ */
+struct datagram{
+	const void*		data;
+	std::size_t		size;
+};
+
+/**
+ * \brief UDP server that demultiplexes the datagrams into per-peer
+ * sessions
+ *
+ * Each run() receives a batch of datagrams (recvmmsg at Linux), looks
+ * up the session of each peer (flow_table keyed by endpoint_key),
+ * creating it at its first datagram, and calls the data callback once
+ * per session with all its datagrams of the batch, in arrival order.
+ *
+ * Sessions idle for idle_timeout_ms are evicted by a timer wheel (close
+ * callback before). A datagram only updates the session last activity:
+ * the wheel entry is rescheduled when it fires.
+ *
+ * Sessions have stable addresses, until closed/evicted.
+ *
+ * Pinned peers (config pin_rate): a session receiving pin_rate datagrams
+ * per second or more gets its own socket, bound to the same address
+ * (SO_REUSEPORT) and connected to the peer. The kernel delivers the
+ * peer datagrams to it, and send() uses the route cached at the socket
+ * instead of a lookup per datagram. Below unpin_rate, the socket is
+ * closed and the peer is back at the shared socket. Worth to a few
+ * peers of high volume: each pinned socket is one more descriptor
+ * at the wait.
+ *
+ * \tparam Endpoint endpoint_ipv4, endpoint_ipv6 or endpoint_ip
+ * \tparam State per-session application state, default constructible
+ * (a new session is reset to State{})
+ */
+template<class Endpoint,
+		class State,
+		int Flags = MSG_DONTWAIT>
+class udp_session_server{
+	public:
+		using endpoint = Endpoint;
+		using socket_type = udp<Endpoint, Flags>;
+		using handler = typename socket_type::handler;
+
+		struct config{
+			std::size_t		max_sessions = 4096;
+			unsigned		idle_timeout_ms = 30000;
+			unsigned		batch = 32;				//datagrams received by run()
+			std::size_t		datagram_size = 2048;	//larger datagrams are truncated
+			/* pinned peers (needs SO_REUSEPORT) */
+			unsigned		pin_rate = 0;			//datagrams/s to pin a peer (0: disabled)
+			unsigned		unpin_rate = 0;			//datagrams/s to unpin (0: pin_rate / 2)
+			std::size_t		max_pinned = 16;
+			unsigned		rate_window_ms = 1000;	//rate measure period
+		};
+
+		struct session{
+			endpoint_key	key;
+			endpoint		peer;
+			State			state;
+		private:
+			friend class udp_session_server;
+			std::uint64_t	last_ns = 0;
+			std::uint64_t	window_ns = 0;	//rate measure start
+			std::uint32_t	packets = 0;	//datagrams since window_ns
+			std::uint32_t	pinned = none;	//pinned socket, if any
+			std::uint32_t	generation = 0;
+			std::uint32_t	next = 0;		//free list
+			std::uint32_t	batch = 0;		//run() of the last datagram
+			std::uint32_t	first = 0;		//datagrams of the batch (run() list)
+			std::uint32_t	last = 0;
+			bool			active = false;
+		};
+
+		explicit udp_session_server(config const& = config{}, std::uint64_t seed = 0);
+		~udp_session_server(){ close(); }
+
+		udp_session_server(udp_session_server const&) = delete;
+		udp_session_server& operator=(udp_session_server const&) = delete;
+
+		/**
+		 * \brief Opens the socket bound to \p ep. Set the socket options
+		 * before (socket().options())
+		 */
+		void open(endpoint& ep, Error&) noexcept;
+		void close() noexcept;
+		bool is_open() const noexcept;
+		handler native() const noexcept;
+		socket_type& socket() noexcept{ return socket_; }
+
+		/**
+		 * \brief Waits up to \p BlockTimeMs, receives a batch and calls
+		 * the callbacks; then evicts the idle sessions.
+		 *
+		 * * \p data_cb(session&, datagram const*, std::size_t count)
+		 * * \p open_cb(session&): new session, before its data
+		 * * \p close_cb(session&): session evicted
+		 *
+		 * Datagrams of new peers are dropped if max_sessions is reached.
+		 * Peers are pinned/unpinned after the callbacks.
+		 */
+		template<int BlockTimeMs = 0,
+				typename DataCb,
+				typename OpenCb = void*,
+				typename CloseCb = void*>
+		bool run(Error&, DataCb, OpenCb = nullptr, CloseCb = nullptr) noexcept;
+
+		/**
+		 * \brief Evicts the sessions idle (called by run)
+		 */
+		template<typename CloseCb = void*>
+		std::size_t expire(CloseCb = nullptr) noexcept;
+
+		std::size_t send(session&, const void*, std::size_t, Error&) noexcept;
+
+		session* find(endpoint_key const&) noexcept;
+		/**
+		 * \brief Closes \p s (e.g. at the end of the protocol exchange).
+		 * The close callback is not called.
+		 */
+		void close(session& s) noexcept;
+
+		std::size_t size() const noexcept{ return sessions_.size(); }
+		std::uint64_t dropped() const noexcept{ return dropped_; }
+
+		bool pinned(session const& s) const noexcept{ return s.pinned != none; }
+		std::size_t pinned_size() const noexcept{ return pinned_count_; }
+	private:
+		static constexpr const std::uint32_t none = 0xffffffff;
+
+		struct timer{
+			std::uint32_t	index;
+			std::uint32_t	generation;
+		};
+
+		struct pinned_peer{
+			socket_type		socket;
+			std::uint32_t	index = none;	//session
+		};
+
+		struct pin_change{
+			std::uint32_t	index;
+			std::uint32_t	generation;
+			bool			pin;
+		};
+
+		static std::uint64_t now_ns() noexcept
+		{
+			return static_cast<std::uint64_t>(
+					std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now().time_since_epoch()).count());
+		}
+
+		std::size_t receive_batch(socket_type&, Error&) noexcept;
+		/**
+		 * \brief Groups the \p count datagrams received by session, and
+		 * calls the data callback. \p known is the session of all (pinned
+		 * socket), or none to look up each.
+		 */
+		template<typename DataCb, typename OpenCb>
+		void dispatch(std::size_t count, std::uint32_t known, DataCb&, OpenCb&) noexcept;
+		std::uint32_t lookup(endpoint_key const&, bool& created, std::uint64_t now) noexcept;
+		void release(std::uint32_t index) noexcept;
+
+		void measure(session&, std::uint32_t index, std::uint64_t now) noexcept;
+		template<typename DataCb, typename OpenCb>
+		void apply_pins(DataCb&, OpenCb&) noexcept;
+		template<typename DataCb, typename OpenCb>
+		void pin(std::uint32_t index, DataCb&, OpenCb&) noexcept;
+		template<typename DataCb, typename OpenCb>
+		void drain(std::uint32_t slot, std::uint32_t index, DataCb&, OpenCb&) noexcept;
+		void close_pinned(std::uint32_t slot) noexcept;
+
+		config							config_;
+		socket_type						socket_;
+		std::unique_ptr<session[]>		slots_;
+		flow_table<std::uint32_t>		sessions_;		//key to slot
+		timer_wheel<timer>				wheel_;
+		std::uint32_t					free_ = none;
+		std::uint32_t					batch_ = 0;
+		std::uint64_t					dropped_ = 0;
+
+		/* pinned peers */
+		endpoint						local_;			//address of socket_
+		std::vector<pinned_peer>		pinned_;
+		std::size_t						pinned_count_ = 0;
+		std::vector<pin_change>			pin_changes_;	//applied after the callbacks
+
+		/* batch buffers */
+		std::unique_ptr<std::uint8_t[]>	data_;
+		std::vector<endpoint>			peers_;
+		std::vector<std::size_t>		sizes_;
+		std::vector<std::uint32_t>		next_;			//datagram list of each session
+		std::vector<std::uint32_t>		order_;			//sessions, by first datagram
+		std::vector<datagram>			datagrams_;
+#if defined(__linux__)
+		std::vector<struct mmsghdr>		msgs_;
+		std::vector<struct iovec>		iovs_;
+#endif /* defined(__linux__) */
+};
+
+}//POSIX
+}//Soca
+
+#include "impl/udp_session_server_impl.hpp"
+
+#endif /* SOCA_POSIX_UDP_SESSION_SERVER_HPP__ */
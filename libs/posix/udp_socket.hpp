@@ -4,13 +4,21 @@
 #include <cstdlib>
 #include <cstdint>
 #include "../error.hpp"
+#include "../metrics.hpp"
+#include "../probe.hpp"
+#include "../buffer_pool.hpp"
 #include "port.hpp"
+#include "functions.hpp"
+#include "awaitable.hpp"
+#include "socket_options.hpp"
+#include "busy_poll.hpp"
 
 namespace Soca{
 namespace POSIX{
 
 template<class Endpoint,
-		int Flags = MSG_DONTWAIT>
+		int Flags = MSG_DONTWAIT,
+		class Options = default_options>
 class udp{
 	public:
 #if	defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
@@ -26,15 +34,108 @@ class udp{
 		void open(endpoint&, Error&) noexcept;
 
 		void bind(endpoint&, Error&) noexcept;
+		/**
+		 * \brief Connects the socket to \p ep: only its datagrams are
+		 * received, and the route is kept at the socket (send/receive
+		 * without endpoint)
+		 */
+		void connect(endpoint&, Error&) noexcept;
 
 		void close() noexcept;
 
+		handler native() const noexcept;
+
+		/**
+		 * \brief Options set at open: the \p Options policy, overridden by
+		 * the fields set at \p opt. Call before open.
+		 * The TCP options are ignored.
+		 */
+		void options(socket_options const& opt) noexcept;
+		socket_options const& options() const noexcept;
+
 		std::size_t send(const void*, std::size_t, endpoint&, Error&)  noexcept;
 		std::size_t receive(void*, std::size_t, endpoint&, Error&) noexcept;
-		template<int BlockTimeMs>
+		/**
+		 * \brief Send/receive at a connected socket
+		 */
+		std::size_t send(const void*, std::size_t, Error&)  noexcept;
+		std::size_t receive(void*, std::size_t, Error&) noexcept;
+		/**
+		 * \brief Receives into a pool buffer
+		 *
+		 * If \p buf is empty or shared with other handles, a new buffer
+		 * of SOCA_BUFFER_POOL_DEFAULT_SIZE is taken from the pool.
+		 */
+		std::size_t receive(buffer& buf, endpoint&, Error&) noexcept;
+		/**
+		 * \brief Waits up to \p BlockTimeMs to receive
+		 *
+		 * If \p SpinUs > 0, first tries to receive without blocking for
+		 * up to \p SpinUs microseconds (see spin()). Only worth with a core
+		 * dedicated to the thread.
+		 */
+		template<int BlockTimeMs, unsigned SpinUs = 0>
 		std::size_t receive(void*, std::size_t, endpoint&, Error&) noexcept;
+		/**
+		 * \brief Time spinning and sleeping at receive
+		 */
+		spin_stats const& spin() const noexcept{ return spin_; }
+		void reset_spin() noexcept{ spin_ = spin_stats{}; }
+
+#if !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__)
+		/**
+		 * \brief Enables the packet info (IP_PKTINFO/IPV6_RECVPKTINFO):
+		 * the local address and interface of the datagrams received. Call
+		 * after open.
+		 */
+		void pktinfo(Error&) noexcept;
+		/**
+		 * \brief Receives, getting the local address and interface of the
+		 * datagram (pktinfo enabled)
+		 */
+		std::size_t receive(void*, std::size_t, endpoint&, packet_info&, Error&) noexcept;
+		/**
+		 * \brief Sends from the local address (and interface, if set) of
+		 * \p info. A wildcard bound socket replies from the address the
+		 * request came passing the info received.
+		 */
+		std::size_t send(const void*, std::size_t, endpoint&, packet_info const&, Error&) noexcept;
+#endif /* !defined(WIN32) && !defined(_WIN32) && !defined(__WIN32__) && !defined(__NT__) */
+
+#if defined(__linux__)
+		/**
+		 * \brief Enables kernel timestamps (timestamp_rx, timestamp_tx,
+		 * timestamp_hardware)
+		 */
+		void timestamping(unsigned flags, Error&) noexcept;
+		/**
+		 * \brief Receives, getting the kernel RX timestamp of the packet
+		 */
+		std::size_t receive(void*, std::size_t, endpoint&, timestamp&, Error&) noexcept;
+		/**
+		 * \brief Reads one TX timestamp of the packets sent. Returns false
+		 * if there is none (yet).
+		 */
+		bool tx_timestamp(timestamp&) noexcept;
+#endif /* defined(__linux__) */
+
+#if SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1
+		/**
+		 * Awaitables (co_await) resumed by the executor.
+		 *
+		 * \note socket must be non-blocking (MSG_DONTWAIT)
+		 */
+		io_awaiter<receive_from_op<udp>>
+		async_receive(executor&, void*, std::size_t, endpoint&, Error&) noexcept;
+		io_awaiter<send_to_op<udp>>
+		async_send(executor&, const void*, std::size_t, endpoint&, Error&) noexcept;
+#endif /* SOCA_USE_COROUTINE == 1 && SOCA_USE_SELECT != 1 */
 	private:
+		bool try_receive(void*, std::size_t, endpoint&, std::size_t&, Error&) noexcept;
+
 		handler socket_;
+		socket_options options_ = Options::options();
+		spin_stats spin_;
 };
 
 }//POSIX
@@ -1,7 +1,10 @@
 #ifndef SOCA_POSIX_UNIX_HPP__
 #define SOCA_POSIX_UNIX_HPP__
 
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 
 #ifdef __EMSCRIPTEN__
@@ -12,4 +15,8 @@
 #include <unistd.h>
 #include <sys/epoll.h>
 
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif /* __linux__ */
+
 #endif /* SOCA_POSIX_UNIX_HPP__ */
@@ -0,0 +1,72 @@
+#ifndef SOCA_PROBE_HPP__
+#define SOCA_PROBE_HPP__
+
+/**
+ * USDT (static tracepoints) probes, provider "soca"
+ *
+ * Each probe is a single nop at the probe site, plus a .note.stapsdt
+ * ELF note describing it (same format as systemtap's sys/sdt.h), so
+ * tools as bpftrace, perf and systemtap can attach at runtime:
+ *
+ * bpftrace -e 'usdt:./tcp_server:soca:tcp_server_receive { @[arg0] = sum(arg1); }'
+ *
+ * All probes have the same arguments: arg0 fd, arg1 size (or the
+ * value returned, negative on error), arg2 error (errno, 0 if none;
+ * the mbedtls error at DTLS probes).
+ *
+ * Enabled by default on Linux x86_64/aarch64 (GCC/Clang). Define
+ * SOCA_USE_PROBES=0 to compile out.
+ */
+
+#if !defined(SOCA_USE_PROBES)
+#if defined(__linux__) && defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+#define SOCA_USE_PROBES		1
+#else
+#define SOCA_USE_PROBES		0
+#endif
+#endif /* !defined(SOCA_USE_PROBES) */
+
+#if SOCA_USE_PROBES == 1
+
+/**
+ * Arguments as signed 8 bytes ("-8@operand"); "nor": immediate, memory
+ * or register, wherever the value already is.
+ *
+ * _.stapsdt.base lets the tools adjust the probe address if the binary
+ * is prelinked.
+ */
+#define SOCA_PROBE(name, fd, size, error)										\
+	__asm__ __volatile__(														\
+		"990:	nop\n"															\
+		"		.pushsection .note.stapsdt,\"?\",\"note\"\n"					\
+		"		.balign 4\n"													\
+		"		.4byte 992f-991f, 994f-993f, 3\n"								\
+		"991:	.asciz \"stapsdt\"\n"											\
+		"992:	.balign 4\n"													\
+		"993:	.8byte 990b\n"													\
+		"		.8byte _.stapsdt.base\n"										\
+		"		.8byte 0\n"														\
+		"		.asciz \"soca\"\n"												\
+		"		.asciz \"" #name "\"\n"											\
+		"		.asciz \"-8@%0 -8@%1 -8@%2\"\n"									\
+		"994:	.balign 4\n"													\
+		"		.popsection\n"													\
+		"		.ifndef _.stapsdt.base\n"										\
+		"		.pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"	\
+		"		.weak _.stapsdt.base\n"											\
+		"		.hidden _.stapsdt.base\n"										\
+		"_.stapsdt.base: .space 1\n"											\
+		"		.size _.stapsdt.base, 1\n"										\
+		"		.popsection\n"													\
+		"		.endif\n"														\
+		:: "nor"(static_cast<long long>(fd)),									\
+		   "nor"(static_cast<long long>(size)),									\
+		   "nor"(static_cast<long long>(error)))
+
+#else /* SOCA_USE_PROBES == 1 */
+
+#define SOCA_PROBE(name, fd, size, error)		(void)0
+
+#endif /* SOCA_USE_PROBES == 1 */
+
+#endif /* SOCA_PROBE_HPP__ */
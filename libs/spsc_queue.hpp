@@ -0,0 +1,93 @@
+#ifndef SOCA_SPSC_QUEUE_HPP__
+#define SOCA_SPSC_QUEUE_HPP__
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <utility>
+
+#include "cache_line.hpp"
+
+namespace Soca{
+
+/**
+ * \brief Bounded lock-free single producer, single consumer queue
+ *
+ * Each side keeps a cached copy of the other side index, touching
+ * the shared cache line only when the cache says full/empty.
+ *
+ * \tparam T default constructible and move assignable
+ * \tparam Capacity power of 2
+ */
+template<typename T,
+		std::size_t Capacity>
+class spsc_queue{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+			"Capacity must be power of 2");
+	public:
+		spsc_queue() = default;
+		spsc_queue(spsc_queue const&) = delete;
+		spsc_queue& operator=(spsc_queue const&) = delete;
+
+		/**
+		 * Producer side. Returns false if full.
+		 */
+		bool push(T&& value) noexcept
+		{
+			std::size_t tail = tail_.load(std::memory_order_relaxed);
+			if(tail - head_cache_ == Capacity)
+			{
+				head_cache_ = head_.load(std::memory_order_acquire);
+				if(tail - head_cache_ == Capacity) return false;
+			}
+			buffer_[tail & (Capacity - 1)] = std::move(value);
+			tail_.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool push(T const& value) noexcept
+		{
+			T v{value};
+			return push(std::move(v));
+		}
+
+		/**
+		 * Consumer side. Returns false if empty.
+		 */
+		bool pop(T& value) noexcept
+		{
+			std::size_t head = head_.load(std::memory_order_relaxed);
+			if(head == tail_cache_)
+			{
+				tail_cache_ = tail_.load(std::memory_order_acquire);
+				if(head == tail_cache_) return false;
+			}
+			value = std::move(buffer_[head & (Capacity - 1)]);
+			head_.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * Approximated if called concurrently
+		 */
+		std::size_t size() const noexcept
+		{
+			return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+		}
+
+		bool empty() const noexcept{ return size() == 0; }
+		static constexpr std::size_t capacity() noexcept{ return Capacity; }
+	private:
+		/* consumer */
+		alignas(SOCA_CACHE_LINE_SIZE) std::atomic<std::size_t>	head_{0};
+		std::size_t												tail_cache_ = 0;
+		/* producer */
+		alignas(SOCA_CACHE_LINE_SIZE) std::atomic<std::size_t>	tail_{0};
+		std::size_t												head_cache_ = 0;
+
+		alignas(SOCA_CACHE_LINE_SIZE) T		buffer_[Capacity];
+};
+
+}//Soca
+
+#endif /* SOCA_SPSC_QUEUE_HPP__ */
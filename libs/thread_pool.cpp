@@ -0,0 +1,279 @@
+#include "thread_pool.hpp"
+
+namespace Soca{
+
+static std::size_t round_pow2(std::size_t value) noexcept
+{
+	std::size_t n = 2;
+	while(n < value) n <<= 1;
+	return n;
+}
+
+/*
+ * work_deque
+ *
+ * "Correct and Efficient Work-Stealing for Weak Memory Models",
+ * Lê, Pop, Cohen and Zappa Nardelli, 2013 (without resize).
+ */
+work_deque::work_deque(std::size_t capacity)
+	: top_(0), bottom_(0),
+	  buffer_(new std::atomic<job*>[round_pow2(capacity)]),
+	  mask_(static_cast<std::int64_t>(round_pow2(capacity)) - 1){}
+
+bool work_deque::push(job* j) noexcept
+{
+	std::int64_t b = bottom_.load(std::memory_order_relaxed);
+	std::int64_t t = top_.load(std::memory_order_acquire);
+	if(b - t > mask_) return false;
+
+	buffer_[b & mask_].store(j, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	bottom_.store(b + 1, std::memory_order_relaxed);
+	return true;
+}
+
+job* work_deque::pop() noexcept
+{
+	std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+	bottom_.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::int64_t t = top_.load(std::memory_order_relaxed);
+
+	if(t > b)
+	{
+		/* empty */
+		bottom_.store(b + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	job* j = buffer_[b & mask_].load(std::memory_order_relaxed);
+	if(t == b)
+	{
+		/* last element: race against thieves */
+		if(!top_.compare_exchange_strong(t, t + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed))
+			j = nullptr;
+		bottom_.store(b + 1, std::memory_order_relaxed);
+	}
+	return j;
+}
+
+job* work_deque::steal() noexcept
+{
+	std::int64_t t = top_.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	std::int64_t b = bottom_.load(std::memory_order_acquire);
+	if(t >= b) return nullptr;
+
+	job* j = buffer_[t & mask_].load(std::memory_order_relaxed);
+	if(!top_.compare_exchange_strong(t, t + 1,
+			std::memory_order_seq_cst, std::memory_order_relaxed))
+		return nullptr;
+	return j;
+}
+
+/*
+ * thread_pool
+ */
+struct thread_pool::worker{
+	explicit worker(std::size_t capacity) : deque(capacity){}
+
+	work_deque		deque;
+	std::thread		thread;
+};
+
+/**
+ * Pool and index of the worker running at this thread
+ */
+static thread_local thread_pool const* current_pool = nullptr;
+static thread_local unsigned current_index = 0;
+
+thread_pool::thread_pool(thread_pool_config const& config)
+	: config_(config)
+{
+	if(config_.threads == 0) config_.threads = 1;
+	config_.queue_depth = round_pow2(config_.queue_depth);
+
+	workers_.reset(new std::unique_ptr<worker>[config_.threads]);
+	for(unsigned i = 0; i < config_.threads; i++)
+		workers_[i].reset(new worker(config_.queue_depth));
+	inject_.reset(new job*[config_.queue_depth]);
+}
+
+thread_pool::~thread_pool()
+{
+	stop();
+}
+
+void thread_pool::start(Error& ec) noexcept
+{
+	stop_.store(false);
+	for(unsigned i = 0; i < config_.threads; i++)
+	{
+		try
+		{
+			workers_[i]->thread = std::thread(&thread_pool::work, this, i);
+		}
+		catch(...)
+		{
+			ec = errc::out_of_resources;
+			stop();
+			return;
+		}
+	}
+}
+
+void thread_pool::stop() noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock(park_mtx_);
+		stop_.store(true);
+	}
+	park_cv_.notify_all();
+	for(unsigned i = 0; i < config_.threads; i++)
+	{
+		if(workers_[i]->thread.joinable())
+			workers_[i]->thread.join();
+	}
+}
+
+unsigned thread_pool::size() const noexcept
+{
+	return config_.threads;
+}
+
+bool thread_pool::post(job* j) noexcept
+{
+	/* before the push: a worker may take the job (and decrement) at once */
+	pending_.fetch_add(1, std::memory_order_seq_cst);
+	bool ok = (current_pool == this && workers_[current_index]->deque.push(j))
+				|| inject(j);
+	if(!ok)
+	{
+		pending_.fetch_sub(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	wake();
+	return true;
+}
+
+void thread_pool::wake() noexcept
+{
+	if(sleeping_.load(std::memory_order_seq_cst) == 0) return;
+	std::lock_guard<std::mutex> lock(park_mtx_);
+	park_cv_.notify_one();
+}
+
+bool thread_pool::inject(job* j) noexcept
+{
+	std::lock_guard<std::mutex> lock(inject_mtx_);
+	if(inject_size_ == config_.queue_depth) return false;
+	inject_[(inject_head_ + inject_size_++) & (config_.queue_depth - 1)] = j;
+	return true;
+}
+
+job* thread_pool::inject_pop() noexcept
+{
+	std::lock_guard<std::mutex> lock(inject_mtx_);
+	if(inject_size_ == 0) return nullptr;
+	job* j = inject_[inject_head_];
+	inject_head_ = (inject_head_ + 1) & (config_.queue_depth - 1);
+	inject_size_--;
+	return j;
+}
+
+job* thread_pool::take(unsigned index) noexcept
+{
+	job* j = workers_[index]->deque.pop();
+	if(!j) j = inject_pop();
+	for(unsigned i = 1; !j && i < config_.threads; i++)
+		j = workers_[(index + i) % config_.threads]->deque.steal();
+	if(j) pending_.fetch_sub(1, std::memory_order_relaxed);
+	return j;
+}
+
+void thread_pool::work(unsigned index) noexcept
+{
+	current_pool = this;
+	current_index = index;
+
+	while(!stop_.load(std::memory_order_relaxed))
+	{
+		job* j = take(index);
+		if(j)
+		{
+			j->run(j);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(park_mtx_);
+		sleeping_.fetch_add(1, std::memory_order_seq_cst);
+		park_cv_.wait(lock, [this]{
+			return pending_.load(std::memory_order_seq_cst) != 0 || stop_.load();
+		});
+		sleeping_.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	current_pool = nullptr;
+}
+
+/*
+ * strand
+ */
+strand::strand(thread_pool& pool, unsigned batch /* = 16 */) noexcept
+	: pool_(pool), batch_(batch ? batch : 1)
+{
+	self_.run = &strand::run;
+	self_.self = this;
+}
+
+void strand::post(job* j) noexcept
+{
+	j->next = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(mtx_);
+		if(tail_) tail_->next = j;
+		else head_ = j;
+		tail_ = j;
+		if(running_) return;
+		running_ = true;
+	}
+	schedule();
+}
+
+void strand::schedule() noexcept
+{
+	/* Pool full: wait for the workers to free space */
+	while(!pool_.post(&self_)) std::this_thread::yield();
+}
+
+void strand::run(job* self) noexcept
+{
+	strand* s = static_cast<strand_job*>(self)->self;
+
+	do{
+		for(unsigned i = 0; i < s->batch_; i++)
+		{
+			job* j;
+			{
+				std::lock_guard<std::mutex> lock(s->mtx_);
+				j = s->head_;
+				if(!j)
+				{
+					s->running_ = false;
+					return;
+				}
+				s->head_ = j->next;
+				if(!s->head_) s->tail_ = nullptr;
+			}
+			j->run(j);
+		}
+		/**
+		 * Batch done: give way to other jobs. If the pool is full, keep
+		 * running (waiting here could block all workers).
+		 */
+	}while(!s->pool_.post(&s->self_));
+}
+
+}//Soca
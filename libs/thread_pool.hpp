@@ -0,0 +1,144 @@
+#ifndef SOCA_THREAD_POOL_HPP__
+#define SOCA_THREAD_POOL_HPP__
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <memory>
+
+#include "error.hpp"
+#include "cache_line.hpp"
+
+namespace Soca{
+
+/**
+ * \brief Unit of work of the thread pool
+ *
+ * Intrusive: users embed it (or derive) and recover their data
+ * at \p run. \p next is free to use while the job is not posted.
+ */
+struct job{
+	void	(*run)(job*) noexcept;
+	job*	next = nullptr;
+};
+
+/**
+ * \brief Bounded Chase-Lev work-stealing deque
+ *
+ * The owner thread pushes and pops at the bottom; other threads
+ * steal from the top.
+ */
+class work_deque{
+	public:
+		explicit work_deque(std::size_t capacity);
+
+		bool push(job*) noexcept;
+		job* pop() noexcept;
+		job* steal() noexcept;
+	private:
+		alignas(SOCA_CACHE_LINE_SIZE) std::atomic<std::int64_t>	top_;
+		alignas(SOCA_CACHE_LINE_SIZE) std::atomic<std::int64_t>	bottom_;
+		alignas(SOCA_CACHE_LINE_SIZE) std::unique_ptr<std::atomic<job*>[]> buffer_;
+		std::int64_t	mask_;
+};
+
+struct thread_pool_config{
+	/**
+	 * Number of worker threads
+	 */
+	unsigned		threads = 4;
+	/**
+	 * Capacity of each worker deque and of the queue of jobs posted
+	 * by non-worker threads (rounded up to power of 2)
+	 */
+	std::size_t		queue_depth = 1024;
+};
+
+/**
+ * \brief Work-stealing thread pool
+ *
+ * Jobs posted by a worker go to its own deque; jobs posted by other
+ * threads (e.g. the I/O thread) go to a shared queue. Idle workers
+ * steal from each other before sleeping.
+ */
+class thread_pool{
+	public:
+		explicit thread_pool(thread_pool_config const& = thread_pool_config{});
+		~thread_pool();
+
+		thread_pool(thread_pool const&) = delete;
+		thread_pool& operator=(thread_pool const&) = delete;
+
+		void start(Error&) noexcept;
+		/**
+		 * \brief Stops and joins the workers. Jobs not run are dropped.
+		 */
+		void stop() noexcept;
+
+		/**
+		 * \brief Posts a job. Returns false if the queue is full.
+		 */
+		bool post(job*) noexcept;
+
+		unsigned size() const noexcept;
+	private:
+		struct worker;
+
+		void work(unsigned index) noexcept;
+		job* take(unsigned index) noexcept;
+		bool inject(job*) noexcept;
+		job* inject_pop() noexcept;
+		void wake() noexcept;
+
+		thread_pool_config		config_;
+		std::unique_ptr<std::unique_ptr<worker>[]> workers_;
+
+		std::mutex				inject_mtx_;
+		std::unique_ptr<job*[]>	inject_;
+		std::size_t				inject_head_ = 0,
+								inject_size_ = 0;
+
+		alignas(SOCA_CACHE_LINE_SIZE) std::atomic<std::size_t>	pending_{0};
+		alignas(SOCA_CACHE_LINE_SIZE) std::atomic<unsigned>		sleeping_{0};
+		std::mutex				park_mtx_;
+		std::condition_variable	park_cv_;
+		std::atomic<bool>		stop_{false};
+};
+
+/**
+ * \brief Runs posted jobs one at a time, in post order
+ *
+ * At most \p batch jobs are run before the strand yields the worker
+ * to other jobs.
+ */
+class strand{
+	public:
+		explicit strand(thread_pool&, unsigned batch = 16) noexcept;
+
+		strand(strand const&) = delete;
+		strand& operator=(strand const&) = delete;
+
+		void post(job*) noexcept;
+	private:
+		struct strand_job : job{
+			strand*		self;
+		};
+
+		static void run(job*) noexcept;
+		void schedule() noexcept;
+
+		strand_job		self_;
+		thread_pool&	pool_;
+		unsigned		batch_;
+		std::mutex		mtx_;
+		job*			head_ = nullptr;
+		job*			tail_ = nullptr;
+		bool			running_ = false;
+};
+
+}//Soca
+
+#endif /* SOCA_THREAD_POOL_HPP__ */
@@ -0,0 +1,96 @@
+#ifndef SOCA_TIMER_WHEEL_HPP__
+#define SOCA_TIMER_WHEEL_HPP__
+
+#include <cstdlib>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Soca{
+
+/**
+ * \brief Hashed timer wheel
+ *
+ * Items are appended to the slot of its deadline tick: schedule is O(1),
+ * and advance() only visits the slots of the ticks elapsed. There is
+ * no cancel: items fire once, and the callback checks if they are
+ * still valid, or due (deadlines beyond the wheel span fire at the last
+ * slot, early: the callback schedules them again).
+ *
+ * \tparam T copyable (e.g. a index and a generation)
+ */
+template<typename T>
+class timer_wheel{
+	public:
+		/**
+		 * \param slots number of slots. The span is \p slots * \p tick_ns
+		 * \param tick_ns resolution
+		 * \param now_ns current time
+		 */
+		timer_wheel(std::size_t slots, std::uint64_t tick_ns, std::uint64_t now_ns)
+			: slots_(slots ? slots : 1),
+			  tick_ns_(tick_ns ? tick_ns : 1),
+			  current_(now_ns / tick_ns_){}
+
+		/**
+		 * \brief Returns false if the slot could not grow (item not scheduled)
+		 */
+		bool schedule(T const& item, std::uint64_t deadline_ns) noexcept
+		{
+			std::uint64_t tick = deadline_ns / tick_ns_;
+			if(tick <= current_) tick = current_ + 1;
+			else if(tick - current_ >= slots_.size()) tick = current_ + slots_.size() - 1;
+			if(tick == current_) tick++;	//single slot wheel
+			try{
+				slots_[tick % slots_.size()].push_back(item);
+			}catch(...)
+			{
+				return false;
+			}
+			size_++;
+			return true;
+		}
+
+		/**
+		 * \brief Calls \p func(T const&) for the items of the ticks up to
+		 * \p now_ns. \p func may schedule. Returns the number of items fired.
+		 */
+		template<typename Func>
+		std::size_t advance(std::uint64_t now_ns, Func&& func) noexcept
+		{
+			std::uint64_t target = now_ns / tick_ns_;
+			/* after a long pause, each slot once */
+			if(target > current_ && target - current_ > slots_.size())
+				current_ = target - slots_.size();
+
+			std::size_t fired = 0;
+			while(current_ < target)
+			{
+				current_++;
+				std::vector<T>& slot = slots_[current_ % slots_.size()];
+				if(slot.empty()) continue;
+
+				/* func may schedule to this slot (next turn) */
+				fired_.clear();
+				fired_.swap(slot);
+				size_ -= fired_.size();
+				for(T const& item : fired_)
+					func(item);
+				fired += fired_.size();
+			}
+			return fired;
+		}
+
+		std::size_t size() const noexcept{ return size_; }
+		std::uint64_t tick_ns() const noexcept{ return tick_ns_; }
+	private:
+		std::vector<std::vector<T>>	slots_;
+		std::vector<T>				fired_;		//reused, to keep the slots capacity
+		std::uint64_t				tick_ns_;
+		std::uint64_t				current_;	//last tick processed
+		std::size_t					size_ = 0;
+};
+
+}//Soca
+
+#endif /* SOCA_TIMER_WHEEL_HPP__ */